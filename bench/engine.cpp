@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <future>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "neural.hpp"
+#include "harness.hpp"
+
+/*
+Benchmark: dynamic batching of inference requests
+
+A synthetic load generator submits single-sample requests to nl::Engine
+with exponentially distributed gaps, i.e. an open loop with Poisson
+arrivals at a fixed rate. The rate is a fraction of the throughput of
+plain forward passes of the network, so the server is busy but not
+overloaded. Every configuration of batch size and deadline reports
+latency from submission to result at the 50th and 99th percentile,
+achieved throughput and the mean number of requests per batch.
+
+Usage: bench_engine [load] [--benchmark_out=file.json]
+  load  offered rate as a fraction of single-thread capacity, default 0.7
+*/
+
+typedef std::chrono::steady_clock Clock;
+
+const int requests = 2000;
+
+struct Config {
+    std::size_t batch;
+    int deadline_us;
+};
+
+double percentile(std::vector<double> values, double p) {
+    std::size_t k = std::min(values.size() - 1,
+                             std::size_t(p * values.size()));
+    std::nth_element(values.begin(), values.begin() + k, values.end());
+    return values[k];
+}
+
+int main(int argc, char *argv[])
+{
+    bench::Suite suite(argc, argv);
+
+    double load = 0.7;
+    if (!suite.arguments().empty())
+        load = std::stod(suite.arguments()[0]);
+
+    nl::block_ptr in = std::make_shared<nl::Block>("in", 256, 1, 1);
+    in->data.setRandom();
+    nl::Dense d1("d1", "relu", in, 1, 1, 512);
+    nl::Dense d2("d2", "relu", d1, 1, 1, 512);
+    nl::Dense d3("d3", "linear", d2, 1, 1, 10);
+    nl::Net net("net");
+    net.add(&d1);
+    net.add(&d2);
+    net.add(&d3);
+
+    // capacity of a single thread running one request at a time
+    net.forward();
+    auto start = Clock::now();
+    for (int r = 0; r < 200; ++r) {
+        net.forward();
+    }
+    double forward_s = std::chrono::duration<double>(
+        Clock::now() - start).count() / 200;
+    double rate = load / forward_s;
+    std::printf("forward %.1f us, offered %.0f requests/s\n",
+                forward_s * 1e6, rate);
+
+    std::vector<Config> configs = {{1, 0}, {8, 200}, {8, 1000}, {32, 2000}};
+    for (const Config & config : configs) {
+        std::string name = "Engine/batch:" + std::to_string(config.batch) +
+            "/deadline_us:" + std::to_string(config.deadline_us);
+        if (!suite.selected(name))
+            continue;
+
+        nl::Engine engine(net, "in", "d3_out");
+        engine.setBatchSize(config.batch);
+        engine.setDeadline(std::chrono::microseconds(config.deadline_us));
+        engine.submit(in->data).get();
+        std::size_t warm_batches = engine.batches();
+
+        // futures are collected in order of submission by another thread
+        std::vector<std::future<nl::Engine::Tensor>> results(requests);
+        std::vector<Clock::time_point> submitted(requests);
+        std::vector<double> latencies(requests);
+        std::vector<std::promise<void>> ready(requests);
+        std::thread collector([&] {
+            for (int r = 0; r < requests; ++r) {
+                ready[r].get_future().wait();
+                results[r].wait();
+                latencies[r] = std::chrono::duration<double>(
+                    Clock::now() - submitted[r]).count();
+            }
+        });
+
+        std::mt19937 random(42);
+        std::exponential_distribution<double> gap(rate);
+        start = Clock::now();
+        std::clock_t cpu_start = std::clock();
+        auto next = start;
+        for (int r = 0; r < requests; ++r) {
+            next += std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(gap(random)));
+            std::this_thread::sleep_until(next);
+            submitted[r] = Clock::now();
+            results[r] = engine.submit(in->data);
+            ready[r].set_value();
+        }
+        collector.join();
+        double cpu = double(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+        double seconds = std::chrono::duration<double>(
+            Clock::now() - start).count();
+        double batches = engine.batches() - warm_batches;
+
+        suite.report({name, std::size_t(requests), seconds / requests * 1e9,
+                      cpu / requests * 1e9,
+                      {{"items_per_second", requests / seconds},
+                       {"p50_us", percentile(latencies, 0.5) * 1e6},
+                       {"p99_us", percentile(latencies, 0.99) * 1e6},
+                       {"mean_batch", requests / batches}}});
+    }
+
+    return suite.finish();
+}
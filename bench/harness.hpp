@@ -0,0 +1,244 @@
+#ifndef NEURAL_LIB_BENCH_HARNESS_H
+#define NEURAL_LIB_BENCH_HARNESS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <regex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "op.hpp"
+
+/*
+Minimal microbenchmark harness shared by all benchmark programs.
+
+Command line flags and the JSON output follow Google Benchmark so that
+existing tools for comparing its results work with these files as well:
+
+  --benchmark_filter=<regex>     run only benchmarks whose name matches
+  --benchmark_min_time=<seconds> minimal measured time of each benchmark
+  --benchmark_out=<file>         also write results as JSON into file
+
+Other arguments are left to the program, see Suite::arguments().
+*/
+
+namespace bench {
+
+    /// Result of a single benchmark.
+    struct Result {
+        std::string name;
+        /// number of measured iterations
+        std::size_t iterations;
+        /// mean wall time of an iteration in nanoseconds
+        double real_time;
+        /// mean process CPU time of an iteration in nanoseconds
+        double cpu_time;
+        /// rates and other values reported next to the time
+        std::vector<std::pair<std::string, double>> counters;
+    };
+
+    ///
+    /// Runs benchmarks selected on the command line, prints them as
+    /// a table and collects them for the JSON output.
+    ///
+    class Suite {
+    public:
+        /// Constructor, parses the command line.
+        Suite(int argc, char* argv[]): executable(argv[0]) {
+            for (int i = 1; i < argc; ++i) {
+                std::string arg = argv[i];
+                if (flag(arg, "--benchmark_filter=", filter) ||
+                    flag(arg, "--benchmark_out=", out))
+                    continue;
+                if (arg.compare(0, 21, "--benchmark_min_time=") == 0) {
+                    // "0.5" and "0.5s" are both accepted
+                    min_time = std::stod(arg.substr(21));
+                } else if (arg.compare(0, 2, "--") == 0) {
+                    std::cerr << "unknown flag " << arg << std::endl;
+                    std::exit(1);
+                } else {
+                    positional.push_back(arg);
+                }
+            }
+            std::printf("%-44s %14s %14s %10s\n",
+                        "Benchmark", "Time", "CPU", "Iterations");
+        }
+
+        /// Arguments that are not flags of the harness.
+        const std::vector<std::string> & arguments() const {
+            return positional;
+        }
+
+        /// true iff benchmark of given name was selected to run
+        bool selected(const std::string & name) const {
+            return std::regex_search(name, std::regex(filter));
+        }
+
+        ///
+        /// Call 'f' repeatedly until at least the minimal time passes and
+        /// report mean time of a call.
+        /// @param name name of the benchmark
+        /// @param f measured code
+        /// @param cost work done by a single call, reported as
+        /// flops_per_second and bytes_per_second
+        /// @param items number of processed items in a single call,
+        /// reported as items_per_second
+        /// @param counters other values reported as they are
+        /// @return mean wall time of a call in nanoseconds, 0 if the
+        /// benchmark was not selected
+        ///
+        double run(const std::string & name, const std::function<void()> & f,
+                 nl::Cost cost=nl::Cost(), double items=0,
+                 const std::vector<std::pair<std::string, double>> & counters={}) {
+
+            if (!selected(name))
+                return 0;
+
+            // warm up caches and lazily allocated buffers
+            f();
+
+            std::size_t n = 1;
+            double real, cpu;
+            while (true) {
+                auto start = std::chrono::steady_clock::now();
+                std::clock_t cpu_start = std::clock();
+                for (std::size_t i = 0; i < n; ++i)
+                    f();
+                cpu = double(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+                real = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start).count();
+                if (real >= min_time || n >= max_iterations)
+                    break;
+                // aim slightly above the minimal time, grow at most 10x
+                double factor = 1.4 * min_time / std::max(real, 1e-9);
+                n = std::min<std::size_t>(max_iterations,
+                    std::ceil(n * std::max(1.1, std::min(10.0, factor))));
+            }
+
+            Result r{name, n, real / n * 1e9, cpu / n * 1e9, {}};
+            if (cost.flops > 0)
+                r.counters.push_back({"flops_per_second", cost.flops * n / real});
+            if (cost.bytes() > 0)
+                r.counters.push_back({"bytes_per_second", cost.bytes() * n / real});
+            if (items > 0)
+                r.counters.push_back({"items_per_second", items * n / real});
+            r.counters.insert(r.counters.end(), counters.begin(), counters.end());
+            report(r);
+            return r.real_time;
+        }
+
+        /// Report result measured by the program itself.
+        void report(const Result & r) {
+            if (!selected(r.name))
+                return;
+
+            std::printf("%-44s %11.0f ns %11.0f ns %10zu",
+                        r.name.c_str(), r.real_time, r.cpu_time, r.iterations);
+            for (auto & c : r.counters) {
+                std::printf(" %s=%s", c.first.c_str(),
+                            format(c.first, c.second).c_str());
+            }
+            std::printf("\n");
+            std::fflush(stdout);
+            results.push_back(r);
+        }
+
+        /// Write JSON output, if requested. Returns exit code of the program.
+        int finish() {
+            if (out.empty())
+                return 0;
+
+            std::ofstream f(out);
+            if (!f) {
+                std::cerr << "cannot write " << out << std::endl;
+                return 1;
+            }
+
+            char date[32];
+            std::time_t now = std::time(nullptr);
+            std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z",
+                          std::localtime(&now));
+
+            f << "{\n  \"context\": {\n"
+              << "    \"date\": \"" << date << "\",\n"
+              << "    \"executable\": \"" << escape(executable) << "\",\n"
+              << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+              << "    \"library_build_type\": \"release\"\n"
+              << "  },\n  \"benchmarks\": [";
+            for (std::size_t i = 0; i < results.size(); ++i) {
+                const Result & r = results[i];
+                f << (i ? "," : "") << "\n    {\n"
+                  << "      \"name\": \"" << escape(r.name) << "\",\n"
+                  << "      \"run_name\": \"" << escape(r.name) << "\",\n"
+                  << "      \"run_type\": \"iteration\",\n"
+                  << "      \"iterations\": " << r.iterations << ",\n"
+                  << "      \"real_time\": " << r.real_time << ",\n"
+                  << "      \"cpu_time\": " << r.cpu_time << ",\n"
+                  << "      \"time_unit\": \"ns\"";
+                for (auto & c : r.counters) {
+                    f << ",\n      \"" << escape(c.first) << "\": " << c.second;
+                }
+                f << "\n    }";
+            }
+            f << "\n  ]\n}" << std::endl;
+            return 0;
+        }
+
+    private:
+        /// If 'arg' starts with 'prefix', store the rest in 'value'.
+        static bool flag(const std::string & arg, const std::string & prefix,
+                         std::string & value) {
+            if (arg.compare(0, prefix.size(), prefix) != 0)
+                return false;
+            value = arg.substr(prefix.size());
+            return true;
+        }
+
+        /// Escape string so that it can be used in JSON.
+        static std::string escape(const std::string & s) {
+            std::string ret;
+            for (char c : s) {
+                if (c == '"' || c == '\\')
+                    ret += '\\';
+                ret += c;
+            }
+            return ret;
+        }
+
+        /// Format counter, rates get a metric prefix, e.g. 1.5G/s.
+        static std::string format(const std::string & name, double v) {
+            const char* prefixes[] = {"", "k", "M", "G", "T"};
+            bool rate = name.size() > 11 &&
+                name.compare(name.size() - 11, 11, "_per_second") == 0;
+            std::size_t p = 0;
+            while (rate && v >= 1000 && p < 4) {
+                v /= 1000;
+                p++;
+            }
+            char buffer[32];
+            std::snprintf(buffer, sizeof(buffer), "%.4g%s%s", v, prefixes[p],
+                          rate ? "/s" : "");
+            return buffer;
+        }
+
+        /// upper bound on iterations of a single benchmark
+        static const std::size_t max_iterations = 1000000000;
+        std::string executable;
+        std::string filter = ".";
+        std::string out;
+        double min_time = 0.5;
+        std::vector<std::string> positional;
+        std::vector<Result> results;
+    };
+
+} // namespace bench
+
+#endif // NEURAL_LIB_BENCH_HARNESS_H
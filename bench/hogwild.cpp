@@ -0,0 +1,118 @@
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "neural.hpp"
+#include "harness.hpp"
+
+/*
+Benchmark: Hogwild training
+
+Measures training throughput (samples per second) of a wide linear model
+on sparse inputs depending on the number of Hogwild threads, and reports
+error of the trained model so that throughput can be compared with
+convergence. Only a few of the inputs of each sample are non-zero.
+
+Usage: bench_hogwild [max_threads] [--benchmark_out=file.json]
+*/
+
+const uint16_t features = 128;
+const uint16_t active = 6;
+const uint16_t samples = 1024;
+const uint16_t cycles = 4096;
+const char * data_file = "bench_hogwild_data.csv";
+
+void generate_data() {
+    std::ofstream f(data_file);
+    for (uint16_t i = 0; i < samples; ++i) {
+        std::vector<float> x(features, 0);
+        float sum = 0;
+        for (uint16_t j = 0; j < active; ++j) {
+            uint16_t pos = (nl::Generator::get() + 1) / 2 * (features - 1);
+            x[pos] = nl::Generator::get();
+            sum += (pos % 2 ? x[pos] : -x[pos]);
+        }
+        for (auto v : x)
+            f << v << ",";
+        f << (sum > 0 ? 1 : -1) << std::endl;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    bench::Suite suite(argc, argv);
+
+    uint16_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    if (!suite.arguments().empty())
+        max_threads = std::stoi(suite.arguments()[0]);
+
+    generate_data();
+
+    double base = 0;
+    for (uint16_t t = 1; t <= max_threads; t *= 2) {
+
+        nl::CsvReader r("reader", data_file);
+        nl::Dense sep_input("input", "linear", r, 1, 1, features);
+        nl::Dense sep_corr("correct", "linear", r, 1, 1, 1);
+
+        // let the separators only copy values
+        nl::block_ptr w = sep_input.inputs()["input_w"];
+        nl::block_ptr thr = sep_input.inputs()["input_thr"];
+        w->data.setZero();
+        thr->data.setZero();
+        w->trainable = thr->trainable = false;
+        for (uint16_t i = 0; i < features; ++i)
+            w->data(0,0,i + (features + 1) * i) = 1;
+        w = sep_corr.inputs()["correct_w"];
+        thr = sep_corr.inputs()["correct_thr"];
+        w->data.setZero();
+        thr->data.setZero();
+        w->trainable = thr->trainable = false;
+        w->data(0,0,features) = 1;
+
+        nl::Dense l("l", "tanh", sep_input, 1, 1, 1);
+
+        nl::Net net("net");
+        net.add(&r);
+        net.add(&sep_input);
+        net.add(&sep_corr);
+        net.add(&l);
+
+        nl::Solver solver(net, l.outputs()["l_out"],
+                          sep_corr.outputs()["correct_out"]);
+        solver.setHogwild(t);
+
+        auto start = std::chrono::steady_clock::now();
+        std::clock_t cpu_start = std::clock();
+        solver.train(cycles);
+        double cpu = double(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+        auto end = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+
+        // mean error over the whole data set
+        solver.setHogwild(1);
+        std::vector<nl::block_ptr> output = {l.outputs()["l_out"]};
+        std::vector<nl::block_ptr> desired = {sep_corr.outputs()["correct_out"]};
+        float error = 0;
+        for (uint16_t i = 0; i < samples; ++i) {
+            net.forward();
+            error += nl::Error::L2(output, desired);
+        }
+
+        double throughput = cycles / seconds;
+        if (t == 1)
+            base = throughput;
+        suite.report({"Hogwild/train/threads:" + std::to_string(t),
+                      cycles, seconds / cycles * 1e9, cpu / cycles * 1e9,
+                      {{"items_per_second", throughput},
+                       {"speedup", throughput / base},
+                       {"error", error / samples}}});
+    }
+
+    std::remove(data_file);
+    return suite.finish();
+}
@@ -0,0 +1,117 @@
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/archive/text_oarchive.hpp>
+
+#include "neural.hpp"
+#include "serialization.hpp"
+#include "harness.hpp"
+
+/*
+Benchmark: input and serialization
+
+Measures reading lines of a csv file with nl::CsvReader, reading images
+with nl::ImgReader and saving and loading a network through a text
+archive of boost::serialization. Input files are generated into
+the working directory and removed afterwards.
+
+Usage: bench_io [--benchmark_filter=...] [--benchmark_out=file.json]
+*/
+
+const nl::index_t csv_lines = 1024;
+const nl::index_t csv_columns = 64;
+const nl::index_t images = 16;
+const nl::index_t image_size = 64;
+const char * csv_file = "bench_io_data.csv";
+const char * list_file = "bench_io_images.txt";
+
+std::string image_file(nl::index_t i) {
+    return "bench_io_image" + std::to_string(i) + ".bmp";
+}
+
+void generate_data() {
+    std::ofstream csv(csv_file);
+    for (nl::index_t i = 0; i < csv_lines; ++i) {
+        for (nl::index_t j = 0; j < csv_columns; ++j) {
+            csv << (j ? "," : "") << nl::Generator::get();
+        }
+        csv << std::endl;
+    }
+
+    std::ofstream list(list_file);
+    for (nl::index_t i = 0; i < images; ++i) {
+        cimg_library::CImg<unsigned char> img(image_size, image_size, 1, 3);
+        img.rand(0, 255);
+        img.save_bmp(image_file(i).c_str());
+        list << image_file(i) << std::endl;
+    }
+}
+
+void remove_data() {
+    std::remove(csv_file);
+    std::remove(list_file);
+    for (nl::index_t i = 0; i < images; ++i) {
+        std::remove(image_file(i).c_str());
+    }
+}
+
+void serialization(bench::Suite & suite) {
+    nl::block_ptr in = std::make_shared<nl::Block>("in", 1, 1, 256);
+    nl::Dense l1("l1", "tanh", in, 1, 1, 256);
+    nl::Dense l2("l2", "tanh", l1, 1, 1, 10);
+    nl::Net net("net");
+    net.add(&l1);
+    net.add(&l2);
+    in->data.setRandom();
+    net.forward();
+
+    std::string archive;
+    suite.run("Serialization/save/mlp", [&] {
+            std::ostringstream oss;
+            {
+                boost::archive::text_oarchive oa(oss);
+                oa << net;
+            }
+            archive = oss.str();
+        }, nl::Cost(), 1);
+
+    suite.run("Serialization/load/mlp", [&] {
+            std::istringstream iss(archive);
+            boost::archive::text_iarchive ia(iss);
+            nl::Net loaded("loaded");
+            ia >> loaded;
+            // loaded ops are owned by the caller
+            for (auto & op_pair : loaded.ops) {
+                delete op_pair.second;
+            }
+        }, nl::Cost(), 1);
+}
+
+int main(int argc, char *argv[])
+{
+    bench::Suite suite(argc, argv);
+
+    generate_data();
+
+    {
+        nl::CsvReader r("reader", csv_file);
+        suite.run("CsvReader/" + std::to_string(csv_columns),
+                  [&] { r.forward(); }, r.forward_cost(), 1);
+    }
+
+    {
+        nl::ImgReader r("reader", list_file);
+        suite.run("ImgReader/" + std::to_string(image_size) + "x" +
+                  std::to_string(image_size), [&] { r.forward(); },
+                  r.forward_cost(), 1);
+    }
+
+    serialization(suite);
+
+    remove_data();
+    return suite.finish();
+}
@@ -0,0 +1,95 @@
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "neural.hpp"
+#include "harness.hpp"
+
+/*
+Benchmark: networks and solvers
+
+Net/build measures adding a chain of dense layers to a network and
+computing its ordering. Solver/step measures a single training cycle
+(forward pass, backward pass and weight update) of a multilayer
+perceptron and of a small convolutional network on a fixed random
+sample, the latter also with convolution and pooling fused by
+nl::Net::fuse().
+
+Usage: bench_net [--benchmark_filter=...] [--benchmark_out=file.json]
+*/
+
+nl::block_ptr random_block(const std::string & name,
+                           nl::index_t d, nl::index_t w, nl::index_t h) {
+    nl::block_ptr b = std::make_shared<nl::Block>(name, d, w, h);
+    b->data.setRandom();
+    return b;
+}
+
+void build(bench::Suite & suite, std::size_t layers) {
+    std::vector<std::unique_ptr<nl::Dense>> chain;
+    nl::block_ptr input = random_block("in", 1, 1, 16);
+    for (std::size_t i = 0; i < layers; ++i) {
+        std::string name = "l" + std::to_string(i);
+        if (i == 0)
+            chain.emplace_back(new nl::Dense(name, "relu", input, 1, 1, 16));
+        else
+            chain.emplace_back(new nl::Dense(name, "relu", *chain.back(), 1, 1, 16));
+    }
+
+    suite.run("Net/build/" + std::to_string(layers), [&] {
+            nl::Net net("net");
+            for (auto & op : chain) {
+                net.add(op.get());
+            }
+            net.get_ordering();
+        }, nl::Cost(), layers);
+}
+
+// single training cycle of net, one sample per cycle
+void step(bench::Suite & suite, const std::string & name, nl::Net & net,
+          nl::block_ptr output) {
+    nl::block_ptr desired = random_block("desired", output->dimensions()[0],
+        output->dimensions()[1], output->dimensions()[2]);
+    nl::Solver solver(net, output, desired);
+
+    nl::Cost cost = net.forward_cost();
+    cost += net.backward_cost();
+    suite.run("Solver/step/" + name, [&] { solver.train(1); }, cost, 1);
+}
+
+int main(int argc, char *argv[])
+{
+    bench::Suite suite(argc, argv);
+
+    for (std::size_t layers : {16, 128}) {
+        build(suite, layers);
+    }
+
+    {
+        nl::Dense l1("l1", "tanh", random_block("in", 1, 1, 64), 1, 1, 128);
+        nl::Dense l2("l2", "tanh", l1, 1, 1, 128);
+        nl::Dense l3("l3", "linear", l2, 1, 1, 10);
+        nl::Net net("mlp");
+        net.add(&l1);
+        net.add(&l2);
+        net.add(&l3);
+        step(suite, "mlp", net, l3.outputs()["l3_out"]);
+    }
+
+    // convolution and pooling computed separately and fused
+    for (bool fused : {false, true}) {
+        nl::Conv c("c", "relu", random_block("in", 1, 16, 16), 4, 3, 1);
+        nl::MaxPool p("p", c, 2);
+        nl::Dense d("d", "linear", p, 1, 1, 10);
+        nl::Net net("cnn");
+        net.add(&c);
+        net.add(&p);
+        net.add(&d);
+        if (fused)
+            net.fuse();
+        step(suite, fused ? "cnn_fused" : "cnn", net, d.outputs()["d_out"]);
+    }
+
+    return suite.finish();
+}
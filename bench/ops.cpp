@@ -0,0 +1,188 @@
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "neural.hpp"
+#include "harness.hpp"
+
+/*
+Benchmark: forward and backward pass of individual ops
+
+Every op is measured on a few representative input shapes. Inputs and
+output gradient are random. ConvPool compares a convolution followed by
+max pooling as two ops with the same pair fused into one. Reported rates are derived from the
+analytic cost of the op, see nl::Op::forward_cost().
+
+Usage: bench_ops [--benchmark_filter=...] [--benchmark_out=file.json]
+*/
+
+nl::block_ptr random_block(const std::string & name,
+                           nl::index_t d, nl::index_t w, nl::index_t h) {
+    nl::block_ptr b = std::make_shared<nl::Block>(name, d, w, h);
+    b->data.setRandom();
+    return b;
+}
+
+// measure both passes of op, output gradient is set to random values
+void measure(bench::Suite & suite, nl::Op & op, const std::string & name) {
+    for (auto & block_pair : op.outputs()) {
+        block_pair.second->grad.setRandom();
+    }
+    suite.run(name + "/forward", [&] { op.forward(); }, op.forward_cost());
+    suite.run(name + "/backward", [&] { op.backward(); }, op.backward_cost());
+}
+
+std::string shape(nl::index_t d, nl::index_t w, nl::index_t h) {
+    return std::to_string(d) + "x" + std::to_string(w) + "x" + std::to_string(h);
+}
+
+int main(int argc, char *argv[])
+{
+    bench::Suite suite(argc, argv);
+
+    // inputs x outputs
+    std::vector<std::pair<nl::index_t, nl::index_t>> dense_shapes = {
+        {64, 64}, {256, 256}, {1024, 128}
+    };
+    for (auto & s : dense_shapes) {
+        nl::Dense op("dense", "relu", random_block("in", 1, 1, s.first),
+                     1, 1, s.second);
+        measure(suite, op, "Dense/" + std::to_string(s.first) + "x" +
+                std::to_string(s.second));
+    }
+
+    // weights larger than caches, forward pass is bound by memory
+    // bandwidth and 16-bit weights move half of the bytes
+    {
+        nl::block_ptr in = random_block("in", 1, 1, 4096);
+        nl::Dense op("dense", "relu", in, 1, 1, 1024);
+        std::vector<std::pair<std::string, nl::Precision>> precisions = {
+            {"fp32", nl::FP32}, {"fp16", nl::FP16}, {"bf16", nl::BF16}
+        };
+        for (auto & p : precisions) {
+            op.setPrecision(p.second, p.second);
+            in->setPrecision(p.second);
+            suite.run("Dense/4096x1024/forward/" + p.first,
+                      [&] { op.forward(); }, op.forward_cost());
+        }
+    }
+
+    // pruned weights, dense and sparse kernels at the same density
+    for (float density : {0.5f, 0.3f, 0.2f, 0.1f, 0.05f}) {
+        nl::Dense op("dense", "relu", random_block("in", 1, 1, 1024), 1, 1, 1024);
+        nl::Net net("net");
+        net.add(&op);
+        nl::Pruner(net).keep(density * 1024 * 1024);
+        char name[64];
+        std::snprintf(name, sizeof(name), "Dense/1024x1024/density:%.2f", density);
+        for (float crossover : {0.0f, 1.0f}) {
+            op.setCrossover(crossover);
+            measure(suite, op, std::string(name) + (crossover > 0 ? "/sparse" : "/dense"));
+        }
+    }
+
+    // input shape, output depth, window, padding, groups
+    struct ConvShape { nl::index_t d, w, h, depth, window, padding, groups; };
+    std::vector<ConvShape> conv_shapes = {
+        {1, 28, 28, 8, 3, 1, 1}, {8, 32, 32, 16, 3, 1, 1}, {3, 64, 64, 8, 5, 2, 1},
+        {3, 64, 64, 8, 9, 4, 1}, {32, 32, 32, 32, 3, 1, 32}, {32, 32, 32, 64, 1, 0, 1}
+    };
+    for (auto & s : conv_shapes) {
+        nl::Conv op("conv", "relu", random_block("in", s.d, s.w, s.h),
+                    s.depth, s.window, s.padding, 1, s.groups);
+        measure(suite, op, "Conv/" + shape(s.d, s.w, s.h) + "/d" +
+                std::to_string(s.depth) + "k" + std::to_string(s.window) +
+                "g" + std::to_string(s.groups));
+    }
+
+    // computing window by window, lowering windows for matrix
+    // multiplication, Winograd and FFT, which decide the rules of "auto"
+    for (nl::index_t window : {2, 3, 4, 5, 7}) {
+        for (std::string algorithm : {"direct", "im2col", "winograd", "fft"}) {
+            if (algorithm == "winograd" && window != 3)
+                continue;
+            nl::Conv op("conv", "relu", random_block("in", 8, 32, 32),
+                        8, window, window / 2);
+            op.setAlgorithm(algorithm);
+            measure(suite, op, "Conv/8x32x32/d8k" + std::to_string(window) +
+                    "/" + algorithm);
+        }
+    }
+
+    // direct kernels compiled for the shape against the generic ones,
+    // and against lowering which "auto" picks for these shapes
+    struct FixedShape { nl::index_t window, padding, stride; };
+    for (FixedShape s : std::vector<FixedShape>{{3, 1, 1}, {5, 2, 1}, {3, 1, 2}}) {
+        nl::Conv op("conv", "relu", random_block("in", 8, 33, 33), 8,
+                    s.window, s.padding, s.stride);
+        std::string name = "Conv/8x33x33/d8k" + std::to_string(s.window) +
+            "s" + std::to_string(s.stride) + "/";
+        op.setAlgorithm("direct");
+        for (bool specialized : {false, true}) {
+            nl::Conv::setSpecialized(specialized);
+            measure(suite, op, name + "direct/" +
+                    (specialized ? "specialized" : "generic"));
+        }
+        for (std::string algorithm : {"im2col", "auto"}) {
+            op.setAlgorithm(algorithm);
+            measure(suite, op, name + algorithm);
+        }
+    }
+    for (nl::index_t window : {2, 3}) {
+        nl::MaxPool op("pool", random_block("in", 16, 33, 33), window, 0,
+                       window == 2 ? 1 : 2);
+        std::string name = "MaxPool/16x33x33/k" + std::to_string(window) + "/";
+        for (bool specialized : {false, true}) {
+            nl::MaxPool::setSpecialized(specialized);
+            suite.run(name + (specialized ? "specialized" : "generic"),
+                      [&] { op.forward(); }, op.forward_cost());
+        }
+    }
+
+    // input shape, window, padding, stride
+    struct PoolShape { nl::index_t d, w, h, window, padding, stride; };
+    std::vector<PoolShape> pool_shapes = {
+        {8, 28, 28, 2, 0, 1}, {16, 32, 32, 3, 1, 1}, {16, 32, 32, 2, 0, 2},
+        {16, 32, 32, 4, 0, 1}, {16, 32, 32, 9, 4, 1}
+    };
+    for (auto & s : pool_shapes) {
+        nl::MaxPool op("pool", random_block("in", s.d, s.w, s.h),
+                       s.window, s.padding, s.stride);
+        measure(suite, op, "MaxPool/" + shape(s.d, s.w, s.h) + "/k" +
+                std::to_string(s.window) + "s" + std::to_string(s.stride));
+    }
+
+    // convolution followed by pooling, as separate ops and fused by
+    // nl::Net::fuse()
+    {
+        nl::Conv conv("conv", "relu", random_block("in", 16, 32, 32), 32, 3, 1);
+        nl::MaxPool pool("pool", conv, 2, 0, 2);
+        for (bool fused : {false, true}) {
+            nl::Net net("net");
+            net.add(&conv);
+            net.add(&pool);
+            if (fused)
+                net.fuse();
+            measure(suite, net, std::string("ConvPool/16x32x32/d32k3/pool2s2/") +
+                    (fused ? "fused" : "unfused"));
+        }
+    }
+
+    for (nl::index_t n : {10, 100, 1000}) {
+        nl::Softmax op("softmax", random_block("in", 1, 1, n));
+        measure(suite, op, "Softmax/" + std::to_string(n));
+    }
+
+    for (std::size_t n : {1, 16}) {
+        std::vector<nl::block_ptr> inputs;
+        for (std::size_t i = 0; i < n; ++i) {
+            inputs.push_back(random_block("in" + std::to_string(i), 1, 1, 1));
+        }
+        nl::Neuron op("neuron", "sigmoid", inputs);
+        measure(suite, op, "Neuron/" + std::to_string(n));
+    }
+
+    return suite.finish();
+}
@@ -0,0 +1,119 @@
+
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <tuple>
+
+#include "neural.hpp"
+#include "harness.hpp"
+
+/*
+Benchmark: data-parallel training
+
+Measures how long it takes to train a single epoch of a small multilayer
+network with nl::ParallelSolver depending on the number of threads.
+Samples are generated into a temporary csv file, each line holding 
+'features' inputs followed by a single desired output. As in example2,
+reader output is split into network input and desired output by two
+dense layers with static weights.
+
+Every replica processes 'batch' samples per update, so the number of
+updates in an epoch decreases with the number of threads.
+
+Usage: bench_parallel [max_threads] [--benchmark_out=file.json]
+*/
+
+const uint16_t features = 32;
+const uint16_t hidden = 64;
+const uint16_t samples = 2048;
+const uint16_t batch = 8;
+const char * data_file = "bench_parallel_data.csv";
+
+void generate_data() {
+    std::ofstream f(data_file);
+    for (uint16_t i = 0; i < samples; ++i) {
+        float sum = 0;
+        for (uint16_t j = 0; j < features; ++j) {
+            float x = nl::Generator::get();
+            sum += (j % 2 ? x : -x);
+            f << x << ",";
+        }
+        f << (sum > 0 ? 1 : -1) << std::endl;
+    }
+}
+
+// wall and CPU time of a single training epoch in milliseconds
+std::pair<double, double> epoch_time(uint16_t threads) {
+
+    nl::CsvReader r("reader", data_file);
+    nl::Dense sep_input("input", "linear", r, 1, 1, features);
+    nl::Dense sep_corr("correct", "linear", r, 1, 1, 1);
+
+    // let the separators only copy values
+    nl::block_ptr w = sep_input.inputs()["input_w"];
+    nl::block_ptr thr = sep_input.inputs()["input_thr"];
+    w->data.setZero();
+    thr->data.setZero();
+    w->trainable = thr->trainable = false;
+    for (uint16_t i = 0; i < features; ++i)
+        w->data(0,0,i + (features + 1) * i) = 1;
+
+    w = sep_corr.inputs()["correct_w"];
+    thr = sep_corr.inputs()["correct_thr"];
+    w->data.setZero();
+    thr->data.setZero();
+    w->trainable = thr->trainable = false;
+    w->data(0,0,features) = 1;
+
+    nl::Dense l1("l1", "tanh", sep_input, 1, 1, hidden);
+    nl::Dense l2("l2", "tanh", l1, 1, 1, 1);
+
+    nl::Net net("net");
+    net.add(&r);
+    net.add(&sep_input);
+    net.add(&sep_corr);
+    net.add(&l1);
+    net.add(&l2);
+
+    nl::ParallelSolver solver(net, l2.outputs()["l2_out"],
+                              sep_corr.outputs()["correct_out"], threads);
+    solver.setBatchSize(batch);
+
+    auto start = std::chrono::steady_clock::now();
+    std::clock_t cpu_start = std::clock();
+    solver.train(samples / (batch * threads));
+    double cpu = 1e3 * (std::clock() - cpu_start) / CLOCKS_PER_SEC;
+    auto end = std::chrono::steady_clock::now();
+
+    return {std::chrono::duration<double, std::milli>(end - start).count(), cpu};
+}
+
+int main(int argc, char *argv[])
+{
+    bench::Suite suite(argc, argv);
+
+    uint16_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    if (!suite.arguments().empty())
+        max_threads = std::stoi(suite.arguments()[0]);
+
+    generate_data();
+
+    double base = 0;
+    for (uint16_t t = 1; t <= max_threads; t *= 2) {
+        double time, cpu;
+        std::tie(time, cpu) = epoch_time(t);
+        if (t == 1)
+            base = time;
+        suite.report({"ParallelSolver/epoch/threads:" + std::to_string(t),
+                      1, time * 1e6, cpu * 1e6,
+                      {{"items_per_second", samples / time * 1e3},
+                       {"speedup", base / time}}});
+    }
+
+    std::remove(data_file);
+    return suite.finish();
+}
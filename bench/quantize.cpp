@@ -0,0 +1,161 @@
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "neural.hpp"
+#include "harness.hpp"
+
+/*
+Benchmark: int8 quantized inference
+
+Forward pass of Dense and Conv is measured in float and after
+quantization by nl::Quantizer, calibrated on the measured input. The
+int8 result reports speedup over float and the largest difference of
+outputs as max_error.
+
+Mlp measures a whole model: a multilayer perceptron is calibrated on
+samples read from a generated csv file by nl::CsvReader, then outputs
+of the float and quantized model on all samples are compared. Reported
+are max_error and top1_agreement, the share of samples whose largest
+output is the same. The csv file is removed afterwards.
+
+Usage: bench_quantize [--benchmark_filter=...] [--benchmark_out=file.json]
+*/
+
+const nl::index_t samples = 256;
+const nl::index_t features = 256;
+const char * csv_file = "bench_quantize_data.csv";
+
+nl::block_ptr random_block(const std::string & name,
+                           nl::index_t d, nl::index_t w, nl::index_t h) {
+    nl::block_ptr b = std::make_shared<nl::Block>(name, d, w, h);
+    b->data.setRandom();
+    return b;
+}
+
+float max_error(const Eigen::Tensor<float, 3> & a, const Eigen::Tensor<float, 3> & b) {
+    Eigen::Tensor<float, 0> m = (a - b).abs().maximum();
+    return m();
+}
+
+// float and quantized forward pass of a single op
+void compare(bench::Suite & suite, const std::string & name, nl::Op & op) {
+    nl::Net net(name);
+    net.add(&op);
+    nl::block_ptr out = op.outputs().begin()->second;
+
+    net.forward();
+    Eigen::Tensor<float, 3> expected = out->data;
+    nl::Cost cost = op.forward_cost();
+    double time = suite.run(name + "/float", [&] { net.forward(); }, cost);
+
+    nl::Quantizer quantizer(net);
+    quantizer.calibrate();
+    quantizer.quantize();
+    net.forward();
+    double error = max_error(expected, out->data);
+    auto f = [&] { net.forward(); };
+    double quantized = suite.run(name + "/int8", f, cost, 0,
+                                 {{"max_error", error}});
+    if (time > 0 && quantized > 0)
+        std::printf("%-44s speedup=%.2fx\n", name.c_str(), time / quantized);
+}
+
+void mlp(bench::Suite & suite) {
+    std::string name = "Quantized/mlp";
+    if (!suite.selected(name + "/float") && !suite.selected(name + "/int8"))
+        return;
+
+    std::ofstream csv(csv_file);
+    for (nl::index_t i = 0; i < samples; ++i) {
+        for (nl::index_t j = 0; j < features; ++j) {
+            csv << (j ? "," : "") << nl::Generator::get();
+        }
+        csv << std::endl;
+    }
+    csv.close();
+
+    nl::CsvReader reader("reader", csv_file);
+    nl::Dense l1("l1", "tanh", reader, 1, 1, 256);
+    nl::Dense l2("l2", "tanh", l1, 1, 1, 128);
+    nl::Dense l3("l3", "linear", l2, 1, 1, 10);
+    nl::Net net("mlp");
+    net.add(&reader);
+    net.add(&l1);
+    net.add(&l2);
+    net.add(&l3);
+    nl::block_ptr out = l3.outputs()["l3_out"];
+
+    // every pass reads the next sample, the file is read whole
+    auto outputs = [&] {
+        std::vector<Eigen::Tensor<float, 3>> result;
+        for (nl::index_t i = 0; i < samples; ++i) {
+            net.forward();
+            result.push_back(out->data);
+        }
+        return result;
+    };
+    // measured without reading
+    auto layers = [&] {
+        for (const char* op : {"l1", "l2", "l3"}) {
+            net.ops[op]->forward();
+        }
+    };
+
+    nl::Cost cost = l1.forward_cost();
+    cost += l2.forward_cost();
+    cost += l3.forward_cost();
+
+    std::vector<Eigen::Tensor<float, 3>> expected = outputs();
+    double time = suite.run(name + "/float", layers, cost);
+
+    nl::Quantizer quantizer(net);
+    quantizer.calibrate(samples);
+    quantizer.quantize();
+    std::vector<Eigen::Tensor<float, 3>> quantized = outputs();
+
+    double error = 0;
+    double agreement = 0;
+    for (nl::index_t i = 0; i < samples; ++i) {
+        error = std::max<double>(error, max_error(expected[i], quantized[i]));
+        Eigen::Tensor<Eigen::DenseIndex, 0> a = expected[i].argmax();
+        Eigen::Tensor<Eigen::DenseIndex, 0> b = quantized[i].argmax();
+        agreement += a() == b();
+    }
+    double quantized_time = suite.run(name + "/int8", layers, cost, 0,
+                                      {{"max_error", error},
+                                       {"top1_agreement", agreement / samples}});
+    if (time > 0 && quantized_time > 0)
+        std::printf("%-44s speedup=%.2fx\n", name.c_str(), time / quantized_time);
+
+    std::remove(csv_file);
+}
+
+int main(int argc, char *argv[])
+{
+    bench::Suite suite(argc, argv);
+    std::printf("int8 dot product: %s\n", nl::Int8::isa());
+
+    for (nl::index_t n : {256, 1024}) {
+        nl::Dense op("dense", "relu", random_block("in", 1, 1, n), 1, 1, 128);
+        compare(suite, "Quantized/Dense/" + std::to_string(n) + "x128", op);
+    }
+
+    {
+        nl::Conv op("conv", "relu", random_block("in", 8, 32, 32), 16, 3, 1);
+        compare(suite, "Quantized/Conv/8x32x32/d16k3", op);
+    }
+    {
+        nl::Conv op("conv", "relu", random_block("in", 32, 16, 16), 32, 3, 1);
+        compare(suite, "Quantized/Conv/32x16x16/d32k3", op);
+    }
+
+    mlp(suite);
+
+    return suite.finish();
+}
@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "neural.hpp"
+#include "harness.hpp"
+
+/*
+Benchmark: concurrent inference
+
+A small convolutional network is served by a number of threads, each of
+them running forward passes on its own nl::Context. All contexts share
+weights of the original network, so memory per thread is only its
+activations; 'context_bytes' and 'weight_bytes' report both. Throughput
+should grow linearly with threads up to the number of cores.
+
+Usage: bench_serve [max_threads] [--benchmark_out=file.json]
+*/
+
+const int requests = 200;
+
+int main(int argc, char *argv[])
+{
+    bench::Suite suite(argc, argv);
+
+    int max_threads = std::max(1u, std::thread::hardware_concurrency());
+    if (!suite.arguments().empty())
+        max_threads = std::stoi(suite.arguments()[0]);
+
+    nl::block_ptr in = std::make_shared<nl::Block>("in", 3, 32, 32);
+    in->data.setRandom();
+    nl::Conv c1("c1", "relu", in, 16, 3, 1);
+    nl::MaxPool p1("p1", c1, 2, 0, 2);
+    nl::Conv c2("c2", "relu", p1, 32, 3, 1);
+    nl::MaxPool p2("p2", c2, 2, 0, 2);
+    nl::Dense d1("d1", "relu", p2, 1, 1, 128);
+    nl::Dense d2("d2", "linear", d1, 1, 1, 10);
+    nl::Net net("net");
+    for (nl::Op* op : std::vector<nl::Op*>{&c1, &p1, &c2, &p2, &d1, &d2}) {
+        net.add(op);
+    }
+
+    double weight_bytes = 0;
+    for (auto & block_pair : net.blocks) {
+        if (block_pair.second->trainable)
+            weight_bytes += block_pair.second->data.size() * sizeof(float);
+    }
+
+    double base = 0;
+    for (int t = 1; t <= max_threads; t *= 2) {
+        std::vector<std::unique_ptr<nl::Context>> contexts;
+        for (int i = 0; i < t; ++i) {
+            contexts.emplace_back(new nl::Context(net));
+            // first pass tunes kernels and allocates buffers
+            contexts.back()->forward();
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        std::clock_t cpu_start = std::clock();
+        std::vector<std::thread> threads;
+        for (int i = 0; i < t; ++i) {
+            threads.emplace_back([&, i] {
+                for (int r = 0; r < requests; ++r) {
+                    contexts[i]->forward();
+                }
+            });
+        }
+        for (auto & thread : threads) {
+            thread.join();
+        }
+        double cpu = double(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+        double seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+
+        double throughput = t * requests / seconds;
+        if (t == 1)
+            base = throughput;
+        suite.report({"Context/forward/threads:" + std::to_string(t),
+                      std::size_t(t * requests), seconds / (t * requests) * 1e9,
+                      cpu / (t * requests) * 1e9,
+                      {{"items_per_second", throughput},
+                       {"speedup", throughput / base},
+                       {"context_bytes", double(contexts[0]->bytes())},
+                       {"weight_bytes", weight_bytes}}});
+    }
+
+    return suite.finish();
+}
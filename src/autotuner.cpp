@@ -0,0 +1,117 @@
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <thread>
+
+#include "autotuner.hpp"
+
+namespace nl {
+
+    std::atomic<bool> Autotuner::on(false);
+    std::mutex Autotuner::mutex;
+    std::string Autotuner::file;
+    std::map<std::pair<std::string, std::string>, std::string> Autotuner::cache;
+
+    void Autotuner::enable(const std::string & file_addr) {
+        std::lock_guard<std::mutex> lock(mutex);
+        file = file_addr;
+
+        // lines of cpu, shape and kernel separated by tabs, results
+        // already held in memory take precedence
+        std::ifstream in(file);
+        std::string line;
+        while (std::getline(in, line)) {
+            std::size_t first = line.find('\t');
+            std::size_t second = line.find('\t', first + 1);
+            if (first == std::string::npos || second == std::string::npos)
+                continue;
+            cache.insert({{line.substr(0, first),
+                           line.substr(first + 1, second - first - 1)},
+                          line.substr(second + 1)});
+        }
+
+        on = true;
+    }
+
+    void Autotuner::disable() {
+        on = false;
+    }
+
+    void Autotuner::reset() {
+        std::lock_guard<std::mutex> lock(mutex);
+        cache.clear();
+    }
+
+    std::string Autotuner::lookup(const std::string & shape) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = cache.find({cpu(), shape});
+        return it == cache.end() ? std::string() : it->second;
+    }
+
+    void Autotuner::record(const std::string & shape, const std::string & kernel) {
+        std::lock_guard<std::mutex> lock(mutex);
+        cache[{cpu(), shape}] = kernel;
+        save();
+    }
+
+    void Autotuner::save() {
+        if (file.empty())
+            return;
+
+        // replace the file at once, so that a concurrent reader never
+        // sees a partial cache
+        std::string tmp = file + ".tmp";
+        {
+            std::ofstream out(tmp);
+            for (auto & entry : cache) {
+                out << entry.first.first << '\t' << entry.first.second << '\t'
+                    << entry.second << '\n';
+            }
+        }
+        std::rename(tmp.c_str(), file.c_str());
+    }
+
+    double Autotuner::measure(const std::function<void()> & fn, double limit) {
+        // enough repetitions to hide noise, few enough for large shapes
+        const double min_time = 0.05;
+        const int max_runs = 10;
+
+        double best = std::numeric_limits<double>::infinity();
+        double total = 0;
+        for (int i = 0; i < max_runs; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            fn();
+            std::chrono::duration<double> elapsed =
+                std::chrono::steady_clock::now() - start;
+
+            best = std::min(best, elapsed.count());
+            total += elapsed.count();
+            if (best > limit || (i > 0 && total > min_time))
+                break;
+        }
+        return best;
+    }
+
+    std::string Autotuner::cpu() {
+        static const std::string id = [] {
+            std::string model = "unknown";
+            std::ifstream in("/proc/cpuinfo");
+            std::string line;
+            while (std::getline(in, line)) {
+                if (line.compare(0, 10, "model name") == 0) {
+                    std::size_t colon = line.find(':');
+                    if (colon != std::string::npos && colon + 2 <= line.size())
+                        model = line.substr(colon + 2);
+                    break;
+                }
+            }
+            return model + " x" +
+                std::to_string(std::thread::hardware_concurrency());
+        }();
+        return id;
+    }
+
+} // namespace nl
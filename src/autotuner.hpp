@@ -0,0 +1,80 @@
+#ifndef NEURAL_LIB_AUTOTUNER_H
+#define NEURAL_LIB_AUTOTUNER_H
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace nl {
+
+    ///
+    /// Chooses the fastest kernel of an op by timing all candidates the
+    /// first time a shape is seen. Winners are kept in a cache keyed by
+    /// shape and CPU, which is stored in a file so that later runs pick
+    /// the best kernel immediately.
+    ///
+    /// Tuning is disabled by default, ops then choose their kernel by
+    /// fixed rules. All methods are thread-safe.
+    ///
+    class Autotuner {
+    public:
+        ///
+        /// Start tuning.
+        /// @param file_addr address of the cache file, it is read if it
+        /// exists and rewritten with every new result; empty address
+        /// keeps the cache in memory only
+        ///
+        static void enable(const std::string & file_addr="");
+        /// Stop tuning, results are kept.
+        static void disable();
+        /// true iff tuning is enabled
+        static bool enabled() {
+            return on.load(std::memory_order_relaxed);
+        }
+        /// Forget all results held in memory, the cache file is kept.
+        static void reset();
+        ///
+        /// Kernel recorded for a shape on this CPU.
+        /// @param shape description of the op and its shape
+        /// @return name of the kernel, empty if the shape was not tuned
+        ///
+        static std::string lookup(const std::string & shape);
+        ///
+        /// Record the fastest kernel for a shape on this CPU and save
+        /// the cache file.
+        /// @param shape description of the op and its shape
+        /// @param kernel name of the kernel
+        ///
+        static void record(const std::string & shape, const std::string & kernel);
+        ///
+        /// Time a candidate kernel. It is run once and then repeatedly
+        /// for a short while, unless the first run already exceeds limit.
+        /// @param fn single run of the kernel
+        /// @param limit time in seconds after which a run is hopeless
+        /// @return minimal time of a run in seconds
+        ///
+        static double measure(const std::function<void()> & fn, double limit);
+        ///
+        /// Identification of this CPU, model name and number of hardware
+        /// threads.
+        ///
+        static std::string cpu();
+
+    private:
+        /// Write all results to the cache file.
+        static void save();
+        /// true iff tuning is enabled
+        static std::atomic<bool> on;
+        /// guards results and file address
+        static std::mutex mutex;
+        /// address of the cache file
+        static std::string file;
+        /// kernels keyed by CPU and shape
+        static std::map<std::pair<std::string, std::string>, std::string> cache;
+    };
+
+} // namespace nl
+
+#endif // NEURAL_LIB_AUTOTUNER_H
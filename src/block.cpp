@@ -0,0 +1,28 @@
+
+#include "block.hpp"
+#include "half.hpp"
+
+namespace nl {
+
+    std::shared_ptr<Block> Block::alias(const Block & source) {
+        return std::shared_ptr<Block>(new Block(source, source.values));
+    }
+
+    void Block::setPrecision(Precision precision) {
+        values->format = precision;
+        store();
+    }
+
+    void Block::store() {
+        ++version;
+        Precision format = values->format;
+        if (format == FP32) {
+            std::vector<std::uint16_t>().swap(packed);
+            return;
+        }
+        packed.resize(data.size());
+        Half::pack(data.data(), data.size(), format, packed.data());
+        Half::unpack(packed.data(), data.size(), format, data.data());
+    }
+
+} // namespace nl
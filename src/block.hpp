@@ -1,21 +1,66 @@
 #ifndef NEURAL_LIB_BLOCK_H
 #define NEURAL_LIB_BLOCK_H
 
+#include <cstdint>
+#include <limits>
 #include <memory>
 #include <unordered_map>
 #include <vector>
 
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
+#include <boost/serialization/version.hpp>
 #include <Eigen/unsupported/CXX11/Tensor>
 
+#include "exceptions.hpp"
+
 namespace nl {
+
+    ///
+    /// Type of dimensions, sizes, indices and counts used by the library.
+    /// It is signed like the index type of Eigen tensors, so that positions
+    /// shifted by padding may be negative.
+    ///
+    typedef std::int64_t index_t;
+
+    ///
+    /// Product of two sizes.
+    /// @throw DimensionException if either size is negative or the product
+    /// does not fit into index_t
+    ///
+    inline index_t checked_mul(index_t a, index_t b) {
+        if (a < 0 || b < 0 ||
+            (a != 0 && b > std::numeric_limits<index_t>::max() / a))
+            throw DimensionException();
+        return a * b;
+    }
+
+    ///
+    /// Storage format of block data, see Block::setPrecision().
+    /// FP16 is IEEE half precision, BF16 keeps the exponent of single
+    /// precision and 7 bits of mantissa.
+    ///
+    enum Precision { FP32, FP16, BF16 };
     
     ///
     /// A storage for the network. Used for holding data and gradient 
     /// flowing through the network
     ///
 	class Block {
+        ///
+        /// Data of a block with everything that describes it, shared by
+        /// the block and its aliases, see alias().
+        ///
+        struct Values {
+            Values(Eigen::array<Eigen::Index, 3> dims): data(dims) {}
+            Eigen::Tensor<float,3> data;
+            std::vector<std::uint16_t> packed;
+            std::uint64_t version = 0;
+            Precision format = FP32;
+        };
+
+        /// Values of the block, possibly shared with other blocks.
+        std::shared_ptr<Values> values;
     public:
 
         /// Constructor.
@@ -23,14 +68,31 @@ namespace nl {
         /// @param depth depth of both 3D tensors, should be 1 for 2D matrices
         /// @param width width of both 3D tensors
         /// @param height height of both 3D tensors
-        Block(std::string name, uint16_t depth, 
-              uint16_t width, uint16_t height):
+        /// @throw DimensionException if the block would be too large
+        Block(std::string name, index_t depth, 
+              index_t width, index_t height):
+            values(std::make_shared<Values>(
+                       checked_dims(depth, width, height))),
             name(name),
-            data(depth, width, height),
-            grad(depth, width, height) {
+            data(values->data),
+            grad(checked_dims(depth, width, height)),
+            packed(values->packed),
+            version(values->version) {
             zero_grad();
         }
 
+        ///
+        /// Block with the same name and 'trainable' flag that shares data,
+        /// and so also its precision and version, with the source block,
+        /// but has a gradient of its own. Copies of a network may then
+        /// read the same weights and compute their own gradients.
+        /// @param source block whose data is shared
+        ///
+        static std::shared_ptr<Block> alias(const Block & source);
+
+        Block(const Block &) = delete;
+        Block & operator=(const Block &) = delete;
+
         ///
         /// Name of the block. Must be unique within a single network
         /// as it is used as an identifier.
@@ -40,8 +102,8 @@ namespace nl {
         /// Dimension vector of both data and gradient tensor in better 
         /// format than the default Eigen::Tensor<float, 3>::Dimensions.
         /// @return dimension vector 
-        std::vector<uint16_t> dimensions() const {
-            std::vector<uint16_t> v;
+        std::vector<index_t> dimensions() const {
+            std::vector<index_t> v;
             
             for (auto & d : data.dimensions()) {
                 v.push_back(d);
@@ -55,11 +117,34 @@ namespace nl {
             grad.setZero();
         }
 
+        /// Storage format of data, FP32 unless set by setPrecision().
+        Precision precision() const {
+            return values->format;
+        }
+
+        ///
+        /// Store data in 16 bits. Data is rounded to the format and packed
+        /// into 'packed', which ops that support it read instead of 'data'
+        /// and so move half of the bytes. Other ops keep using 'data',
+        /// which holds the same rounded values. Gradient stays in single
+        /// precision.
+        /// @param precision FP32 releases packed data
+        ///
+        void setPrecision(Precision precision);
+
+        ///
+        /// Round data to the precision of the block, pack it again and
+        /// increment version. Has to be called whenever 'data' of a block
+        /// with reduced precision, or of weights that ops keep in another
+        /// form, is changed by anything else than an op or Solver.
+        ///
+        void store();
+
         ///
         /// Actual 3D tensor for storage mostly for op results. Although 
         /// it can be modified by hand.
         /// 
-        Eigen::Tensor<float,3> data;
+        Eigen::Tensor<float,3> & data;
 
         /// 
         /// Storage for gradient flowing backward during backpropagation.
@@ -72,8 +157,38 @@ namespace nl {
         /// set to false for blocks holding data passed through net.
         /// 
         bool trainable = false;
+
+        /// Data packed in 16 bits, empty in single precision.
+        std::vector<std::uint16_t> & packed;
+
+        ///
+        /// Incremented by store() and by Solver after every update of
+        /// data. Ops that keep weights in another form, e.g. Dense in
+        /// a sparse matrix, compare it to know when to convert them again.
+        ///
+        std::uint64_t & version;
     private:
 
+        /// Dimensions of tensors after checking that their size fits 
+        /// into index of tensor.
+        static Eigen::array<Eigen::Index, 3> 
+        checked_dims(index_t depth, index_t width, index_t height) {
+            checked_mul(checked_mul(depth, width), height);
+            return {{depth, width, height}};
+        }
+
+        /// Alias of a block, see alias().
+        Block(const Block & source, std::shared_ptr<Values> shared):
+            values(shared),
+            name(source.name),
+            data(values->data),
+            grad(source.grad.dimensions()),
+            trainable(source.trainable),
+            packed(values->packed),
+            version(values->version) {
+            zero_grad();
+        }
+
         /// Default constructor. Provided primarily for serialization purposes.
         Block(): Block("default_name", 1, 1, 1) {};
 
@@ -82,6 +197,7 @@ namespace nl {
         template<class Archive>
         void save(Archive & ar, const unsigned int) const
         {
+            // data is saved in single precision, it holds rounded values
             // save name and 'trainable' flag
             ar & name;
             ar & trainable;
@@ -91,31 +207,32 @@ namespace nl {
             ar & dims[1];
             ar & dims[2];
             // save contents of data tensor
-            for (uint16_t i = 0; i < dims[0]; i++) {
-                for (uint16_t j = 0; j < dims[1]; j++) {
-                    for (uint16_t k = 0; k < dims[2]; k++) {
+            for (index_t i = 0; i < dims[0]; i++) {
+                for (index_t j = 0; j < dims[1]; j++) {
+                    for (index_t k = 0; k < dims[2]; k++) {
                         ar & data(i,j,k);
                     }
                 }
             }
             // save contents of grad tensor
-            for (uint16_t i = 0; i < dims[0]; i++) {
-                for (uint16_t j = 0; j < dims[1]; j++) {
-                    for (uint16_t k = 0; k < dims[2]; k++) {
+            for (index_t i = 0; i < dims[0]; i++) {
+                for (index_t j = 0; j < dims[1]; j++) {
+                    for (index_t k = 0; k < dims[2]; k++) {
                         ar & grad(i,j,k);
                     }
                 }
             }
+            ar & values->format;
         }
 
         template<class Archive>
-        void load(Archive & ar, const unsigned int)
+        void load(Archive & ar, const unsigned int version)
         {
             // load name and 'trainable' flag
             ar & name;
             ar & trainable;
-            // load dimensions of tensor
-            uint16_t depth, width, height;
+            // load dimensions of tensor, same type as in save()
+            Eigen::Index depth, width, height;
             ar & depth;
             ar & width;
             ar & height;
@@ -123,20 +240,25 @@ namespace nl {
             data = Eigen::Tensor<float,3>(depth, width, height);
             grad = Eigen::Tensor<float,3>(depth, width, height);
             // load data to tensors
-            for (uint16_t i = 0; i < depth; i++) {
-                for (uint16_t j = 0; j < width; j++) {
-                    for (uint16_t k = 0; k < height; k++) {
+            for (index_t i = 0; i < depth; i++) {
+                for (index_t j = 0; j < width; j++) {
+                    for (index_t k = 0; k < height; k++) {
                         ar & data(i,j,k);
                     }
                 }
             }
-            for (uint16_t i = 0; i < depth; i++) {
-                for (uint16_t j = 0; j < width; j++) {
-                    for (uint16_t k = 0; k < height; k++) {
+            for (index_t i = 0; i < depth; i++) {
+                for (index_t j = 0; j < width; j++) {
+                    for (index_t k = 0; k < height; k++) {
                         ar & grad(i,j,k);
                     }
                 }
             }
+            // version 0 knew only single precision
+            values->format = FP32;
+            if (version > 0)
+                ar & values->format;
+            store();
         }
         BOOST_SERIALIZATION_SPLIT_MEMBER()
 	};
@@ -146,4 +268,6 @@ namespace nl {
 
 } // namespace nl
 
+BOOST_CLASS_VERSION(nl::Block, 1)
+
 #endif // NEURAL_LIB_BLOCK_H
@@ -0,0 +1,381 @@
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+#include "codegen.hpp"
+#include "conv.hpp"
+#include "conv_pool.hpp"
+#include "dense.hpp"
+#include "maxpool.hpp"
+#include "softmax.hpp"
+
+namespace nl {
+
+    namespace {
+
+        /// Templates called by generated code, shapes are their arguments.
+        const char* preamble = R"(#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+    inline float nl_sigmoid(float x) { return 1 / (1 + std::exp(-x)); }
+    inline float nl_tanh(float x) { return std::tanh(x); }
+    inline float nl_relu(float x) { return x > 0 ? x : 0; }
+    inline float nl_softplus(float x) { return std::log(1 + std::exp(x)); }
+    inline float nl_linear(float x) { return x; }
+
+    // weights are stored input by input, each input cell adds its
+    // contribution to all outputs at once
+    template<int In, int Out, float (*F)(float)>
+    void nl_dense(const float* x, const float* w, const float* t, float* y) {
+        float acc[Out];
+        for (int o = 0; o < Out; ++o)
+            acc[o] = t[o];
+        for (int i = 0; i < In; ++i) {
+            const float* row = w + Out * i;
+            for (int o = 0; o < Out; ++o)
+                acc[o] += x[i] * row[o];
+        }
+        for (int o = 0; o < Out; ++o)
+            y[o] = F(acc[o]);
+    }
+
+    // weights of a group are stored by window position, then input slice,
+    // then output slice, so every input cell of a window is added to all
+    // outputs of the group at once; Cells neighbouring outputs along width
+    // are computed together, their windows have to lie inside the input
+    template<int InD, int InW, int OutD, int Window, int Stride, int Groups,
+             int Cells>
+    void nl_conv_cells(const float* x, const float* k, const float* t,
+                       float* y) {
+        constexpr int in_group = InD / Groups, out_group = OutD / Groups;
+        for (int g = 0; g < Groups; ++g) {
+            const float* group = k + Window * Window * in_group * out_group * g;
+            float acc[Cells][out_group];
+            for (int c = 0; c < Cells; ++c)
+                for (int o = 0; o < out_group; ++o)
+                    acc[c][o] = t[out_group * g + o];
+            for (int z = 0; z < Window; ++z) {
+                for (int v = 0; v < Window; ++v) {
+                    const float* a = x + InD * (v + InW * z) + in_group * g;
+                    const float* b = group + out_group * in_group * (v + Window * z);
+                    for (int d = 0; d < in_group; ++d)
+                        for (int c = 0; c < Cells; ++c)
+                            for (int o = 0; o < out_group; ++o)
+                                acc[c][o] += a[InD * Stride * c + d] * b[out_group * d + o];
+                }
+            }
+            for (int c = 0; c < Cells; ++c)
+                for (int o = 0; o < out_group; ++o)
+                    y[OutD * c + out_group * g + o] = acc[c][o];
+        }
+    }
+
+    template<int InD, int InW, int InH, int OutD, int OutW, int OutH,
+             int Window, int Padding, int Stride, int Groups, float (*F)(float)>
+    void nl_conv(const float* x, const float* k, const float* t, float* y) {
+        constexpr int in_group = InD / Groups, out_group = OutD / Groups;
+        constexpr int cells = 4;
+        for (int h = 0; h < OutH; ++h) {
+            int top = Stride * h - Padding;
+            bool rows_inside = top >= 0 && top + Window <= InH;
+            for (int w = 0; w < OutW;) {
+                int left = Stride * w - Padding;
+                float* cell = y + OutD * (w + OutW * h);
+                if (rows_inside && left >= 0 && w + cells <= OutW &&
+                    left + Stride * (cells - 1) + Window <= InW) {
+                    nl_conv_cells<InD, InW, OutD, Window, Stride, Groups, cells>(
+                        x + InD * (left + InW * top), k, t, cell);
+                    for (int i = 0; i < OutD * cells; ++i)
+                        cell[i] = F(cell[i]);
+                    w += cells;
+                    continue;
+                }
+                // window reaching into padding
+                for (int g = 0; g < Groups; ++g) {
+                    const float* group = k + Window * Window * in_group * out_group * g;
+                    float acc[out_group];
+                    for (int o = 0; o < out_group; ++o)
+                        acc[o] = t[out_group * g + o];
+                    for (int z = 0; z < Window; ++z) {
+                        if (top + z < 0 || top + z >= InH)
+                            continue;
+                        for (int v = 0; v < Window; ++v) {
+                            if (left + v < 0 || left + v >= InW)
+                                continue;
+                            const float* a = x + InD * (left + v + InW * (top + z)) + in_group * g;
+                            const float* b = group + out_group * in_group * (v + Window * z);
+                            for (int d = 0; d < in_group; ++d)
+                                for (int o = 0; o < out_group; ++o)
+                                    acc[o] += a[d] * b[out_group * d + o];
+                        }
+                    }
+                    for (int o = 0; o < out_group; ++o)
+                        cell[out_group * g + o] = F(acc[o]);
+                }
+                ++w;
+            }
+        }
+    }
+
+    template<int D, int InW, int InH, int OutW, int OutH,
+             int Window, int Padding, int Stride>
+    void nl_maxpool(const float* x, float* y) {
+        for (int h = 0; h < OutH; ++h) {
+            int z_from = std::max(Stride * h - Padding, 0);
+            int z_to = std::min(Stride * h - Padding + Window, InH);
+            for (int w = 0; w < OutW; ++w) {
+                int y_from = std::max(Stride * w - Padding, 0);
+                int y_to = std::min(Stride * w - Padding + Window, InW);
+                float* cell = y + D * (w + OutW * h);
+                for (int d = 0; d < D; ++d)
+                    cell[d] = std::numeric_limits<float>::lowest();
+                for (int z = z_from; z < z_to; ++z)
+                    for (int v = y_from; v < y_to; ++v)
+                        for (int d = 0; d < D; ++d)
+                            cell[d] = std::max(cell[d], x[d + D * (v + InW * z)]);
+            }
+        }
+    }
+
+    template<int N>
+    void nl_softmax(const float* x, float* y) {
+        float top = *std::max_element(x, x + N);
+        float sum = 0;
+        for (int i = 0; i < N; ++i) {
+            y[i] = std::exp(x[i] - top);
+            sum += y[i];
+        }
+        for (int i = 0; i < N; ++i)
+            y[i] /= sum;
+    }
+
+)";
+
+        /// C++ identifier made of a name.
+        std::string identifier(const std::string & name) {
+            std::string id = name;
+            for (char & c : id) {
+                if (!std::isalnum((unsigned char) c))
+                    c = '_';
+            }
+            if (id.empty() || std::isdigit((unsigned char) id[0]))
+                id = "_" + id;
+            return id;
+        }
+
+        /// Dimensions of a block as template arguments.
+        std::string shape(const block_ptr & b) {
+            auto d = b->dimensions();
+            return std::to_string(d[0]) + ", " + std::to_string(d[1]) +
+                ", " + std::to_string(d[2]);
+        }
+
+        /// Blocks ordered by name.
+        std::vector<block_ptr> sorted(const block_map & blocks) {
+            std::vector<block_ptr> result;
+            for (auto & block_pair : blocks) {
+                if (!block_pair.second->trainable)
+                    result.push_back(block_pair.second);
+            }
+            std::sort(result.begin(), result.end(),
+                      [](const block_ptr & a, const block_ptr & b) {
+                          return a->name < b->name;
+                      });
+            return result;
+        }
+
+    } // namespace
+
+    Codegen::Codegen(Net & net):
+        net_name(net.name), ordering(net.get_ordering()) {
+        for (Op* op : ordering) {
+            if (dynamic_cast<Dense*>(op) == nullptr &&
+                dynamic_cast<Conv*>(op) == nullptr &&
+                dynamic_cast<MaxPool*>(op) == nullptr &&
+                dynamic_cast<ConvPool*>(op) == nullptr &&
+                dynamic_cast<Softmax*>(op) == nullptr)
+                throw UnsupportedException();
+        }
+        input_blocks = sorted(net.inputs());
+        output_blocks = sorted(net.outputs());
+    }
+
+    void Codegen::write(std::ostream & os, const std::string & function) const {
+
+        std::ostringstream weights, body;
+        // blocks passed between ops, outputs of the network excluded
+        std::vector<block_ptr> buffers;
+        std::set<Block*> parameters;
+        for (auto & b : input_blocks) {
+            parameters.insert(b.get());
+        }
+        for (auto & b : output_blocks) {
+            parameters.insert(b.get());
+        }
+        auto buffer = [&](const block_ptr & b) {
+            if (parameters.insert(b.get()).second)
+                buffers.push_back(b);
+        };
+
+        for (Op* op : ordering) {
+            body << "    // " << op->name << "\n";
+            if (Dense* d = dynamic_cast<Dense*>(op)) {
+                buffer(d->output);
+                write_dense(weights, body, *d);
+            } else if (Conv* c = dynamic_cast<Conv*>(op)) {
+                buffer(c->output);
+                write_conv(weights, body, *c);
+            } else if (MaxPool* p = dynamic_cast<MaxPool*>(op)) {
+                buffer(p->output);
+                write_maxpool(body, *p);
+            } else if (ConvPool* cp = dynamic_cast<ConvPool*>(op)) {
+                // the convolution output is not in the network, but the
+                // generated code computes it as a whole
+                buffer(cp->conv.output);
+                buffer(cp->pool.output);
+                write_conv(weights, body, cp->conv);
+                write_maxpool(body, cp->pool);
+            } else {
+                block_ptr in = op->inputs().begin()->second;
+                block_ptr out = op->outputs().begin()->second;
+                buffer(out);
+                body << "    nl_softmax<" << in->data.size() << ">("
+                     << variable(in) << ", " << variable(out) << ");\n";
+            }
+        }
+
+        os << "// Generated by nl::Codegen from network \"" << net_name
+           << "\".\n";
+        os << preamble << weights.str() << "} // namespace\n\n";
+
+        os << "void " << function << "(";
+        std::string separator;
+        for (auto & b : input_blocks) {
+            os << separator << "const float* " << variable(b);
+            separator = ", ";
+        }
+        for (auto & b : output_blocks) {
+            os << separator << "float* " << variable(b);
+            separator = ", ";
+        }
+        os << ") {\n";
+        for (auto & b : buffers) {
+            os << "    static thread_local float " << variable(b) << "["
+               << b->data.size() << "];\n";
+        }
+        os << body.str() << "}\n";
+    }
+
+    void Codegen::write(const std::string & filename,
+                        const std::string & function) const {
+        std::ofstream ofs(filename);
+        if (!ofs)
+            throw InputException();
+        write(ofs, function);
+        if (!ofs)
+            throw InputException();
+    }
+
+    std::string Codegen::variable(const block_ptr & b) const {
+        return identifier(b->name);
+    }
+
+    std::string Codegen::transfer(TransferFn* fn) {
+        if (dynamic_cast<Sigmoid*>(fn) != nullptr)
+            return "nl_sigmoid";
+        if (dynamic_cast<Tanh*>(fn) != nullptr)
+            return "nl_tanh";
+        if (dynamic_cast<ReLU*>(fn) != nullptr)
+            return "nl_relu";
+        if (dynamic_cast<Softplus*>(fn) != nullptr)
+            return "nl_softplus";
+        if (dynamic_cast<Linear*>(fn) != nullptr)
+            return "nl_linear";
+        throw UnsupportedException();
+    }
+
+    void Codegen::write_array(std::ostream & os, const std::string & name,
+                              const std::vector<float> & values) {
+        // nine significant digits restore every float exactly
+        char number[32];
+        os << "    const float " << name << "[" << values.size() << "] = {";
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            std::snprintf(number, sizeof(number), "%.8ef", values[i]);
+            os << (i % 6 == 0 ? "\n        " : " ") << number << ",";
+        }
+        os << "\n    };\n\n";
+    }
+
+    void Codegen::write_dense(std::ostream & weights, std::ostream & body,
+                              const Dense & d) const {
+        std::string id = identifier(d.name);
+        const Block & w = *d.weight;
+        const Block & t = *d.threshold;
+        // transposed, see nl_dense
+        index_t in = d.input->data.size();
+        index_t out = d.output->data.size();
+        std::vector<float> transposed(in * out);
+        for (index_t o = 0; o < out; ++o) {
+            for (index_t i = 0; i < in; ++i) {
+                transposed[out * i + o] = w.data.data()[in * o + i];
+            }
+        }
+        write_array(weights, "nl_w_" + id, transposed);
+        write_array(weights, "nl_t_" + id,
+                    std::vector<float>(t.data.data(), t.data.data() + t.data.size()));
+
+        body << "    nl_dense<" << in << ", " << out << ", "
+             << transfer(d.transfer_fn)
+             << ">(" << variable(d.input) << ", nl_w_" << id << ", nl_t_"
+             << id << ", " << variable(d.output) << ");\n";
+    }
+
+    void Codegen::write_conv(std::ostream & weights, std::ostream & body,
+                             const Conv & c) const {
+        std::string id = identifier(c.name);
+        // reordered for nl_conv
+        index_t out_depth = c.weights.size();
+        index_t out_group = out_depth / c.groups;
+        index_t in_group = c.input->dimensions()[0] / c.groups;
+        index_t taps = c.window_size * c.window_size;
+        std::vector<float> kernels(out_depth * taps * in_group), thresholds;
+        for (index_t o = 0; o < out_depth; ++o) {
+            const float* k = c.weights[o].kernel->data.data();
+            index_t g = o / out_group;
+            for (index_t tap = 0; tap < taps; ++tap) {
+                for (index_t d = 0; d < in_group; ++d) {
+                    kernels[taps * in_group * out_group * g +
+                            out_group * (d + in_group * tap) + o % out_group] =
+                        k[d + in_group * tap];
+                }
+            }
+            thresholds.push_back(c.weights[o].threshold->data(0,0,0));
+        }
+        write_array(weights, "nl_w_" + id, kernels);
+        write_array(weights, "nl_t_" + id, thresholds);
+
+        body << "    nl_conv<" << shape(c.input) << ", " << shape(c.output)
+             << ", " << c.window_size << ", " << c.padding_size << ", "
+             << c.stride << ", " << c.groups << ", "
+             << transfer(c.transfer_fn) << ">(" << variable(c.input)
+             << ", nl_w_" << id << ", nl_t_" << id << ", "
+             << variable(c.output) << ");\n";
+    }
+
+    void Codegen::write_maxpool(std::ostream & body, const MaxPool & p) const {
+        auto in = p.input->dimensions();
+        auto out = p.output->dimensions();
+        body << "    nl_maxpool<" << in[0] << ", " << in[1] << ", " << in[2]
+             << ", " << out[1] << ", " << out[2] << ", " << p.window_size
+             << ", " << p.padding_size << ", " << p.stride << ">("
+             << variable(p.input) << ", " << variable(p.output) << ");\n";
+    }
+
+} // namespace nl
@@ -0,0 +1,100 @@
+#ifndef NEURAL_LIB_CODEGEN_H
+#define NEURAL_LIB_CODEGEN_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "block.hpp"
+#include "net.hpp"
+#include "op.hpp"
+#include "transfer_fns.hpp"
+
+namespace nl {
+
+    class Conv;
+    class Dense;
+    class MaxPool;
+
+    ///
+    /// Ahead-of-time compilation of a trained network for inference.
+    /// Ops are written in the order of the forward pass as calls of
+    /// templates whose arguments are all dimensions of the op, so the
+    /// compiler sees every loop bound as a constant. Weights are embedded
+    /// as arrays and the generated file depends only on the standard
+    /// library, without virtual calls, blocks or any allocation.
+    ///
+    /// The generated function takes a pointer to data of every input
+    /// block followed by a pointer to data of every output block, both
+    /// ordered by name, in the memory order of Block. Blocks between ops
+    /// are static thread_local arrays, so the function may run from many
+    /// threads at once.
+    ///
+    /// Weights are reordered so that innermost loops run over outputs, which
+    /// the compiler vectorizes best when it may use the instruction set of
+    /// the target, e.g. with -O3 -march=native.
+    ///
+    /// Supported ops are Dense, Conv, MaxPool, ConvPool and Softmax.
+    /// Values are computed in single precision, Dense layers kept in
+    /// reduced precision use their rounded weights.
+    ///
+    class Codegen {
+    public:
+        ///
+        /// Constructor.
+        /// @param net trained network, weights are read by write()
+        /// @throw UnsupportedException if the network has another op
+        ///
+        explicit Codegen(Net & net);
+
+        /// Input blocks of the network, in order of parameters.
+        const std::vector<block_ptr> & inputs() const {
+            return input_blocks;
+        }
+
+        /// Output blocks of the network, in order of parameters.
+        const std::vector<block_ptr> & outputs() const {
+            return output_blocks;
+        }
+
+        ///
+        /// Write C++ source of the network.
+        /// @param os stream receiving the source
+        /// @param function name of the generated function
+        ///
+        void write(std::ostream & os, const std::string & function) const;
+
+        ///
+        /// Write C++ source of the network into a file.
+        /// @param filename name of the file
+        /// @param function name of the generated function
+        /// @throw InputException if the file cannot be written
+        ///
+        void write(const std::string & filename,
+                   const std::string & function) const;
+
+    private:
+        /// Identifier of a block in the generated code.
+        std::string variable(const block_ptr & b) const;
+        /// Name of the generated transfer function.
+        static std::string transfer(TransferFn* fn);
+        /// Write values as an array of given name.
+        static void write_array(std::ostream & os, const std::string & name,
+                                const std::vector<float> & values);
+        /// Write weights and the call of a single op.
+        void write_dense(std::ostream & weights, std::ostream & body,
+                         const Dense & d) const;
+        void write_conv(std::ostream & weights, std::ostream & body,
+                        const Conv & c) const;
+        void write_maxpool(std::ostream & body, const MaxPool & p) const;
+        /// Name of the network.
+        std::string net_name;
+        /// Ops in order of the forward pass.
+        std::vector<Op*> ordering;
+        /// Blocks given and returned by the generated function.
+        std::vector<block_ptr> input_blocks, output_blocks;
+    };
+
+} // namespace nl
+
+#endif // NEURAL_LIB_CODEGEN_H
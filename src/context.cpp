@@ -0,0 +1,37 @@
+
+#include "context.hpp"
+
+namespace nl {
+
+    std::mutex Context::first_pass;
+
+    block_ptr Context::block(const std::string & name) {
+        auto it = net().blocks.find(name);
+        if (it == net().blocks.end())
+            throw InputException();
+        return it->second;
+    }
+
+    void Context::forward() {
+        if (warm) {
+            net().forward();
+            return;
+        }
+        std::lock_guard<std::mutex> lock(first_pass);
+        net().forward();
+        warm = true;
+    }
+
+    std::size_t Context::bytes() {
+        std::size_t total = 0;
+        for (auto & block_pair : net().blocks) {
+            const Block & b = *block_pair.second;
+            if (b.trainable)
+                continue;
+            total += (b.data.size() + b.grad.size()) * sizeof(float) +
+                b.packed.size() * sizeof(std::uint16_t);
+        }
+        return total;
+    }
+
+} // namespace nl
@@ -0,0 +1,65 @@
+#ifndef NEURAL_LIB_CONTEXT_H
+#define NEURAL_LIB_CONTEXT_H
+
+#include <mutex>
+#include <string>
+
+#include "block.hpp"
+#include "net.hpp"
+#include "replica.hpp"
+
+namespace nl {
+
+    ///
+    /// Execution context for concurrent inference. A context has its own
+    /// copy of ops and of blocks passed through the network, but uses
+    /// trainable blocks of the original network, so any number of contexts
+    /// can run forward passes at the same time on a single copy of weights,
+    /// each one from its own thread.
+    ///
+    /// Weights must not change while contexts run, i.e. the network is not
+    /// trained meanwhile. A single context is not thread-safe.
+    ///
+    class Context {
+    public:
+        ///
+        /// Constructor.
+        /// @param net trained network, it has to outlive the context
+        ///
+        explicit Context(Net & net): replica(net, true) {}
+
+        ///
+        /// Block of the context, e.g. to set input or read output.
+        /// Blocks are identified by names used in the original network.
+        /// @param name name of the block
+        /// @throw InputException if the network has no such block
+        ///
+        block_ptr block(const std::string & name);
+
+        ///
+        /// Forward pass of the context. The first pass of ops may tune
+        /// their kernels, which touches gradient of shared weights, so
+        /// first passes of all contexts run one at a time.
+        ///
+        void forward();
+
+        /// Copied network.
+        Net & net() {
+            return replica.net();
+        }
+
+        /// Bytes of blocks owned by the context, weights are not included.
+        std::size_t bytes();
+
+    private:
+        /// Copy of the network sharing trainable blocks.
+        Replica replica;
+        /// True iff the first forward pass is done.
+        bool warm = false;
+        /// Serializes first forward passes of all contexts.
+        static std::mutex first_pass;
+    };
+
+} // namespace nl
+
+#endif // NEURAL_LIB_CONTEXT_H
@@ -1,25 +1,255 @@
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include <Eigen/Core>
+
 #include "conv.hpp"
 
 namespace nl {
 
+    namespace {
+
+        typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic> Matrix;
+        /// Rows of a column-major matrix stored in a larger one.
+        typedef Eigen::Map<Matrix, 0, Eigen::OuterStride<>> MatrixMap;
+        /// Kernel stored in a row of a matrix.
+        typedef Eigen::Map<const Eigen::Matrix<float, 1, Eigen::Dynamic>> RowMap;
+
+        /// Names of Conv kernels, in order of Conv::Algorithm.
+        const std::vector<std::string> algorithm_names = {
+            "auto", "direct", "depthwise", "gemm", "winograd", "fft", "im2col"
+        };
+
+        ///
+        /// Transform both dimensions of a square tile by a linear map of
+        /// vectors. The map is applied to every column and then to every
+        /// row of the result.
+        /// @param in tile of N x N, first index is the slower one
+        /// @param out tile of M x M, first index is the slower one
+        /// @param f map of N values to M values
+        ///
+        template<int N, int M, class F>
+        inline void transform(const float* in, float* out, F f) {
+            float tmp[M * N], column[N], result[M];
+            for (int b = 0; b < N; ++b) {
+                for (int a = 0; a < N; ++a)
+                    column[a] = in[a * N + b];
+                f(column, result);
+                for (int a = 0; a < M; ++a)
+                    tmp[a * N + b] = result[a];
+            }
+            for (int a = 0; a < M; ++a) {
+                f(&tmp[a * N], &out[a * M]);
+            }
+        }
+
+        // Winograd F(2x2,3x3) transforms of input (B^T d B), filter
+        // (G g G^T) and output (A^T m A), see Lavin & Gray, "Fast
+        // Algorithms for Convolutional Neural Networks", and their
+        // adjoints which carry gradient back through them.
+
+        inline void input_transform(const float* x, float* y) {
+            y[0] = x[0] - x[2];
+            y[1] = x[1] + x[2];
+            y[2] = x[2] - x[1];
+            y[3] = x[1] - x[3];
+        }
+
+        inline void input_adjoint(const float* x, float* y) {
+            y[0] = x[0];
+            y[1] = x[1] - x[2] + x[3];
+            y[2] = x[1] + x[2] - x[0];
+            y[3] = -x[3];
+        }
+
+        inline void filter_transform(const float* x, float* y) {
+            y[0] = x[0];
+            y[1] = 0.5f * (x[0] + x[1] + x[2]);
+            y[2] = 0.5f * (x[0] - x[1] + x[2]);
+            y[3] = x[2];
+        }
+
+        inline void filter_adjoint(const float* x, float* y) {
+            y[0] = x[0] + 0.5f * (x[1] + x[2]);
+            y[1] = 0.5f * (x[1] - x[2]);
+            y[2] = x[3] + 0.5f * (x[1] + x[2]);
+        }
+
+        inline void output_transform(const float* x, float* y) {
+            y[0] = x[0] + x[1] + x[2];
+            y[1] = x[1] - x[2] - x[3];
+        }
+
+        inline void output_adjoint(const float* x, float* y) {
+            y[0] = x[0];
+            y[1] = x[0] + x[1];
+            y[2] = x[0] - x[1];
+            y[3] = -x[1];
+        }
+
+        ///
+        /// Direct convolution of a single input, sizes known at run time.
+        /// Output depth slices from 'first' to 'first' + 'count' are
+        /// computed, cells of 'output' and 'grad' hold 'count' values.
+        ///
+        struct DirectShape {
+            const float* input;
+            index_t in_depth, in_width, in_height;
+            index_t out_width, out_height;
+            /// Input and output depth slices of a group.
+            index_t in_group, out_group;
+            /// Computed output depth slices.
+            index_t first, count;
+            /// Kernel of every output depth slice.
+            const float* const* kernels;
+        };
+
+        ///
+        /// Forward pass of a direct convolution with window, padding and
+        /// stride fixed at compile time. Loops over the window are unrolled
+        /// and windows that lie inside the input skip bounds checks.
+        ///
+        template<int Window, int Padding, int Stride>
+        void direct_fixed(const DirectShape & s, const float* thresholds,
+                          TransferFn* transfer_fn, float* output) {
+            for (index_t h = 0; h < s.out_height; ++h) {
+                index_t top = Stride * h - Padding;
+                bool rows_inside = top >= 0 && top + Window <= s.in_height;
+                for (index_t w = 0; w < s.out_width; ++w) {
+                    index_t left = Stride * w - Padding;
+                    bool inside = rows_inside && left >= 0 &&
+                        left + Window <= s.in_width;
+                    float* cell = output + s.count * (w + s.out_width * h);
+                    for (index_t o = s.first; o < s.first + s.count; ++o) {
+                        const float* in = s.input + o / s.out_group * s.in_group;
+                        float sum = 0;
+                        for (int z = 0; z < Window; ++z) {
+                            for (int y = 0; y < Window; ++y) {
+                                if (!inside &&
+                                    (top + z < 0 || top + z >= s.in_height ||
+                                     left + y < 0 || left + y >= s.in_width))
+                                    continue;
+                                const float* a = in + s.in_depth *
+                                    (left + y + s.in_width * (top + z));
+                                const float* b = s.kernels[o] +
+                                    s.in_group * (y + Window * z);
+                                for (index_t d = 0; d < s.in_group; ++d)
+                                    sum += a[d] * b[d];
+                            }
+                        }
+                        cell[o - s.first] = transfer_fn->forward(sum + thresholds[o]);
+                    }
+                }
+            }
+        }
+
+        ///
+        /// Backward pass of a direct convolution of fixed shape, see
+        /// direct_fixed(). Cells of zero gradient are skipped.
+        /// @param grad gradient of output before the transfer function
+        ///
+        template<int Window, int Padding, int Stride>
+        void direct_fixed_backward(const DirectShape & s, const float* grad,
+                                   float* input_grad,
+                                   float* const* kernel_grads) {
+            for (index_t h = 0; h < s.out_height; ++h) {
+                index_t top = Stride * h - Padding;
+                bool rows_inside = top >= 0 && top + Window <= s.in_height;
+                for (index_t w = 0; w < s.out_width; ++w) {
+                    index_t left = Stride * w - Padding;
+                    bool inside = rows_inside && left >= 0 &&
+                        left + Window <= s.in_width;
+                    const float* cell = grad + s.count * (w + s.out_width * h);
+                    for (index_t o = s.first; o < s.first + s.count; ++o) {
+                        float g = cell[o - s.first];
+                        if (g == 0)
+                            continue;
+                        index_t in = o / s.out_group * s.in_group;
+                        for (int z = 0; z < Window; ++z) {
+                            for (int y = 0; y < Window; ++y) {
+                                if (!inside &&
+                                    (top + z < 0 || top + z >= s.in_height ||
+                                     left + y < 0 || left + y >= s.in_width))
+                                    continue;
+                                index_t tap = in + s.in_depth *
+                                    (left + y + s.in_width * (top + z));
+                                index_t k = s.in_group * (y + Window * z);
+                                const float* a = s.input + tap;
+                                float* a_grad = input_grad + tap;
+                                const float* b = s.kernels[o] + k;
+                                float* b_grad = kernel_grads[o] + k;
+                                for (index_t d = 0; d < s.in_group; ++d) {
+                                    b_grad[d] += g * a[d];
+                                    a_grad[d] += g * b[d];
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        /// Shape of a specialized direct convolution.
+        struct DirectKernel {
+            index_t window, padding, stride;
+            void (*forward)(const DirectShape &, const float*, TransferFn*,
+                            float*);
+            void (*backward)(const DirectShape &, const float*, float*,
+                             float* const*);
+        };
+
+#define NEURAL_LIB_DIRECT(W, P, S) \
+        {W, P, S, direct_fixed<W, P, S>, direct_fixed_backward<W, P, S>}
+
+        /// Window, padding and stride of common convolutions.
+        const DirectKernel direct_kernels[] = {
+            NEURAL_LIB_DIRECT(1, 0, 1),
+            NEURAL_LIB_DIRECT(3, 0, 1),
+            NEURAL_LIB_DIRECT(3, 1, 1),
+            NEURAL_LIB_DIRECT(3, 1, 2),
+            NEURAL_LIB_DIRECT(5, 0, 1),
+            NEURAL_LIB_DIRECT(5, 2, 1),
+            NEURAL_LIB_DIRECT(7, 3, 2)
+        };
+
+#undef NEURAL_LIB_DIRECT
+
+        /// Specialized kernel for the shape, nullptr if there is none.
+        const DirectKernel* direct_kernel(index_t window, index_t padding,
+                                          index_t stride) {
+            for (const DirectKernel & k : direct_kernels) {
+                if (k.window == window && k.padding == padding &&
+                    k.stride == stride)
+                    return &k;
+            }
+            return nullptr;
+        }
+
+    } // namespace
+
+    bool Conv::specialized = true;
+
     Conv::Conv(std::string name, std::string fn_name, block_ptr input, 
-               uint16_t output_depth,
-               uint16_t window_size, uint16_t padding_size, uint16_t stride):
+               index_t output_depth,
+               index_t window_size, index_t padding_size, index_t stride,
+               index_t groups):
         Op(name), input(input),
         window_size(window_size), padding_size(padding_size), stride(stride), 
-        transfer_fn(TransferFns::get(fn_name)) {
+        groups(groups), transfer_fn(TransferFns::get(fn_name)) {
 
         init(output_depth);
 
     }
 
     Conv::Conv(std::string name, std::string fn_name, Op & op, 
-               uint16_t output_depth,
-               uint16_t window_size, uint16_t padding_size, uint16_t stride):
+               index_t output_depth,
+               index_t window_size, index_t padding_size, index_t stride,
+               index_t groups):
         Op(name), 
         window_size(window_size), padding_size(padding_size), stride(stride), 
-        transfer_fn(TransferFns::get(fn_name)) {
+        groups(groups), transfer_fn(TransferFns::get(fn_name)) {
         
         if (op.outputs().size() != 1)
             throw nl::InputException();
@@ -29,7 +259,7 @@ namespace nl {
 
     }
 
-    void Conv::init(uint16_t output_depth) {
+    void Conv::init(index_t output_depth) {
 
         if (input == nullptr)
             throw nl::InputException();
@@ -42,8 +272,14 @@ namespace nl {
         if (padding_size >= window_size)
             throw nl::InputException();
 
-        uint16_t padded_width = input_dims[1] + 2 * padding_size;
-        uint16_t padded_height = input_dims[2] + 2 * padding_size;
+        // groups have to split depth of input and output evenly
+        if (groups < 1 || 
+            input_dims[0] % groups != 0 || 
+            output_depth % groups != 0)
+            throw nl::InputException();
+
+        index_t padded_width = input_dims[1] + 2 * padding_size;
+        index_t padded_height = input_dims[2] + 2 * padding_size;
 
         // window is greater than observed area in at least one dim.
         if (window_size > padded_width ||
@@ -57,8 +293,8 @@ namespace nl {
             throw nl::InputException();            
 
         // number of strides taken + 1
-        uint16_t output_width = ((padded_width - window_size) / stride) + 1;
-        uint16_t output_height = ((padded_height - window_size) / stride) + 1;
+        index_t output_width = ((padded_width - window_size) / stride) + 1;
+        index_t output_height = ((padded_height - window_size) / stride) + 1;
 
         // create output block
         output = std::make_shared<Block>(name + "_out", 
@@ -67,11 +303,11 @@ namespace nl {
                                          output_height);
 
         // create weights 
-        for (uint16_t d = 0; d < output_depth; d++) {
+        for (index_t d = 0; d < output_depth; d++) {
             WeightPair p;
             p.kernel = std::make_shared<Block>(name + "_w" 
                                                + std::to_string(d),
-                                               input_dims[0],
+                                               input_dims[0] / groups,
                                                window_size,
                                                window_size);
             Generator::init_random(p.kernel);
@@ -89,46 +325,949 @@ namespace nl {
 
     }
 
-    void Conv::forward() { 
+    void Conv::forward() {
+        switch (selected()) {
+        case DEPTHWISE:
+            forward_depthwise();
+            break;
+        case GEMM:
+        case IM2COL:
+            forward_gemm();
+            break;
+        case WINOGRAD:
+            forward_winograd();
+            break;
+        case FOURIER:
+            forward_fft();
+            break;
+        default:
+            forward_direct();
+        }
+    }
+
+    void Conv::backward() {
+        switch (selected()) {
+        case DEPTHWISE:
+            backward_depthwise();
+            break;
+        case GEMM:
+        case IM2COL:
+            backward_gemm();
+            break;
+        case WINOGRAD:
+            backward_winograd();
+            break;
+        case FOURIER:
+            backward_fft();
+            break;
+        default:
+            backward_direct();
+        }
+    }
+
+    void Conv::setAlgorithm(std::string name) {
+        Algorithm a = algorithm_of(name);
+        if (!applicable(a))
+            throw InputException();
+        algorithm = a;
+    }
+
+    Conv::Algorithm Conv::algorithm_of(const std::string & name) {
+        for (std::size_t a = 0; a < algorithm_names.size(); ++a) {
+            if (name == algorithm_names[a])
+                return (Algorithm) a;
+        }
+        throw UnknownOptionException();
+    }
+
+    bool Conv::applicable(Algorithm a) {
+        switch (a) {
+        case DEPTHWISE:
+            return is_depthwise();
+        case GEMM:
+            return is_pointwise();
+        case WINOGRAD:
+            return is_winograd();
+        case FOURIER:
+            return is_fft();
+        default:
+            return true;
+        }
+    }
+
+    bool Conv::is_depthwise() {
+        return groups == input->dimensions()[0] &&
+            groups == output->dimensions()[0];
+    }
+
+    bool Conv::is_pointwise() {
+        return window_size == 1 && stride == 1 && padding_size == 0;
+    }
+
+    bool Conv::is_winograd() {
+        return window_size == 3 && stride == 1 && groups == 1;
+    }
+
+    bool Conv::is_fft() {
+        return stride == 1 && groups == 1;
+    }
+
+    Conv::Algorithm Conv::selected() {
+        if (algorithm != AUTO)
+            return algorithm;
+        if (Autotuner::enabled()) {
+            if (tuned == AUTO)
+                tune();
+            return tuned;
+        }
+        if (is_pointwise())
+            return GEMM;
+        if (is_depthwise())
+            return DEPTHWISE;
+        return IM2COL;
+    }
+
+    std::string Conv::tuning_key() {
+        auto in_dims = input->dimensions();
+        return "Conv " + std::to_string(in_dims[0]) + "x" + 
+            std::to_string(in_dims[1]) + "x" + std::to_string(in_dims[2]) +
+            " depth " + std::to_string(output->dimensions()[0]) +
+            " window " + std::to_string(window_size) +
+            " padding " + std::to_string(padding_size) +
+            " stride " + std::to_string(stride) +
+            " groups " + std::to_string(groups);
+    }
+
+    void Conv::tune() {
+
+        // cached result is trusted only if it still names a kernel
+        // applicable to this convolution
+        std::string key = tuning_key();
+        std::string name = Autotuner::lookup(key);
+        for (std::size_t a = 1; a < algorithm_names.size(); ++a) {
+            if (name == algorithm_names[a] && applicable((Algorithm) a)) {
+                tuned = (Algorithm) a;
+                return;
+            }
+        }
+
+        // measured passes must not change anything visible outside,
+        // output gradient is fixed so that its values do not matter
+        std::vector<std::pair<block_ptr, Eigen::Tensor<float, 3>>> grads;
+        for (auto & block_pair : inputs()) {
+            grads.emplace_back(block_pair.second, block_pair.second->grad);
+        }
+        Eigen::Tensor<float, 3> out_data = output->data;
+        Eigen::Tensor<float, 3> out_grad = output->grad;
+        output->grad.setConstant(1);
+
+        // the slowest candidate goes last, so that it is usually given up
+        // after a single run
+        double best = std::numeric_limits<double>::infinity();
+        tuned = DIRECT;
+        for (Algorithm a : {GEMM, DEPTHWISE, WINOGRAD, FOURIER, IM2COL, DIRECT}) {
+            if (!applicable(a))
+                continue;
+            algorithm = a;
+            double time = Autotuner::measure([this] {
+                    forward();
+                    backward();
+                }, best);
+            if (time < best) {
+                best = time;
+                tuned = a;
+            }
+        }
+        algorithm = AUTO;
+
+        for (auto & grad : grads) {
+            grad.first->grad = grad.second;
+        }
+        output->data = out_data;
+        output->grad = out_grad;
+
+        Autotuner::record(key, algorithm_names[tuned]);
+    }
+
+    bool Conv::forward_fixed(float* out, index_t first, index_t count) {
+
+        const DirectKernel* k = direct_kernel(window_size, padding_size, stride);
+        if (!specialized || k == nullptr)
+            return false;
+
+        auto in_dims = input->dimensions();
+        auto out_dims = output->dimensions();
+        std::vector<const float*> kernels;
+        std::vector<float> thresholds;
+        for (const WeightPair & p : weights) {
+            kernels.push_back(p.kernel->data.data());
+            thresholds.push_back(p.threshold->data(0,0,0));
+        }
+        DirectShape s = {
+            input->data.data(), in_dims[0], in_dims[1], in_dims[2],
+            out_dims[1], out_dims[2], in_dims[0] / groups, out_dims[0] / groups,
+            first, count, kernels.data()
+        };
+        k->forward(s, thresholds.data(), transfer_fn, out);
+        return true;
+    }
+
+    bool Conv::backward_fixed(const float* grad, index_t first, index_t count) {
+
+        const DirectKernel* k = direct_kernel(window_size, padding_size, stride);
+        if (!specialized || k == nullptr)
+            return false;
+
+        auto in_dims = input->dimensions();
+        auto out_dims = output->dimensions();
+        std::vector<const float*> kernels;
+        std::vector<float*> kernel_grads;
+        for (const WeightPair & p : weights) {
+            kernels.push_back(p.kernel->data.data());
+            kernel_grads.push_back(p.kernel->grad.data());
+        }
+        DirectShape s = {
+            input->data.data(), in_dims[0], in_dims[1], in_dims[2],
+            out_dims[1], out_dims[2], in_dims[0] / groups, out_dims[0] / groups,
+            first, count, kernels.data()
+        };
+        k->backward(s, grad, input->grad.data(), kernel_grads.data());
+        return true;
+    }
+
+    void Conv::forward_direct() {
+
+        auto out_dims = output->dimensions();
+        if (forward_fixed(output->data.data(), 0, out_dims[0]))
+            return;
 
         // specify cell in output block that is being computed.
-        for (uint16_t x = 0; x < output->dimensions()[0]; ++x) {
+        for (index_t x = 0; x < out_dims[0]; ++x) {
 
-            WeightPair p = weights[x];
+            float threshold = weights[x].threshold->data(0,0,0);
 
-            for (uint16_t y = 0; y < output->dimensions()[1]; ++y) {
-                for (uint16_t z = 0; z < output->dimensions()[2]; ++z) {
-                    float result = 0;
-                    // compute weighted sum
-                    result = weighted_sum(x,y,z);
-                    // add threshold
-                    result += p.threshold->data(0,0,0);
-                    // apply transfer function
-                    output->data(x,y,z) = transfer_fn->forward(result);
+            for (index_t y = 0; y < out_dims[1]; ++y) {
+                for (index_t z = 0; z < out_dims[2]; ++z) {
+                    // weighted sum, threshold and transfer function
+                    output->data(x,y,z) = 
+                        transfer_fn->forward(weighted_sum(x,y,z) + threshold);
                 }
             }
         }
 
     }
 
-    void Conv::backward() { 
+    void Conv::backward_direct() {
+
+        auto out_dims = output->dimensions();
+        index_t depth = out_dims[0];
+
+        // gradient before transfer function, in layout of output block
+        const float* out = output->data.data();
+        const float* out_grad = output->grad.data();
+        std::vector<float> grad(output->data.size());
+        std::vector<float> threshold_grads(depth, 0);
+        for (std::size_t i = 0; i < grad.size(); ++i) {
+            grad[i] = out_grad[i] * transfer_fn->backward(out[i]);
+            threshold_grads[i % depth] += grad[i];
+        }
+        for (index_t x = 0; x < depth; ++x) {
+            weights[x].threshold->grad(0,0,0) += threshold_grads[x];
+        }
+
+        if (backward_fixed(grad.data(), 0, depth))
+            return;
 
         // propagate gradient for each output cell
-        for (uint16_t x = 0; x < output->dimensions()[0]; ++x) {
+        for (index_t x = 0; x < depth; ++x) {
+            for (index_t y = 0; y < out_dims[1]; ++y) {
+                for (index_t z = 0; z < out_dims[2]; ++z) {
+                    grad_window_update(grad[x + depth * (y + out_dims[1] * z)],
+                                       x, y, z);
+                }
+            }
+        }
+
+    }
+
+    void Conv::forward_depthwise() {
+
+        auto in_dims = input->dimensions();
+        auto out_dims = output->dimensions();
+        index_t depth = in_dims[0];
+
+        // kernels with depth slices next to each other, so that 
+        // innermost loops run over contiguous memory
+        std::vector<float> kernels(window_size * window_size * depth);
+        for (index_t d = 0; d < depth; ++d) {
+            for (index_t z = 0; z < window_size; ++z) {
+                for (index_t y = 0; y < window_size; ++y) {
+                    kernels[(y + window_size * z) * depth + d] = 
+                        weights[d].kernel->data(0,y,z);
+                }
+            }
+        }
+
+        const float* in = input->data.data();
+        float* out = output->data.data();
+        std::vector<float> sum(depth);
+
+        for (index_t h = 0; h < out_dims[2]; ++h) {
+            for (index_t w = 0; w < out_dims[1]; ++w) {
+
+                std::fill(sum.begin(), sum.end(), 0);
+                for (index_t y = 0; y < window_size; ++y) {
+                    index_t i_y = stride * w + y - padding_size;
+                    if (i_y < 0 || i_y >= in_dims[1])
+                        continue;
+                    for (index_t z = 0; z < window_size; ++z) {
+                        index_t i_z = stride * h + z - padding_size;
+                        if (i_z < 0 || i_z >= in_dims[2])
+                            continue;
+
+                        const float* __restrict__ cell = 
+                            in + depth * (i_y + in_dims[1] * i_z);
+                        const float* __restrict__ kernel = 
+                            &kernels[(y + window_size * z) * depth];
+                        float* __restrict__ acc = sum.data();
+                        for (index_t d = 0; d < depth; ++d) {
+                            acc[d] += kernel[d] * cell[d];
+                        }
+                    }
+                }
+
+                float* result = out + depth * (w + out_dims[1] * h);
+                for (index_t d = 0; d < depth; ++d) {
+                    result[d] = transfer_fn->forward(
+                        sum[d] + weights[d].threshold->data(0,0,0));
+                }
+            }
+        }
+
+    }
+
+    void Conv::backward_depthwise() {
+
+        auto in_dims = input->dimensions();
+        auto out_dims = output->dimensions();
+        index_t depth = in_dims[0];
+
+        // kernels and their gradient in the same layout as in forward pass
+        std::vector<float> kernels(window_size * window_size * depth);
+        std::vector<float> kernel_grads(kernels.size(), 0);
+        for (index_t d = 0; d < depth; ++d) {
+            for (index_t z = 0; z < window_size; ++z) {
+                for (index_t y = 0; y < window_size; ++y) {
+                    kernels[(y + window_size * z) * depth + d] = 
+                        weights[d].kernel->data(0,y,z);
+                }
+            }
+        }
+
+        const float* in = input->data.data();
+        float* in_grad = input->grad.data();
+        const float* out = output->data.data();
+        const float* out_grad = output->grad.data();
+        std::vector<float> grad(depth), threshold_grads(depth, 0);
 
-            WeightPair p = weights[x];
+        for (index_t h = 0; h < out_dims[2]; ++h) {
+            for (index_t w = 0; w < out_dims[1]; ++w) {
 
-            for (uint16_t y = 0; y < output->dimensions()[1]; ++y) {
-                for (uint16_t z = 0; z < output->dimensions()[2]; ++z) {
+                // gradient before transfer function
+                index_t offset = depth * (w + out_dims[1] * h);
+                for (index_t d = 0; d < depth; ++d) {
+                    grad[d] = out_grad[offset + d] * 
+                        transfer_fn->backward(out[offset + d]);
+                    threshold_grads[d] += grad[d];
+                }
 
-                    float grad = output->grad(x,y,z) * 
-                        transfer_fn->backward(output->data(x,y,z));
-                    
-                    grad_window_update(grad, x, y, z);
+                for (index_t y = 0; y < window_size; ++y) {
+                    index_t i_y = stride * w + y - padding_size;
+                    if (i_y < 0 || i_y >= in_dims[1])
+                        continue;
+                    for (index_t z = 0; z < window_size; ++z) {
+                        index_t i_z = stride * h + z - padding_size;
+                        if (i_z < 0 || i_z >= in_dims[2])
+                            continue;
 
-                    // update threshold gradient
-                    p.threshold->grad(0,0,0) += grad;
+                        index_t cell = depth * (i_y + in_dims[1] * i_z);
+                        index_t tap = (y + window_size * z) * depth;
+                        const float* __restrict__ g = grad.data();
+                        const float* __restrict__ signal = in + cell;
+                        const float* __restrict__ kernel = &kernels[tap];
+                        float* __restrict__ signal_grad = in_grad + cell;
+                        float* __restrict__ kernel_grad = &kernel_grads[tap];
+                        for (index_t d = 0; d < depth; ++d) {
+                            kernel_grad[d] += g[d] * signal[d];
+                            signal_grad[d] += g[d] * kernel[d];
+                        }
+                    }
+                }
+            }
+        }
 
+        for (index_t d = 0; d < depth; ++d) {
+            for (index_t z = 0; z < window_size; ++z) {
+                for (index_t y = 0; y < window_size; ++y) {
+                    weights[d].kernel->grad(0,y,z) += 
+                        kernel_grads[(y + window_size * z) * depth + d];
+                }
+            }
+            weights[d].threshold->grad(0,0,0) += threshold_grads[d];
+        }
+
+    }
+
+    void Conv::forward_gemm() {
+
+        // input and output blocks are matrices with a column for every
+        // cell of a depth slice, each group multiplies its rows; larger
+        // windows are lowered first
+        index_t in_depth = input->dimensions()[0];
+        index_t out_depth = output->dimensions()[0];
+        index_t in_group = in_depth / groups;
+        index_t out_group = out_depth / groups;
+        index_t rows = in_group * window_size * window_size;
+        index_t cells = output->dimensions()[1] * output->dimensions()[2];
+        std::vector<float> columns;
+
+        for (index_t g = 0; g < groups; ++g) {
+            Matrix kernels(out_group, rows);
+            for (index_t o = 0; o < out_group; ++o) {
+                kernels.row(o) = RowMap(
+                    weights[g * out_group + o].kernel->data.data(), rows);
+            }
+
+            MatrixMap out(output->data.data() + g * out_group, out_group, cells,
+                          Eigen::OuterStride<>(out_depth));
+
+            if (is_pointwise()) {
+                MatrixMap in(input->data.data() + g * in_group, in_group, cells,
+                             Eigen::OuterStride<>(in_depth));
+                out.noalias() = kernels * in;
+            } else {
+                im2col(g, columns);
+                out.noalias() = kernels * 
+                    Eigen::Map<const Matrix>(columns.data(), rows, cells);
+            }
+            for (index_t o = 0; o < out_group; ++o) {
+                float threshold = weights[g * out_group + o].threshold->data(0,0,0);
+                for (index_t c = 0; c < cells; ++c) {
+                    out(o, c) = transfer_fn->forward(out(o, c) + threshold);
+                }
+            }
+        }
+
+    }
+
+    void Conv::backward_gemm() {
+
+        index_t in_depth = input->dimensions()[0];
+        index_t out_depth = output->dimensions()[0];
+        index_t in_group = in_depth / groups;
+        index_t out_group = out_depth / groups;
+        index_t rows = in_group * window_size * window_size;
+        index_t cells = output->dimensions()[1] * output->dimensions()[2];
+        std::vector<float> columns;
+
+        for (index_t g = 0; g < groups; ++g) {
+            Matrix kernels(out_group, rows);
+            for (index_t o = 0; o < out_group; ++o) {
+                kernels.row(o) = RowMap(
+                    weights[g * out_group + o].kernel->data.data(), rows);
+            }
+
+            MatrixMap out(output->data.data() + g * out_group, out_group, cells,
+                          Eigen::OuterStride<>(out_depth));
+            MatrixMap out_grad(output->grad.data() + g * out_group, out_group,
+                               cells, Eigen::OuterStride<>(out_depth));
+
+            // gradient before transfer function
+            Matrix grad(out_group, cells);
+            for (index_t c = 0; c < cells; ++c) {
+                for (index_t o = 0; o < out_group; ++o) {
+                    grad(o, c) = out_grad(o, c) * transfer_fn->backward(out(o, c));
+                }
+            }
+
+            Matrix kernel_grads;
+            if (is_pointwise()) {
+                MatrixMap in(input->data.data() + g * in_group, in_group, cells,
+                             Eigen::OuterStride<>(in_depth));
+                MatrixMap in_grad(input->grad.data() + g * in_group, in_group,
+                                  cells, Eigen::OuterStride<>(in_depth));
+                kernel_grads = grad * in.transpose();
+                in_grad.noalias() += kernels.transpose() * grad;
+            } else {
+                im2col(g, columns);
+                Eigen::Map<Matrix> lowered(columns.data(), rows, cells);
+                kernel_grads = grad * lowered.transpose();
+                // lowered input is not needed any more
+                lowered.noalias() = kernels.transpose() * grad;
+                col2im(g, columns.data());
+            }
+
+            for (index_t o = 0; o < out_group; ++o) {
+                WeightPair & p = weights[g * out_group + o];
+                float* kernel_grad = p.kernel->grad.data();
+                for (index_t r = 0; r < rows; ++r) {
+                    kernel_grad[r] += kernel_grads(o, r);
+                }
+                p.threshold->grad(0,0,0) += grad.row(o).sum();
+            }
+        }
+
+    }
+
+    void Conv::update_winograd_filters() {
+
+        if (!kernels_changed(winograd_source))
+            return;
+
+        index_t in_depth = input->dimensions()[0];
+        index_t out_depth = output->dimensions()[0];
+
+        winograd_filters.resize(16 * out_depth * in_depth);
+        float g[9], u[16];
+        for (index_t o = 0; o < out_depth; ++o) {
+            for (index_t i = 0; i < in_depth; ++i) {
+                for (index_t y = 0; y < 3; ++y) {
+                    for (index_t z = 0; z < 3; ++z) {
+                        g[y * 3 + z] = weights[o].kernel->data(i,y,z);
+                    }
+                }
+                transform<3, 4>(g, u, filter_transform);
+                for (index_t t = 0; t < 16; ++t) {
+                    winograd_filters[(t * in_depth + i) * out_depth + o] = u[t];
+                }
+            }
+        }
+
+    }
+
+    void Conv::winograd_tiles(std::vector<float> & tiles) {
+
+        auto in_dims = input->dimensions();
+        auto out_dims = output->dimensions();
+        index_t depth = in_dims[0];
+        index_t tiles_y = (out_dims[1] + 1) / 2;
+        index_t tiles_z = (out_dims[2] + 1) / 2;
+        index_t count = tiles_y * tiles_z;
+
+        tiles.resize(16 * depth * count);
+        float d[16], v[16];
+        for (index_t tz = 0; tz < tiles_z; ++tz) {
+            for (index_t ty = 0; ty < tiles_y; ++ty) {
+                index_t tile = ty + tiles_y * tz;
+                for (index_t i = 0; i < depth; ++i) {
+
+                    // cells of padding and behind the last tile are zero
+                    for (index_t y = 0; y < 4; ++y) {
+                        index_t i_y = 2 * ty + y - padding_size;
+                        for (index_t z = 0; z < 4; ++z) {
+                            index_t i_z = 2 * tz + z - padding_size;
+                            bool inside = i_y >= 0 && i_y < in_dims[1] &&
+                                i_z >= 0 && i_z < in_dims[2];
+                            d[y * 4 + z] = inside ? input->data(i,i_y,i_z) : 0;
+                        }
+                    }
+
+                    transform<4, 4>(d, v, input_transform);
+                    for (index_t t = 0; t < 16; ++t) {
+                        tiles[(t * count + tile) * depth + i] = v[t];
+                    }
+                }
+            }
+        }
+
+    }
+
+    void Conv::forward_winograd() {
+
+        auto out_dims = output->dimensions();
+        index_t in_depth = input->dimensions()[0];
+        index_t out_depth = out_dims[0];
+        index_t tiles_y = (out_dims[1] + 1) / 2;
+        index_t tiles_z = (out_dims[2] + 1) / 2;
+        index_t count = tiles_y * tiles_z;
+
+        update_winograd_filters();
+        std::vector<float> tiles;
+        winograd_tiles(tiles);
+
+        // sums over input depth are independent for each of 16 elements
+        // of transformed tile, so each of them is a matrix product
+        std::vector<Matrix> products(16);
+        for (index_t t = 0; t < 16; ++t) {
+            Eigen::Map<const Matrix> u(&winograd_filters[t * in_depth * out_depth],
+                                       out_depth, in_depth);
+            Eigen::Map<const Matrix> v(&tiles[t * in_depth * count],
+                                       in_depth, count);
+            products[t].noalias() = u * v;
+        }
+
+        float m[16], y[4];
+        for (index_t tz = 0; tz < tiles_z; ++tz) {
+            for (index_t ty = 0; ty < tiles_y; ++ty) {
+                index_t tile = ty + tiles_y * tz;
+                for (index_t o = 0; o < out_depth; ++o) {
+                    for (index_t t = 0; t < 16; ++t) {
+                        m[t] = products[t](o, tile);
+                    }
+                    transform<4, 2>(m, y, output_transform);
+
+                    float threshold = weights[o].threshold->data(0,0,0);
+                    for (index_t a = 0; a < 2 && 2 * ty + a < out_dims[1]; ++a) {
+                        for (index_t b = 0; b < 2 && 2 * tz + b < out_dims[2]; ++b) {
+                            output->data(o, 2 * ty + a, 2 * tz + b) = 
+                                transfer_fn->forward(y[a * 2 + b] + threshold);
+                        }
+                    }
+                }
+            }
+        }
+
+    }
+
+    void Conv::backward_winograd() {
+
+        auto in_dims = input->dimensions();
+        auto out_dims = output->dimensions();
+        index_t in_depth = in_dims[0];
+        index_t out_depth = out_dims[0];
+        index_t tiles_y = (out_dims[1] + 1) / 2;
+        index_t tiles_z = (out_dims[2] + 1) / 2;
+        index_t count = tiles_y * tiles_z;
+
+        // gradient before transfer function, carried back through output
+        // transform, cells behind the last tile have no gradient
+        std::vector<Matrix> products(16, Matrix(out_depth, count));
+        float g[4], m[16];
+        for (index_t tz = 0; tz < tiles_z; ++tz) {
+            for (index_t ty = 0; ty < tiles_y; ++ty) {
+                index_t tile = ty + tiles_y * tz;
+                for (index_t o = 0; o < out_depth; ++o) {
+                    float threshold_grad = 0;
+                    for (index_t a = 0; a < 2; ++a) {
+                        for (index_t b = 0; b < 2; ++b) {
+                            index_t w = 2 * ty + a;
+                            index_t h = 2 * tz + b;
+                            g[a * 2 + b] = 0;
+                            if (w < out_dims[1] && h < out_dims[2]) {
+                                g[a * 2 + b] = output->grad(o,w,h) * 
+                                    transfer_fn->backward(output->data(o,w,h));
+                                threshold_grad += g[a * 2 + b];
+                            }
+                        }
+                    }
+                    weights[o].threshold->grad(0,0,0) += threshold_grad;
+
+                    transform<2, 4>(g, m, output_adjoint);
+                    for (index_t t = 0; t < 16; ++t) {
+                        products[t](o, tile) = m[t];
+                    }
+                }
+            }
+        }
+
+        update_winograd_filters();
+        std::vector<float> tiles;
+        winograd_tiles(tiles);
+
+        // gradient of transformed filters and tiles, elementwise products
+        // of forward pass turn into matrix products again
+        std::vector<float> filter_grads(16 * out_depth * in_depth);
+        for (index_t t = 0; t < 16; ++t) {
+            Eigen::Map<const Matrix> u(&winograd_filters[t * in_depth * out_depth],
+                                       out_depth, in_depth);
+            Eigen::Map<Matrix> v(&tiles[t * in_depth * count], in_depth, count);
+            Eigen::Map<Matrix> u_grad(&filter_grads[t * in_depth * out_depth],
+                                      out_depth, in_depth);
+            u_grad.noalias() = products[t] * v.transpose();
+            // transformed tiles are not needed any more
+            v = u.transpose() * products[t];
+        }
+
+        float u[16], k[9];
+        for (index_t o = 0; o < out_depth; ++o) {
+            for (index_t i = 0; i < in_depth; ++i) {
+                for (index_t t = 0; t < 16; ++t) {
+                    u[t] = filter_grads[(t * in_depth + i) * out_depth + o];
+                }
+                transform<4, 3>(u, k, filter_adjoint);
+                for (index_t y = 0; y < 3; ++y) {
+                    for (index_t z = 0; z < 3; ++z) {
+                        weights[o].kernel->grad(i,y,z) += k[y * 3 + z];
+                    }
+                }
+            }
+        }
+
+        // tiles overlap, so cells of input receive gradient from several
+        float v[16], d[16];
+        for (index_t tz = 0; tz < tiles_z; ++tz) {
+            for (index_t ty = 0; ty < tiles_y; ++ty) {
+                index_t tile = ty + tiles_y * tz;
+                for (index_t i = 0; i < in_depth; ++i) {
+                    for (index_t t = 0; t < 16; ++t) {
+                        v[t] = tiles[(t * count + tile) * in_depth + i];
+                    }
+                    transform<4, 4>(v, d, input_adjoint);
+
+                    for (index_t y = 0; y < 4; ++y) {
+                        index_t i_y = 2 * ty + y - padding_size;
+                        if (i_y < 0 || i_y >= in_dims[1])
+                            continue;
+                        for (index_t z = 0; z < 4; ++z) {
+                            index_t i_z = 2 * tz + z - padding_size;
+                            if (i_z < 0 || i_z >= in_dims[2])
+                                continue;
+                            input->grad(i,i_y,i_z) += d[y * 4 + z];
+                        }
+                    }
+                }
+            }
+        }
+
+    }
+
+    void Conv::im2col(index_t g, std::vector<float> & columns) {
+
+        auto in_dims = input->dimensions();
+        auto out_dims = output->dimensions();
+        index_t in_group = in_dims[0] / groups;
+        index_t rows = in_group * window_size * window_size;
+        columns.resize(rows * out_dims[1] * out_dims[2]);
+
+        // depth is the fastest dimension of both input and kernels, so 
+        // every tap of a window copies a contiguous run of input
+        const float* in = input->data.data() + g * in_group;
+        for (index_t h = 0; h < out_dims[2]; ++h) {
+            for (index_t w = 0; w < out_dims[1]; ++w) {
+                float* column = &columns[rows * (w + out_dims[1] * h)];
+                for (index_t z = 0; z < window_size; ++z) {
+                    index_t i_z = stride * h + z - padding_size;
+                    for (index_t y = 0; y < window_size; ++y) {
+                        index_t i_y = stride * w + y - padding_size;
+                        float* tap = column + in_group * (y + window_size * z);
+                        if (i_y < 0 || i_y >= in_dims[1] || 
+                            i_z < 0 || i_z >= in_dims[2])
+                            std::fill(tap, tap + in_group, 0.0f);
+                        else
+                            std::memcpy(tap, in + in_dims[0] * (i_y + in_dims[1] * i_z),
+                                        in_group * sizeof(float));
+                    }
+                }
+            }
+        }
+
+    }
+
+    void Conv::col2im(index_t g, const float* columns) {
+
+        auto in_dims = input->dimensions();
+        auto out_dims = output->dimensions();
+        index_t in_group = in_dims[0] / groups;
+        index_t rows = in_group * window_size * window_size;
+
+        float* in_grad = input->grad.data() + g * in_group;
+        for (index_t h = 0; h < out_dims[2]; ++h) {
+            for (index_t w = 0; w < out_dims[1]; ++w) {
+                const float* column = columns + rows * (w + out_dims[1] * h);
+                for (index_t z = 0; z < window_size; ++z) {
+                    index_t i_z = stride * h + z - padding_size;
+                    if (i_z < 0 || i_z >= in_dims[2])
+                        continue;
+                    for (index_t y = 0; y < window_size; ++y) {
+                        index_t i_y = stride * w + y - padding_size;
+                        if (i_y < 0 || i_y >= in_dims[1])
+                            continue;
+                        const float* tap = column + in_group * (y + window_size * z);
+                        float* cell = in_grad + in_dims[0] * (i_y + in_dims[1] * i_z);
+                        for (index_t i = 0; i < in_group; ++i) {
+                            cell[i] += tap[i];
+                        }
+                    }
+                }
+            }
+        }
+
+    }
+
+    bool Conv::kernels_changed(std::vector<float> & source) {
+
+        // transforms are reused while no kernel value has changed, which
+        // is cheap to check compared to the convolution itself
+        bool changed = source.size() != 
+            weights.size() * weights[0].kernel->data.size();
+        std::size_t i = 0;
+        for (auto & p : weights) {
+            const float* kernel = p.kernel->data.data();
+            for (index_t j = 0; j < p.kernel->data.size() && !changed; ++j) {
+                changed = source[i + j] != kernel[j];
+            }
+            i += p.kernel->data.size();
+        }
+        if (!changed)
+            return false;
+
+        source.clear();
+        for (auto & p : weights) {
+            source.insert(source.end(), p.kernel->data.data(),
+                          p.kernel->data.data() + p.kernel->data.size());
+        }
+        return true;
+    }
+
+    index_t Conv::fft_width() {
+        return FFT::size(input->dimensions()[1] + 2 * padding_size);
+    }
+
+    index_t Conv::fft_height() {
+        return FFT::size(input->dimensions()[2] + 2 * padding_size);
+    }
+
+    void Conv::update_fft_filters() {
+
+        if (!kernels_changed(fft_source))
+            return;
+
+        index_t in_depth = input->dimensions()[0];
+        index_t width = fft_width();
+        index_t cells = width * fft_height();
+
+        // kernels start at origin of the transformed area
+        fft_filters.assign(weights.size() * in_depth * cells, 0);
+        for (std::size_t o = 0; o < weights.size(); ++o) {
+            for (index_t i = 0; i < in_depth; ++i) {
+                FFT::complex* filter = &fft_filters[(o * in_depth + i) * cells];
+                for (index_t z = 0; z < window_size; ++z) {
+                    for (index_t y = 0; y < window_size; ++y) {
+                        filter[y + width * z] = weights[o].kernel->data(i,y,z);
+                    }
+                }
+                FFT::transform(filter, width, fft_height(), false);
+            }
+        }
+
+    }
+
+    void Conv::fft_inputs(std::vector<FFT::complex> & spectra) {
+
+        auto in_dims = input->dimensions();
+        index_t width = fft_width();
+        index_t cells = width * fft_height();
+
+        // input is shifted by padding, the rest of the area is zero
+        spectra.assign(in_dims[0] * cells, 0);
+        for (index_t i = 0; i < in_dims[0]; ++i) {
+            FFT::complex* spectrum = &spectra[i * cells];
+            for (index_t z = 0; z < in_dims[2]; ++z) {
+                for (index_t y = 0; y < in_dims[1]; ++y) {
+                    spectrum[y + padding_size + width * (z + padding_size)] = 
+                        input->data(i,y,z);
+                }
+            }
+            FFT::transform(spectrum, width, fft_height(), false);
+        }
+
+    }
+
+    void Conv::forward_fft() {
+
+        auto out_dims = output->dimensions();
+        index_t in_depth = input->dimensions()[0];
+        index_t width = fft_width();
+        index_t height = fft_height();
+        index_t cells = width * height;
+
+        update_fft_filters();
+        std::vector<FFT::complex> inputs, sum(cells);
+        fft_inputs(inputs);
+
+        // correlation is product with complex conjugate of kernel, area
+        // is large enough for outputs not to wrap around
+        for (index_t o = 0; o < out_dims[0]; ++o) {
+            std::fill(sum.begin(), sum.end(), FFT::complex(0));
+            for (index_t i = 0; i < in_depth; ++i) {
+                FFT::multiply_add(&inputs[i * cells],
+                                  &fft_filters[(o * in_depth + i) * cells],
+                                  sum.data(), cells, true);
+            }
+            FFT::transform(sum.data(), width, height, true);
+
+            float threshold = weights[o].threshold->data(0,0,0);
+            for (index_t h = 0; h < out_dims[2]; ++h) {
+                for (index_t w = 0; w < out_dims[1]; ++w) {
+                    output->data(o,w,h) = transfer_fn->forward(
+                        sum[w + width * h].real() + threshold);
+                }
+            }
+        }
+
+    }
+
+    void Conv::backward_fft() {
+
+        auto in_dims = input->dimensions();
+        auto out_dims = output->dimensions();
+        index_t in_depth = in_dims[0];
+        index_t width = fft_width();
+        index_t height = fft_height();
+        index_t cells = width * height;
+
+        // gradient before transfer function starts at origin
+        std::vector<FFT::complex> grads(out_dims[0] * cells, 0);
+        for (index_t o = 0; o < out_dims[0]; ++o) {
+            FFT::complex* grad = &grads[o * cells];
+            float threshold_grad = 0;
+            for (index_t h = 0; h < out_dims[2]; ++h) {
+                for (index_t w = 0; w < out_dims[1]; ++w) {
+                    float g = output->grad(o,w,h) * 
+                        transfer_fn->backward(output->data(o,w,h));
+                    grad[w + width * h] = g;
+                    threshold_grad += g;
+                }
+            }
+            weights[o].threshold->grad(0,0,0) += threshold_grad;
+            FFT::transform(grad, width, height, false);
+        }
+
+        update_fft_filters();
+        std::vector<FFT::complex> inputs, sum(cells);
+        fft_inputs(inputs);
+
+        // input gradient is convolution of gradient with kernels, shifted
+        // back by padding
+        for (index_t i = 0; i < in_depth; ++i) {
+            std::fill(sum.begin(), sum.end(), FFT::complex(0));
+            for (index_t o = 0; o < out_dims[0]; ++o) {
+                FFT::multiply_add(&grads[o * cells],
+                                  &fft_filters[(o * in_depth + i) * cells],
+                                  sum.data(), cells, false);
+            }
+            FFT::transform(sum.data(), width, height, true);
+
+            for (index_t z = 0; z < in_dims[2]; ++z) {
+                for (index_t y = 0; y < in_dims[1]; ++y) {
+                    input->grad(i,y,z) += 
+                        sum[y + padding_size + width * (z + padding_size)].real();
+                }
+            }
+        }
+
+        // kernel gradient is correlation of padded input with gradient
+        for (index_t o = 0; o < out_dims[0]; ++o) {
+            for (index_t i = 0; i < in_depth; ++i) {
+                std::fill(sum.begin(), sum.end(), FFT::complex(0));
+                FFT::multiply_add(&inputs[i * cells], &grads[o * cells],
+                                  sum.data(), cells, true);
+                FFT::transform(sum.data(), width, height, true);
+
+                for (index_t z = 0; z < window_size; ++z) {
+                    for (index_t y = 0; y < window_size; ++y) {
+                        weights[o].kernel->grad(i,y,z) += sum[y + width * z].real();
+                    }
                 }
             }
         }
@@ -158,30 +1297,101 @@ namespace nl {
         return map; 
     }
 
-    float Conv::weighted_sum(uint16_t d, uint16_t w, uint16_t h) {
+    void Conv::share(const block_map & blocks) {
+        replace(input, blocks);
+        replace(output, blocks);
+        for (auto & p : weights) {
+            replace(p.kernel, blocks);
+            replace(p.threshold, blocks);
+        }
+    }
+
+    double Conv::window_taps() {
+
+        auto in_dims = input->dimensions();
+        auto out_dims = output->dimensions();
+
+        // number of window positions inside input along one dimension,
+        // summed over all positions of window
+        auto valid = [&](index_t in_size, index_t out_size) {
+            double count = 0;
+            for (index_t i = 0; i < out_size; ++i) {
+                index_t from = std::max<index_t>(stride * i - padding_size, 0);
+                index_t to = std::min<index_t>(stride * i - padding_size 
+                                               + window_size, in_size);
+                count += std::max<index_t>(to - from, 0);
+            }
+            return count;
+        };
+
+        return (double) out_dims[0] * in_dims[0] / groups *
+            valid(in_dims[1], out_dims[1]) * valid(in_dims[2], out_dims[2]);
+    }
+
+    Cost Conv::forward_cost() {
+        double in = input->data.size();
+        double out = output->data.size();
+        double kernels = weights.size() * weights[0].kernel->data.size();
+
+        // weighted sums over windows, threshold and transfer function
+        Cost c;
+        c.flops = 2 * window_taps() + 2 * out;
+        c.bytes_read = (in + kernels + weights.size()) * sizeof(float);
+        c.bytes_written = out * sizeof(float);
+        return c;
+    }
+
+    Cost Conv::backward_cost() {
+        double in = input->data.size();
+        double out = output->data.size();
+        double kernels = weights.size() * weights[0].kernel->data.size();
+
+        // transfer function, input and kernel gradient over windows
+        // and threshold gradient
+        Cost c;
+        c.flops = 4 * window_taps() + 3 * out;
+        c.bytes_read = (2 * out + 2 * kernels + 2 * in + weights.size()) 
+            * sizeof(float);
+        c.bytes_written = (kernels + in + weights.size()) * sizeof(float);
+        return c;
+    }
+
+    index_t Conv::group_begin(index_t d) {
+        index_t out_group = output->data.dimension(0) / groups;
+        index_t in_group = input->data.dimension(0) / groups;
+        return d / out_group * in_group;
+    }
+
+    float Conv::weighted_sum(index_t d, index_t w, index_t h) {
     
-        block_ptr kernel = weights[d].kernel;
+        const block_ptr & kernel = weights[d].kernel;
 
         // specify upper left corner of window in input block
-        uint16_t i_y = stride * w;
-        uint16_t i_z = stride * h;
+        index_t i_y = stride * w;
+        index_t i_z = stride * h;
+
+        // input depth slices of the group
+        index_t first = group_begin(d);
+        index_t in_group = kernel->data.dimension(0);
+        index_t in_width = input->data.dimension(1);
+        index_t in_height = input->data.dimension(2);
 
         float sum = 0;
         
-        for (uint16_t x = 0; x < input->dimensions()[0]; ++x) {
-            for (uint16_t y = 0; y < window_size; ++y) {
-                for (uint16_t z = 0; z < window_size; ++z) {    
+        for (index_t x = 0; x < in_group; ++x) {
+            for (index_t y = 0; y < window_size; ++y) {
+                for (index_t z = 0; z < window_size; ++z) {    
 
                     // skip if position is outside of input tensor
                     if (i_y + y - padding_size < 0 ||
                         i_z + z - padding_size < 0 ||
-                        i_y + y - padding_size >= input->dimensions()[1] ||
-                        i_y + y - padding_size >= input->dimensions()[2])
+                        i_y + y - padding_size >= in_width ||
+                        i_z + z - padding_size >= in_height)
                         continue;
 
                     sum +=
                         kernel->data(x,y,z) *
-                        input->data(x, 
+                        input->data(first + x, 
                                     i_y + y - padding_size,
                                     i_z + z - padding_size);
                 }
@@ -192,33 +1402,40 @@ namespace nl {
     
     }
 
-    void Conv::grad_window_update(float grad, uint16_t d, uint16_t w, uint16_t h) {
+    void Conv::grad_window_update(float grad, index_t d, index_t w, index_t h) {
 
-        block_ptr kernel = weights[d].kernel;
+        const block_ptr & kernel = weights[d].kernel;
 
         // specify upper left corner of window in input block
-        uint16_t i_y = stride * w;
-        uint16_t i_z = stride * h;
+        index_t i_y = stride * w;
+        index_t i_z = stride * h;
+
+        // input depth slices of the group
+        index_t first = group_begin(d);
+        index_t in_group = kernel->data.dimension(0);
+        index_t in_width = input->data.dimension(1);
+        index_t in_height = input->data.dimension(2);
         
-        for (uint16_t x = 0; x < input->dimensions()[0]; ++x) {
-            for (uint16_t y = 0; y < window_size; ++y) {
-                for (uint16_t z = 0; z < window_size; ++z) {    
+        for (index_t x = 0; x < in_group; ++x) {
+            for (index_t y = 0; y < window_size; ++y) {
+                for (index_t z = 0; z < window_size; ++z) {    
 
                     // skip if position is outside of input tensor
                     if (i_y + y - padding_size < 0 ||
                         i_z + z - padding_size < 0 ||
-                        i_y + y - padding_size >= input->dimensions()[1] ||
-                        i_y + y - padding_size >= input->dimensions()[2])
+                        i_y + y - padding_size >= in_width ||
+                        i_z + z - padding_size >= in_height)
                         continue;
 
                     float weight = kernel->data(x,y,z);
-                    float signal = input->data(x, 
+                    float signal = input->data(first + x, 
                                                i_y + y - padding_size,
                                                i_z + z - padding_size);
 
                     kernel->grad(x,y,z)
                         += grad * signal;
-                    input->grad(x, i_y + y - padding_size, i_z + z - padding_size) 
+                    input->grad(first + x, i_y + y - padding_size, 
+                                i_z + z - padding_size) 
                         += grad * weight;
                 }
             }
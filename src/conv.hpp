@@ -7,8 +7,11 @@
 #include <boost/serialization/base_object.hpp>
 #include <boost/serialization/shared_ptr.hpp>
 #include <boost/serialization/vector.hpp>
+#include <boost/serialization/version.hpp>
 
+#include "autotuner.hpp"
 #include "block.hpp"
+#include "fft.hpp"
 #include "op.hpp"
 #include "random.hpp"
 #include "transfer_fns.hpp"
@@ -20,6 +23,16 @@ namespace nl {
     /// limited part of input block. Additionaly, they all share the same
     /// weight vector.
     ///
+    /// Input and output depth slices can be split into groups, output
+    /// slices of a group then see only input slices of the same group.
+    /// Depthwise convolution, where every output slice sees a single
+    /// input slice, and 1x1 convolution have their own kernels which are
+    /// picked automatically, other convolutions lower windows to columns
+    /// of a matrix and multiply it with kernels. Winograd minimal
+    /// filtering for 3x3 windows and FFT for stride 1 are picked by
+    /// setAlgorithm(), or whenever they are measured to be faster if
+    /// Autotuner is enabled.
+    ///
     class Conv : public Op {
     public:
 
@@ -32,9 +45,12 @@ namespace nl {
         /// @param padding_size how many layers of zeros should 
         /// be appended to input block
         /// @param stride by how much does kernel move
+        /// @param groups number of groups of depth slices, it has to
+        /// divide both input and output depth
         Conv(std::string name, std::string fn_name, block_ptr input, 
-             uint16_t output_depth,
-             uint16_t window_size, uint16_t padding_size=0, uint16_t stride=1);
+             index_t output_depth,
+             index_t window_size, index_t padding_size=0, index_t stride=1,
+             index_t groups=1);
 
         /// Constructor
         /// @param name name of the operation
@@ -45,9 +61,12 @@ namespace nl {
         /// @param padding_size how many layers of zeros should 
         /// be appended to input block
         /// @param stride by how much does kernel move
+        /// @param groups number of groups of depth slices, it has to
+        /// divide both input and output depth
         Conv(std::string name, std::string fn_name, Op & op, 
-             uint16_t output_depth,
-             uint16_t window_size, uint16_t padding_size=0, uint16_t stride=1);
+             index_t output_depth,
+             index_t window_size, index_t padding_size=0, index_t stride=1,
+             index_t groups=1);
 
         virtual void forward();
 
@@ -56,16 +75,162 @@ namespace nl {
         virtual block_map outputs();
 
         virtual block_map inputs();
+
+        virtual void share(const block_map & blocks);
+
+        virtual Cost forward_cost();
+
+        virtual Cost backward_cost();
+
+        ///
+        /// Select kernel used by forward and backward pass. Options are
+        /// "auto" (default) picking the fastest applicable kernel, or
+        /// the measured one if Autotuner is enabled, "direct" computing
+        /// window by window, "im2col" multiplying kernels with windows
+        /// lowered to matrix columns, "depthwise" for groups with a single
+        /// input and output depth slice, "gemm" for 1x1 windows with 
+        /// stride 1 and no padding, "winograd" for 3x3 windows with
+        /// stride 1 and a single group and "fft" for stride 1 and 
+        /// a single group.
+        /// @param name name of the kernel
+        ///
+        void setAlgorithm(std::string name);
+
+        ///
+        /// Let the "direct" kernel, and ConvPool computing it, use code
+        /// compiled for fixed window, padding and stride, which unrolls
+        /// loops over the window, whenever it matches the convolution.
+        /// Other shapes are computed by the generic code. Enabled by
+        /// default.
+        /// @param enabled false to always use the generic kernel
+        ///
+        static void setSpecialized(bool enabled) {
+            specialized = enabled;
+        }
     
     private:        
+        /// Kernels computing the convolution.
+        enum Algorithm { AUTO, DIRECT, DEPTHWISE, GEMM, WINOGRAD, FOURIER, 
+                         IM2COL };
+        /// Kernel of given name, throws for unknown names.
+        static Algorithm algorithm_of(const std::string & name);
+        /// true iff kernel can compute this convolution
+        bool applicable(Algorithm a);
+        /// Measure all applicable kernels, or look up the fastest one.
+        void tune();
+        /// Description of the shape for Autotuner.
+        std::string tuning_key();
         /// Shared init method
-        void init(uint16_t input_depth);
+        void init(index_t input_depth);
+        /// true iff every group has a single input and output depth slice
+        bool is_depthwise();
+        /// true iff window is 1x1 and covers every input cell once
+        bool is_pointwise();
+        /// true iff window is 3x3 with stride 1 and a single group
+        bool is_winograd();
+        /// true iff stride is 1 and there is a single group
+        bool is_fft();
+        /// Kernel used by the next pass.
+        Algorithm selected();
+        ///
+        /// Forward pass of depth slices from 'first' to 'first' + 'count'
+        /// by the direct kernel compiled for this shape.
+        /// @param out output, every cell holds 'count' values
+        /// @return false if there is no such kernel or they are disabled
+        ///
+        bool forward_fixed(float* out, index_t first, index_t count);
+        ///
+        /// Backward pass by the direct kernel compiled for this shape,
+        /// see forward_fixed().
+        /// @param grad gradient of output before the transfer function
+        /// @return false if there is no such kernel or they are disabled
+        ///
+        bool backward_fixed(const float* grad, index_t first, index_t count);
+        /// Forward pass computing window by window.
+        void forward_direct();
+        /// Backward pass computing window by window.
+        void backward_direct();
+        /// Forward pass of depthwise convolution.
+        void forward_depthwise();
+        /// Backward pass of depthwise convolution.
+        void backward_depthwise();
+        ///
+        /// Forward pass as matrix multiplication of kernels and input,
+        /// windows are lowered by im2col() unless they are 1x1.
+        ///
+        void forward_gemm();
+        /// Backward pass as matrix multiplication, see forward_gemm().
+        void backward_gemm();
+        ///
+        /// Lower windows of a group to columns of a matrix, with a column
+        /// for every output cell and rows in memory order of kernels.
+        /// @param g index of the group
+        /// @param columns matrix stored column by column
+        ///
+        void im2col(index_t g, std::vector<float> & columns);
+        ///
+        /// Add gradient of lowered windows of a group to input gradient.
+        /// @param g index of the group
+        /// @param columns gradient in the layout of im2col()
+        ///
+        void col2im(index_t g, const float* columns);
+        ///
+        /// Forward pass by Winograd minimal filtering F(2x2,3x3), which 
+        /// computes every 2x2 tile of output with 16 instead of 36 
+        /// multiplications per pair of input and output depth slice.
+        ///
+        void forward_winograd();
+        ///
+        /// Backward pass by Winograd minimal filtering, gradient flows
+        /// through the same transforms as in forward pass.
+        ///
+        void backward_winograd();
+        /// Transform kernels for Winograd, unless they have not changed.
+        void update_winograd_filters();
+        ///
+        /// Transform 4x4 input tiles for Winograd, 16 matrices of input
+        /// depth x number of tiles stored one after another.
+        ///
+        void winograd_tiles(std::vector<float> & tiles);
+        ///
+        /// Forward pass by FFT, every padded input depth slice and kernel 
+        /// is transformed and correlation becomes elementwise product.
+        ///
+        void forward_fft();
+        ///
+        /// Backward pass by FFT, input gradient is convolution of output
+        /// gradient with kernels and kernel gradient is correlation of
+        /// input with output gradient.
+        ///
+        void backward_fft();
+        /// Transform kernels for FFT, unless they have not changed.
+        void update_fft_filters();
+        /// Transform padded input depth slices, one after another.
+        void fft_inputs(std::vector<FFT::complex> & spectra);
+        /// Size of transform along width, covering padded input.
+        index_t fft_width();
+        /// Size of transform along height, covering padded input.
+        index_t fft_height();
+        ///
+        /// Compare kernels with their copy, from which transformed
+        /// kernels were computed.
+        /// @param source copy of kernels, updated if they differ
+        /// @return true iff kernels differ from the copy
+        ///
+        bool kernels_changed(std::vector<float> & source);
+        /// first input depth slice seen by given output depth slice
+        index_t group_begin(index_t d);
         /// compute weighted sum for single cell specified by its position
         /// @param d coordinate in first dimension
         /// @param w coordinate in second dimension
         /// @param h coordinate in third dimension
         /// @return weighted sum for a given "window"
-        float weighted_sum(uint16_t d, uint16_t w, uint16_t h);
+        float weighted_sum(index_t d, index_t w, index_t h);
+        ///
+        /// Number of multiplications of kernel and input cells over all
+        /// windows, cells of padding are not counted.
+        ///
+        double window_taps();
         ///
         /// Update the gradient of all weights for given depth slice and 
         /// the gradient of all input cells given single output cell gradient
@@ -74,7 +239,7 @@ namespace nl {
         /// @param y coordinate in second dimension of output cell
         /// @param z coordinate in third dimension of output cell
         /// 
-        void grad_window_update(float grad, uint16_t x, uint16_t y, uint16_t z);
+        void grad_window_update(float grad, index_t x, index_t y, index_t z);
         /// Input block
         block_ptr input;
         /// Output block
@@ -106,7 +271,7 @@ namespace nl {
         /// The window is rectangular and two-dimensional so 
         /// the depth of a window is 1.
         ///
-        uint16_t window_size;
+        index_t window_size;
         ///
         /// Padding size
         /// Input gets padded equally along the borders in width
@@ -120,12 +285,34 @@ namespace nl {
         /// 000000
         /// 000000
         /// 
-        uint16_t padding_size;
+        index_t padding_size;
         ///
         /// How much does the window move after each iteration. Identical for
         /// both dimensions of movement. 
         /// 
-        uint16_t stride;
+        index_t stride;
+        /// Number of groups of depth slices.
+        index_t groups = 1;
+        /// Kernel selected by setAlgorithm().
+        Algorithm algorithm = AUTO;
+        /// Kernel measured by tune(), AUTO if not tuned yet.
+        Algorithm tuned = AUTO;
+        /// True iff forward_fixed() and backward_fixed() may be used.
+        static bool specialized;
+        ///
+        /// Kernels transformed for Winograd, 16 matrices of output depth
+        /// x input depth stored one after another.
+        ///
+        std::vector<float> winograd_filters;
+        /// Kernels from which 'winograd_filters' were computed.
+        std::vector<float> winograd_source;
+        ///
+        /// Transformed kernels for FFT, for each output depth slice 
+        /// one after another for all input depth slices.
+        ///
+        std::vector<FFT::complex> fft_filters;
+        /// Kernels from which 'fft_filters' were computed.
+        std::vector<float> fft_source;
         /// Transfer function
         TransferFn* transfer_fn;
 
@@ -133,7 +320,7 @@ namespace nl {
         Conv(): Op("default_name") {}        
 
         template<class Archive>
-        void save(Archive & ar, const unsigned int) const
+        void save(Archive & ar, const unsigned int version) const
         {
             ar << boost::serialization::base_object<nl::Op>(*this);
             ar << input;
@@ -143,10 +330,12 @@ namespace nl {
             ar << padding_size;
             ar << stride;
             ar << transfer_fn;
+            ar << groups;
+            ar << algorithm;
         }
 
         template<class Archive>
-        void load(Archive & ar, const unsigned int)
+        void load(Archive & ar, const unsigned int version)
         {
             ar >> boost::serialization::base_object<nl::Op>(*this);
 
@@ -160,12 +349,21 @@ namespace nl {
             ar >> padding_size;
             ar >> stride;
             ar >> transfer_fn;
+            if (version > 0) {
+                ar >> groups;
+                ar >> algorithm;
+            }
         }
         BOOST_SERIALIZATION_SPLIT_MEMBER()
 
         friend class boost::serialization::access;
+        friend class ConvPool;
+        friend class QuantizedConv;
+        friend class Codegen;
     };
 
 } // namespace nl
 
+BOOST_CLASS_VERSION(nl::Conv, 1)
+
 #endif // NEURAL_LIB_CONV_H
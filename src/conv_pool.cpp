@@ -0,0 +1,296 @@
+
+#include <algorithm>
+#include <limits>
+
+#include <Eigen/Core>
+
+#include "conv_pool.hpp"
+
+namespace nl {
+
+    namespace {
+
+        typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic> Matrix;
+        /// Kernel or its gradient stored in a row of a matrix.
+        typedef Eigen::Map<Eigen::Matrix<float, 1, Eigen::Dynamic>> RowMap;
+
+        /// Depth slices computed at once, so that the tile stays in cache.
+        index_t slices_per_tile(index_t cells, index_t out_group) {
+            const index_t tile_size = 65536;
+            return std::max<index_t>(1, std::min(out_group, tile_size / cells));
+        }
+
+    } // namespace
+
+    ConvPool::ConvPool(const Conv & conv, const MaxPool & pool):
+        Op(conv.name + "+" + pool.name), conv(conv), pool(pool) {
+
+        // pooling has to read exactly the output of the convolution
+        if (pool.input != conv.output)
+            throw InputException();
+    }
+
+    void ConvPool::forward() {
+        argmax.resize(pool.output->data.size());
+        if (conv.selected() == Conv::DIRECT)
+            forward_direct();
+        else
+            forward_lowered();
+    }
+
+    void ConvPool::backward() {
+        if (conv.selected() == Conv::DIRECT)
+            backward_direct();
+        else
+            backward_lowered();
+    }
+
+    void ConvPool::forward_direct() {
+
+        auto dims = conv.output->dimensions();
+        index_t cells = dims[1] * dims[2];
+        index_t chunk = slices_per_tile(cells, dims[0]);
+        tile.resize(cells * chunk);
+
+        for (index_t first = 0; first < dims[0]; first += chunk) {
+            index_t count = std::min(chunk, dims[0] - first);
+            if (!conv.forward_fixed(tile.data(), first, count)) {
+                for (index_t j = 0; j < count; ++j) {
+                    float threshold = conv.weights[first + j].threshold->data(0,0,0);
+                    for (index_t z = 0; z < dims[2]; ++z) {
+                        for (index_t y = 0; y < dims[1]; ++y) {
+                            tile[j + count * (y + dims[1] * z)] =
+                                conv.transfer_fn->forward(
+                                    conv.weighted_sum(first + j, y, z) + threshold);
+                        }
+                    }
+                }
+            }
+            pool_tile(first, count);
+        }
+
+    }
+
+    void ConvPool::backward_direct() {
+
+        auto dims = conv.output->dimensions();
+        index_t cells = dims[1] * dims[2];
+        index_t chunk = slices_per_tile(cells, dims[0]);
+        tile.resize(cells * chunk);
+        tile_grad.resize(cells * chunk);
+
+        for (index_t first = 0; first < dims[0]; first += chunk) {
+            index_t count = std::min(chunk, dims[0] - first);
+            unpool_tile(first, count);
+            if (conv.backward_fixed(tile_grad.data(), first, count))
+                continue;
+
+            // cells that were not maxima have zero gradient
+            for (index_t j = 0; j < count; ++j) {
+                for (index_t z = 0; z < dims[2]; ++z) {
+                    for (index_t y = 0; y < dims[1]; ++y) {
+                        float grad = tile_grad[j + count * (y + dims[1] * z)];
+                        if (grad != 0)
+                            conv.grad_window_update(grad, first + j, y, z);
+                    }
+                }
+            }
+        }
+
+    }
+
+    void ConvPool::forward_lowered() {
+
+        index_t out_group = conv.output->dimensions()[0] / conv.groups;
+        index_t rows = conv.weights[0].kernel->data.size();
+        index_t cells = conv.output->dimensions()[1] *
+            conv.output->dimensions()[2];
+        index_t chunk = slices_per_tile(cells, out_group);
+        tile.resize(cells * chunk);
+
+        Matrix kernels(chunk, rows);
+        for (index_t g = 0; g < conv.groups; ++g) {
+            conv.im2col(g, columns);
+            Eigen::Map<const Matrix> lowered(columns.data(), rows, cells);
+
+            for (index_t first = 0; first < out_group; first += chunk) {
+                index_t count = std::min(chunk, out_group - first);
+                index_t x = g * out_group + first;
+
+                // every slice is a row of the tile, as in the output block
+                for (index_t j = 0; j < count; ++j) {
+                    kernels.row(j) = RowMap(
+                        conv.weights[x + j].kernel->data.data(), rows);
+                }
+                Eigen::Map<Matrix> slices(tile.data(), count, cells);
+                slices.noalias() = kernels.topRows(count) * lowered;
+
+                for (index_t j = 0; j < count; ++j) {
+                    float threshold = conv.weights[x + j].threshold->data(0,0,0);
+                    for (index_t c = 0; c < cells; ++c) {
+                        slices(j, c) = conv.transfer_fn->forward(
+                            slices(j, c) + threshold);
+                    }
+                }
+                pool_tile(x, count);
+            }
+        }
+
+    }
+
+    void ConvPool::backward_lowered() {
+
+        index_t out_group = conv.output->dimensions()[0] / conv.groups;
+        index_t rows = conv.weights[0].kernel->data.size();
+        index_t cells = conv.output->dimensions()[1] *
+            conv.output->dimensions()[2];
+        index_t chunk = slices_per_tile(cells, out_group);
+        tile.resize(cells * chunk);
+        tile_grad.resize(cells * chunk);
+        columns_grad.resize(rows * cells);
+
+        Matrix kernels(chunk, rows);
+        Matrix kernel_grads(chunk, rows);
+        for (index_t g = 0; g < conv.groups; ++g) {
+            conv.im2col(g, columns);
+            Eigen::Map<const Matrix> lowered(columns.data(), rows, cells);
+            Eigen::Map<Matrix> lowered_grad(columns_grad.data(), rows, cells);
+            lowered_grad.setZero();
+
+            for (index_t first = 0; first < out_group; first += chunk) {
+                index_t count = std::min(chunk, out_group - first);
+                index_t x = g * out_group + first;
+                unpool_tile(x, count);
+
+                for (index_t j = 0; j < count; ++j) {
+                    kernels.row(j) = RowMap(
+                        conv.weights[x + j].kernel->data.data(), rows);
+                }
+                Eigen::Map<const Matrix> grad(tile_grad.data(), count, cells);
+                kernel_grads.topRows(count).noalias() = grad * lowered.transpose();
+                lowered_grad.noalias() += kernels.topRows(count).transpose() * grad;
+
+                for (index_t j = 0; j < count; ++j) {
+                    RowMap(conv.weights[x + j].kernel->grad.data(), rows) +=
+                        kernel_grads.row(j);
+                }
+            }
+            conv.col2im(g, columns_grad.data());
+        }
+
+    }
+
+    void ConvPool::pool_tile(index_t first, index_t count) {
+
+        block_ptr output = pool.output;
+        auto out_dims = output->dimensions();
+        index_t width = conv.output->dimensions()[1];
+        index_t height = conv.output->dimensions()[2];
+        index_t window = pool.window_size;
+        index_t padding = pool.padding_size;
+        index_t stride = pool.stride;
+
+        // cells of padding are skipped and the first maximum in order
+        // of MaxPool wins
+        for (index_t x = first; x < first + count; ++x) {
+            const float* slice = &tile[x - first];
+            std::size_t i = x * out_dims[1] * out_dims[2];
+            for (index_t y = 0; y < out_dims[1]; ++y) {
+                for (index_t z = 0; z < out_dims[2]; ++z) {
+
+                    index_t y_from = std::max<index_t>(stride * y - padding, 0);
+                    index_t y_to = std::min(stride * y - padding + window, width);
+                    index_t z_from = std::max<index_t>(stride * z - padding, 0);
+                    index_t z_to = std::min(stride * z - padding + window, height);
+
+                    float best = std::numeric_limits<float>::lowest();
+                    index_t best_pos = y_from + width * z_from;
+                    for (index_t w = y_from; w < y_to; ++w) {
+                        for (index_t h = z_from; h < z_to; ++h) {
+                            if (slice[count * (w + width * h)] > best) {
+                                best = slice[count * (w + width * h)];
+                                best_pos = w + width * h;
+                            }
+                        }
+                    }
+
+                    output->data(x,y,z) = best;
+                    argmax[i++] = best_pos;
+                }
+            }
+        }
+
+    }
+
+    void ConvPool::unpool_tile(index_t first, index_t count) {
+
+        block_ptr output = pool.output;
+        auto out_dims = output->dimensions();
+        index_t cells = conv.output->dimensions()[1] *
+            conv.output->dimensions()[2];
+        std::fill(tile_grad.begin(), tile_grad.begin() + count * cells, 0);
+
+        for (index_t x = first; x < first + count; ++x) {
+            float* slice = &tile[x - first];
+            float* slice_grad = &tile_grad[x - first];
+
+            // value of a maximum is the pooled value
+            std::size_t i = x * out_dims[1] * out_dims[2];
+            for (index_t y = 0; y < out_dims[1]; ++y) {
+                for (index_t z = 0; z < out_dims[2]; ++z) {
+                    index_t pos = count * argmax[i++];
+                    slice_grad[pos] += output->grad(x,y,z);
+                    slice[pos] = output->data(x,y,z);
+                }
+            }
+
+            // gradient before transfer function
+            float sum = 0;
+            for (index_t c = 0; c < count * cells; c += count) {
+                if (slice_grad[c] == 0)
+                    continue;
+                slice_grad[c] *= conv.transfer_fn->backward(slice[c]);
+                sum += slice_grad[c];
+            }
+            conv.weights[x].threshold->grad(0,0,0) += sum;
+        }
+
+    }
+
+    block_map ConvPool::inputs() {
+        return conv.inputs();
+    }
+
+    block_map ConvPool::outputs() {
+        return pool.outputs();
+    }
+
+    void ConvPool::share(const block_map & blocks) {
+        conv.share(blocks);
+        pool.share(blocks);
+    }
+
+    Cost ConvPool::forward_cost() {
+        double pool_out = pool.output->data.size();
+
+        // intermediate block is not written, every window is scanned
+        Cost c = conv.forward_cost();
+        c.flops += pool_out * pool.window_size * pool.window_size;
+        c.bytes_written = pool_out * sizeof(float);
+        return c;
+    }
+
+    Cost ConvPool::backward_cost() {
+        double conv_out = conv.output->data.size();
+        double pool_out = pool.output->data.size();
+
+        // data and gradient of pooling output are read instead of
+        // those of the intermediate block, gradient is added once
+        // for each pooling output
+        Cost c = conv.backward_cost();
+        c.flops += pool_out;
+        c.bytes_read += 2 * (pool_out - conv_out) * sizeof(float);
+        return c;
+    }
+
+} // namespace nl
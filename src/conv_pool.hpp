@@ -0,0 +1,113 @@
+#ifndef NEURAL_LIB_CONV_POOL_H
+#define NEURAL_LIB_CONV_POOL_H
+
+#include <vector>
+
+#include <boost/serialization/base_object.hpp>
+
+#include "block.hpp"
+#include "conv.hpp"
+#include "maxpool.hpp"
+#include "op.hpp"
+
+namespace nl {
+
+    ///
+    /// Convolutional layer immediately followed by max pooling, computed
+    /// as a single op. A few depth slices of the convolution at a time are
+    /// computed into a small buffer, as a product of kernels and windows
+    /// lowered to columns, and pooled while they are still in cache, so the
+    /// output block of the convolution is neither written nor read again.
+    /// A convolution set to the "direct" kernel is computed window by
+    /// window instead, by code compiled for its shape if there is one.
+    ///
+    /// Forward pass remembers position of the maximum of every window.
+    /// Only these cells of the convolution receive gradient and their
+    /// value equals the pooled value, so backward pass needs neither
+    /// the intermediate block nor recomputation.
+    ///
+    /// Usually created by Net::fuse() rather than directly.
+    ///
+    class ConvPool : public Op {
+    public:
+        ///
+        /// Constructor. Copies both ops, the copies use the same blocks
+        /// as the originals, so trained weights are visible through the
+        /// original convolution.
+        /// @param conv convolution
+        /// @param pool max pooling whose input is the output of conv
+        ///
+        ConvPool(const Conv & conv, const MaxPool & pool);
+
+        virtual void forward();
+
+        virtual void backward();
+
+        /// Inputs of the convolution.
+        virtual block_map inputs();
+
+        /// Output of the max pooling.
+        virtual block_map outputs();
+
+        virtual void share(const block_map & blocks);
+
+        virtual Cost forward_cost();
+
+        virtual Cost backward_cost();
+
+    private:
+        /// Forward pass of the convolution window by window.
+        void forward_direct();
+        /// Backward pass of the convolution window by window.
+        void backward_direct();
+        /// Forward pass of the convolution as matrix multiplication.
+        void forward_lowered();
+        /// Backward pass of the convolution as matrix multiplication.
+        void backward_lowered();
+        ///
+        /// Pool depth slices from 'first' to 'first' + 'count' of the
+        /// convolution output in tile, every cell holds 'count' values.
+        ///
+        void pool_tile(index_t first, index_t count);
+        ///
+        /// Route gradient of pooling output of depth slices from 'first'
+        /// to 'first' + 'count' to the maxima of the convolution output in
+        /// tile, restore their values and leave gradient before the
+        /// transfer function in tile_grad. Thresholds receive gradient.
+        ///
+        void unpool_tile(index_t first, index_t count);
+        /// Convolution part.
+        Conv conv;
+        /// Pooling part.
+        MaxPool pool;
+        /// Output of the convolution for a few depth slices.
+        std::vector<float> tile;
+        /// Gradient of the convolution output for a few depth slices.
+        std::vector<float> tile_grad;
+        /// Windows of a group lowered to columns.
+        std::vector<float> columns;
+        /// Gradient of the lowered windows.
+        std::vector<float> columns_grad;
+        ///
+        /// Position of the maximum within its depth slice of the
+        /// convolution for each cell of pooling output, slice after slice.
+        ///
+        std::vector<index_t> argmax;
+
+        // default constructor, for serialization
+        ConvPool(): Op("default_name") {}
+
+        template<class Archive>
+        void serialize(Archive & ar, const unsigned int version)
+        {
+            ar & boost::serialization::base_object<nl::Op>(*this);
+            ar & conv;
+            ar & pool;
+        }
+        friend class boost::serialization::access;
+        friend class Codegen;
+    };
+
+} // namespace nl
+
+#endif // NEURAL_LIB_CONV_POOL_H
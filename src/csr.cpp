@@ -0,0 +1,66 @@
+
+#include <limits>
+
+#include "csr.hpp"
+
+namespace nl {
+
+    Csr::Csr(const float* dense, index_t rows, index_t columns):
+        row_count(rows), column_count(columns) {
+
+        if (columns > std::numeric_limits<std::int32_t>::max())
+            throw DimensionException();
+
+        starts.reserve(rows + 1);
+        for (index_t r = 0; r < rows; ++r) {
+            const float* row = dense + columns * r;
+            for (index_t c = 0; c < columns; ++c) {
+                if (row[c] != 0) {
+                    indices.push_back(c);
+                    values.push_back(row[c]);
+                }
+            }
+            starts.push_back(values.size());
+        }
+    }
+
+    void Csr::multiply(const float* x, float* y) const {
+        for (index_t r = 0; r < row_count; ++r) {
+            // independent partial sums, the gathers do not wait for
+            // each other
+            float sum0 = 0, sum1 = 0;
+            index_t i = starts[r];
+            for (; i + 2 <= starts[r + 1]; i += 2) {
+                sum0 += values[i] * x[indices[i]];
+                sum1 += values[i + 1] * x[indices[i + 1]];
+            }
+            if (i < starts[r + 1])
+                sum0 += values[i] * x[indices[i]];
+            y[r] = sum0 + sum1;
+        }
+    }
+
+    void Csr::multiply_transposed_add(const float* x, float* y) const {
+        for (index_t r = 0; r < row_count; ++r) {
+            float v = x[r];
+            if (v == 0)
+                continue;
+            for (index_t i = starts[r]; i < starts[r + 1]; ++i) {
+                y[indices[i]] += values[i] * v;
+            }
+        }
+    }
+
+    void Csr::outer_add(const float* a, const float* b, float* m) const {
+        for (index_t r = 0; r < row_count; ++r) {
+            float v = a[r];
+            if (v == 0)
+                continue;
+            float* row = m + column_count * r;
+            for (index_t i = starts[r]; i < starts[r + 1]; ++i) {
+                row[indices[i]] += v * b[indices[i]];
+            }
+        }
+    }
+
+} // namespace nl
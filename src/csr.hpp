@@ -0,0 +1,83 @@
+#ifndef NEURAL_LIB_CSR_H
+#define NEURAL_LIB_CSR_H
+
+#include <cstdint>
+#include <vector>
+
+#include "block.hpp"
+
+namespace nl {
+
+    ///
+    /// Sparse matrix in the compressed sparse row format. Nonzero values
+    /// of every row are stored one after another together with their
+    /// column indices, so that a product with a vector reads only them.
+    ///
+    class Csr {
+    public:
+        /// Empty matrix.
+        Csr() {}
+
+        ///
+        /// Compress a dense matrix, zeros are left out.
+        /// @param dense values stored row after row
+        /// @param rows number of rows
+        /// @param columns number of columns, it has to fit into 32 bits
+        ///
+        Csr(const float* dense, index_t rows, index_t columns);
+
+        /// Number of rows.
+        index_t rows() const {
+            return row_count;
+        }
+
+        /// Number of columns.
+        index_t columns() const {
+            return column_count;
+        }
+
+        /// Number of stored values.
+        index_t nonzeros() const {
+            return values.size();
+        }
+
+        ///
+        /// Product with a vector, y = A x.
+        /// @param x vector of column count values
+        /// @param y vector of row count values, overwritten
+        ///
+        void multiply(const float* x, float* y) const;
+
+        ///
+        /// Product of the transposed matrix with a vector added to
+        /// another one, y += A^T x.
+        /// @param x vector of row count values
+        /// @param y vector of column count values
+        ///
+        void multiply_transposed_add(const float* x, float* y) const;
+
+        ///
+        /// Outer product of two vectors added to a dense matrix at
+        /// positions of stored values only, m(i,j) += a(i) b(j).
+        /// @param a vector of row count values
+        /// @param b vector of column count values
+        /// @param m dense matrix stored row after row
+        ///
+        void outer_add(const float* a, const float* b, float* m) const;
+
+    private:
+        /// Number of rows.
+        index_t row_count = 0;
+        /// Number of columns.
+        index_t column_count = 0;
+        /// Position of the first value of every row and end of the last one.
+        std::vector<index_t> starts = {0};
+        /// Column of every stored value.
+        std::vector<std::int32_t> indices;
+        /// Stored values.
+        std::vector<float> values;
+    };
+
+} // namespace nl
+
+#endif // NEURAL_LIB_CSR_H
@@ -1,10 +1,13 @@
 
+#include <cmath>
+#include <limits>
+
 #include "dense.hpp"
 
 namespace nl {
 
     Dense::Dense(std::string name, std::string fn_name, block_ptr input, 
-                 uint16_t depth, uint16_t width, uint16_t height):
+                 index_t depth, index_t width, index_t height):
         Op(name), input(input), transfer_fn(TransferFns::get(fn_name)) {
 
         // 3-dim block
@@ -17,7 +20,7 @@ namespace nl {
     }
 
     Dense::Dense(std::string name, std::string fn_name, Op & op, 
-                 uint16_t depth, uint16_t width, uint16_t height):
+                 index_t depth, index_t width, index_t height):
         Op(name), transfer_fn(TransferFns::get(fn_name)) {
 
         // check that input op has only a single output
@@ -36,17 +39,17 @@ namespace nl {
                       depth, width, height);
     }
 
-    void Dense::create_blocks(uint16_t input_size, uint16_t depth, 
-                       uint16_t width, uint16_t height) {
+    void Dense::create_blocks(index_t input_size, index_t depth, 
+                       index_t width, index_t height) {
 
         // create output block
         output = std::make_shared<Block>(name + "_out", depth, width, height);
 
         // create weight block
         // individual weight between each cell in input and output blocks
-        uint16_t weight_size = 
-            input_size
-            * depth * width * height;
+        index_t weight_size = 
+            checked_mul(input_size,
+                        checked_mul(checked_mul(depth, width), height));
         weight = std::make_shared<Block>(name + "_w", 1, 1, weight_size);
         weight->trainable = true;
         Generator::init_random(weight);
@@ -60,157 +63,121 @@ namespace nl {
 
     void Dense::forward() {
 
-        struct Coord {
-            uint16_t x, y, z;
-        };
-        Coord from; // position in input block
-        Coord to; // position in output block
-
-        // dimensions of output block
-        uint16_t to_d = output->dimensions()[0];
-        uint16_t to_w = output->dimensions()[1];
-        uint16_t to_h = output->dimensions()[2];
-        // dimensions of input block
-        uint16_t from_d = input->dimensions()[0];
-        uint16_t from_w = input->dimensions()[1];
-        uint16_t from_h = input->dimensions()[2];
-
-        // weights
-        Eigen::TensorMap<Eigen::Tensor<float, 6>> w_data(weight->data.data(),
-                                                         from_d, from_w, from_h,
-                                                         to_d, to_w, to_h);                                     
-
-        // specify position in output block
-        for (to.x = 0; to.x < to_d; ++to.x) {
-            for (to.y = 0; to.y < to_w; ++to.y) {
-                for (to.z = 0; to.z < to_h; ++to.z) {
-
-                    // delete any previous values
-                    output->data(to.x, to.y, to.z) = 0;
-
-                    // specify position in input block
-                    for (from.x = 0; from.x < from_d; ++from.x) {
-                        for (from.y = 0; from.y < from_w; ++from.y) {
-                            for (from.z = 0; from.z < from_h; ++from.z) {
-
-                                // add weighted input
-                                output->data(to.x, to.y, to.z) +=
-                                    w_data(from.x, from.y, from.z,
-                                           to.x, to.y, to.z) 
-                                    * input->data(from.x, from.y, from.z);                                    
-                    
-                            }            
-                        }            
-                    }                               
-
-                    // add threshold
-                    output->data(to.x, to.y, to.z) +=
-                        threshold->data(to.x, to.y, to.z);
-
-                    // apply transfer function
-                    output->data(to.x, to.y, to.z)
-                        = transfer_fn->forward(output->data(to.x, to.y, to.z));
-                    
-                }            
-            }            
-        }            
-        
+        index_t in = input->data.size();
+        index_t out = output->data.size();
+        Precision precision = weight->precision();
+
+        // weights of a single output cell are contiguous, see 'weight'
+        const float* x = input->data.data();
+        const float* thr = threshold->data.data();
+        float* y = output->data.data();
+        if (sparse_weights()) {
+            sparse.multiply(x, y);
+        } else {
+            for (index_t o = 0; o < out; ++o) {
+                if (precision == FP32) {
+                    Eigen::Map<const Eigen::VectorXf> w(weight->data.data() + in * o, in);
+                    y[o] = w.dot(Eigen::Map<const Eigen::VectorXf>(x, in));
+                } else if (precision == BF16 && input->precision() == BF16) {
+                    y[o] = Half::dot(input->packed.data(), &weight->packed[in * o], in);
+                } else {
+                    y[o] = Half::dot(x, &weight->packed[in * o], in, precision);
+                }
+            }
+        }
+        for (index_t o = 0; o < out; ++o) {
+            y[o] = transfer_fn->forward(y[o] + thr[o]);
+        }
+
+        if (output->precision() != FP32)
+            output->store();
+
     }
 
     void Dense::backward() {
-        
-        struct Coord {
-            uint16_t x, y, z;
-        };
-        Coord from; // position in input block
-        Coord to; // position in output block        
-
-        // dimensions of output block
-        uint16_t to_d = output->dimensions()[0];
-        uint16_t to_w = output->dimensions()[1];
-        uint16_t to_h = output->dimensions()[2];
-        // dimensions of input block
-        uint16_t from_d = input->dimensions()[0];
-        uint16_t from_w = input->dimensions()[1];
-        uint16_t from_h = input->dimensions()[2];
+
+        index_t in = input->data.size();
+        index_t out = output->data.size();
 
         // pass gradient through transfer function
-        Eigen::Tensor<float,3> grad(to_d, to_w, to_h);
-        grad.setZero();
-        for (uint16_t i = 0; i < to_d; ++i) {
-            for (uint16_t j = 0; j < to_w; ++j) {
-                for (uint16_t k = 0; k < to_h; ++k) {
-                    grad(i,j,k) = output->grad(i,j,k) *
-                        transfer_fn->backward(output->data(i,j,k));
-                }   
-            }   
+        Eigen::VectorXf grad(out);
+        for (index_t o = 0; o < out; ++o) {
+            grad(o) = output->grad.data()[o] *
+                transfer_fn->backward(output->data.data()[o]);
         }
 
-        Eigen::TensorMap<Eigen::Tensor<float, 6>> w_data(weight->data.data(),
-                                     from_d, from_w, from_h,
-                                     to_d, to_w, to_h);                                     
-        Eigen::TensorMap<Eigen::Tensor<float, 6>> w_grad(weight->grad.data(),
-                                          from_d, from_w, from_h,
-                                          to_d, to_w, to_h);                                     
-
-        // compute input gradient
-        for (to.x = 0; to.x < to_d; ++to.x) {
-            for (to.y = 0; to.y < to_w; ++to.y) {
-                for (to.z = 0; to.z < to_h; ++to.z) {
-
-                    // specify position in input block
-                    for (from.x = 0; from.x < from_d; ++from.x) {
-                        for (from.y = 0; from.y < from_w; ++from.y) {
-                            for (from.z = 0; from.z < from_h; ++from.z) {
-
-                                input->grad(from.x, from.y, from.z) += 
-                                    w_data(from.x, from.y, from.z,
-                                           to.x, to.y, to.z) *
-                                    grad(to.x, to.y, to.z);                                
-                                
-                            }            
-                        }            
-                    }                               
-                    
-                }            
-            }            
-        }                    
-        
-        // weight gradient
-        // specify position in output block
-        for (to.x = 0; to.x < to_d; ++to.x) {
-            for (to.y = 0; to.y < to_w; ++to.y) {
-                for (to.z = 0; to.z < to_h; ++to.z) {
-
-                    // specify position in input block
-                    for (from.x = 0; from.x < from_d; ++from.x) {
-                        for (from.y = 0; from.y < from_w; ++from.y) {
-                            for (from.z = 0; from.z < from_h; ++from.z) {
-
-                                w_grad(from.x, from.y, from.z,
-                                       to.x, to.y, to.z) +=
-                                    grad(to.x, to.y, to.z) *
-                                    input->data(from.x, from.y, from.z);
-                                  
-                            }            
-                        }            
-                    }                               
-                    
-                }            
-            }            
-        }                    
+        Eigen::Map<const Eigen::VectorXf> x(input->data.data(), in);
+        Eigen::Map<Eigen::VectorXf> x_grad(input->grad.data(), in);
+        Eigen::Map<Eigen::VectorXf> thr_grad(threshold->grad.data(), out);
+
+        if (sparse_weights()) {
+            sparse.multiply_transposed_add(grad.data(), x_grad.data());
+        } else {
+            for (index_t o = 0; o < out; ++o) {
+                Eigen::Map<const Eigen::VectorXf> w(weight->data.data() + in * o, in);
+                x_grad += grad(o) * w;
+            }
+        }
+
+        // weight gradient, pruned weights have none so that they stay zero
+        if (pruned && use_sparse) {
+            sparse.outer_add(grad.data(), x.data(), weight->grad.data());
+        } else {
+            for (index_t o = 0; o < out; ++o) {
+                Eigen::Map<const Eigen::ArrayXf> w(weight->data.data() + in * o, in);
+                Eigen::Map<Eigen::ArrayXf> w_grad(weight->grad.data() + in * o, in);
+                if (pruned)
+                    w_grad += (w != 0).cast<float>() * grad(o) * x.array();
+                else
+                    w_grad += grad(o) * x.array();
+            }
+        }
 
         // threshold gradient
-        for (uint16_t i = 0; i < to_d; ++i) {
-            for (uint16_t j = 0; j < to_w; ++j) {
-                for (uint16_t k = 0; k < to_h; ++k) {
-                    threshold->grad(i,j,k) += grad(i,j,k);
-                }   
-            }   
+        thr_grad += grad;
+
+    }
+
+    std::size_t Dense::prune(float limit) {
+        std::size_t count = 0;
+        float* w = weight->data.data();
+        for (index_t i = 0; i < weight->data.size(); ++i) {
+            if (w[i] != 0 && std::abs(w[i]) < limit) {
+                w[i] = 0;
+                count++;
+            }
         }
-   
+        pruned = true;
+        weight->store();
+        return count;
     }
-    
+
+    void Dense::setCrossover(float density) {
+        crossover = density;
+        // decided again by next pass
+        sparse_block = nullptr;
+    }
+
+    bool Dense::sparse_weights() {
+        if (sparse_block == weight.get() && sparse_version == weight->version)
+            return use_sparse;
+
+        index_t in = input->data.size();
+        index_t size = weight->data.size();
+        const float* w = weight->data.data();
+        index_t nonzeros = 0;
+        for (index_t i = 0; i < size; ++i) {
+            nonzeros += w[i] != 0;
+        }
+
+        use_sparse = nonzeros < crossover * size &&
+            in <= std::numeric_limits<std::int32_t>::max();
+        sparse = use_sparse ? Csr(w, size / in, in) : Csr();
+        sparse_block = weight.get();
+        sparse_version = weight->version;
+        return use_sparse;
+    }
+
     block_map Dense::outputs() {
         block_map map;
 
@@ -231,4 +198,57 @@ namespace nl {
         return map;
     }
 
+    void Dense::share(const block_map & blocks) {
+        replace(input, blocks);
+        replace(output, blocks);
+        replace(weight, blocks);
+        replace(threshold, blocks);
+    }
+
+    void Dense::setPrecision(Precision weights, Precision activations) {
+        weight->setPrecision(weights);
+        output->setPrecision(activations);
+    }
+
+    Cost Dense::forward_cost() {
+        double in = input->data.size();
+        double out = output->data.size();
+        double w = in * out;
+        auto bytes = [](const block_ptr & b) {
+            return b->precision() == FP32 ? sizeof(float) : sizeof(std::uint16_t);
+        };
+        double w_bytes = w * bytes(weight);
+        // sparse weights are read together with their column indices
+        if (sparse_weights()) {
+            w = sparse.nonzeros();
+            w_bytes = w * (sizeof(float) + sizeof(std::int32_t));
+        }
+
+        // weighted sum, threshold and transfer function
+        Cost c;
+        c.flops = 2 * w + 2 * out;
+        c.bytes_read = w_bytes + in * bytes(input) + out * sizeof(float);
+        c.bytes_written = out * bytes(output);
+        return c;
+    }
+
+    Cost Dense::backward_cost() {
+        double in = input->data.size();
+        double out = output->data.size();
+        double w = in * out;
+        double w_bytes = w * sizeof(float);
+        if (sparse_weights()) {
+            w = sparse.nonzeros();
+            w_bytes = w * (sizeof(float) + sizeof(std::int32_t));
+        }
+
+        // transfer function, input gradient, weight gradient and
+        // threshold gradient
+        Cost c;
+        c.flops = 4 * w + 3 * out;
+        c.bytes_read = 2 * w_bytes + (2 * in + 3 * out) * sizeof(float);
+        c.bytes_written = (w + in + out) * sizeof(float);
+        return c;
+    }
+
 } // namespace nl
@@ -5,6 +5,8 @@
 #include <boost/serialization/shared_ptr.hpp>
 
 #include "block.hpp"
+#include "csr.hpp"
+#include "half.hpp"
 #include "op.hpp"
 #include "random.hpp"
 #include "transfer_fns.hpp"
@@ -26,7 +28,7 @@ namespace nl {
         /// @param width width of output block
         /// @param height height of output block
         Dense(std::string name, std::string fn_name, block_ptr input, 
-              uint16_t depth, uint16_t width, uint16_t height);
+              index_t depth, index_t width, index_t height);
 
         /// Constructor.
         /// @param name name of the resulting dense layer
@@ -37,7 +39,7 @@ namespace nl {
         /// @param width width of output block
         /// @param height height of output block
         Dense(std::string name, std::string fn_name, Op & op, 
-              uint16_t depth, uint16_t width, uint16_t height);
+              index_t depth, index_t width, index_t height);
 
         virtual void forward();
 
@@ -47,13 +49,47 @@ namespace nl {
 
         virtual block_map inputs();
 
+        virtual void share(const block_map & blocks);
+
+        ///
+        /// Store weights and output in reduced precision, see
+        /// Block::setPrecision(). Forward pass then reads 16-bit weights
+        /// and converts them in registers, and with BF16 weights and input
+        /// uses BF16 dot products if the CPU has them. Training keeps
+        /// single precision master weights in Solver.
+        /// @param weights precision of weights
+        /// @param activations precision of output
+        ///
+        void setPrecision(Precision weights, Precision activations=FP32);
+
+        ///
+        /// Zero weights of magnitude below 'limit'. The layer stays pruned,
+        /// zero weights get no gradient and so they stay zero in training.
+        /// @param limit smallest magnitude of a kept weight
+        /// @return number of weights that were zeroed
+        ///
+        std::size_t prune(float limit);
+
+        ///
+        /// Multiply weights as a sparse matrix whenever the fraction of
+        /// nonzero weights is below 'density'. The default 0.3 is about
+        /// where sparse kernels become faster in bench_ops. Weights are
+        /// converted again whenever their Block::version changes.
+        /// @param density 0 disables sparse kernels
+        ///
+        void setCrossover(float density);
+
+        virtual Cost forward_cost();
+
+        virtual Cost backward_cost();
+
     private:
         ///
         /// Create output, weight and threshold blocks and 
         /// initialize them properly.
         ///
-        void create_blocks(uint16_t input_size, uint16_t depth, 
-                           uint16_t width, uint16_t height);
+        void create_blocks(index_t input_size, index_t depth, 
+                           index_t width, index_t height);
         /// Input block
         block_ptr input;
         /// Output block
@@ -71,6 +107,24 @@ namespace nl {
         block_ptr threshold;
         /// Transfer function reference
         TransferFn* transfer_fn;
+        /// True iff weights were pruned, zero weights get no gradient then.
+        bool pruned = false;
+        /// Density of weights below which the sparse matrix is used.
+        float crossover = 0.3;
+        /// Sparse copy of weights, a row for every output cell.
+        Csr sparse;
+        /// Weight block and its version the sparse copy was made from.
+        const Block* sparse_block = nullptr;
+        std::uint64_t sparse_version = 0;
+        /// True iff weights are sparse enough for 'sparse'.
+        bool use_sparse = false;
+
+        ///
+        /// Convert weights to 'sparse' if they changed and are sparse
+        /// enough.
+        /// @return true iff sparse kernels should be used
+        ///
+        bool sparse_weights();
 
         // Default constructor, for serialization
         Dense(): Op("default_name") {}                 
@@ -84,11 +138,17 @@ namespace nl {
             ar & weight;
             ar & threshold;
             ar & transfer_fn;
+            if (version > 0)
+                ar & pruned;
         }
         friend class boost::serialization::access;
+        friend class QuantizedDense;
+        friend class Codegen;
 
     }; 
 
 } // namespace nl
 
+BOOST_CLASS_VERSION(nl::Dense, 1)
+
 #endif // NEURAL_LIB_DENSE_H
@@ -0,0 +1,124 @@
+
+#include <algorithm>
+#include <exception>
+
+#include "engine.hpp"
+
+namespace nl {
+
+    Engine::Engine(Net & net, const std::string & input,
+                   const std::string & output, std::size_t workers):
+        input(input), output(output) {
+
+        if (workers == 0)
+            throw InputException();
+
+        for (std::size_t i = 0; i < workers; ++i) {
+            contexts.emplace_back(new Context(net));
+        }
+        // both names are checked before any thread starts
+        input_dims = contexts[0]->block(input)->dimensions();
+        contexts[0]->block(output);
+
+        for (auto & context : contexts) {
+            threads.emplace_back(&Engine::work, this, std::ref(*context));
+        }
+    }
+
+    Engine::~Engine() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        cv.notify_all();
+        for (auto & t : threads) {
+            t.join();
+        }
+    }
+
+    void Engine::setBatchSize(std::size_t size) {
+        if (size == 0)
+            throw InputException();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            batch_size = size;
+        }
+        cv.notify_all();
+    }
+
+    void Engine::setDeadline(std::chrono::microseconds deadline) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            this->deadline = deadline;
+        }
+        cv.notify_all();
+    }
+
+    std::future<Engine::Tensor> Engine::submit(Tensor data) {
+
+        for (std::size_t i = 0; i < input_dims.size(); ++i) {
+            if (data.dimension(i) != input_dims[i])
+                throw DimensionException();
+        }
+
+        Request r;
+        r.input = std::move(data);
+        r.arrival = Clock::now();
+        std::future<Tensor> result = r.result.get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(std::move(r));
+        }
+        // a worker may be waiting for the batch to fill
+        cv.notify_all();
+        return result;
+    }
+
+    std::size_t Engine::batches() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return batch_count;
+    }
+
+    void Engine::work(Context & context) {
+
+        block_ptr in = context.block(input);
+        block_ptr out = context.block(output);
+        std::vector<Request> batch;
+
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            cv.wait(lock, [this] { return stop || !queue.empty(); });
+            if (queue.empty())
+                return;
+
+            // wait for more requests until the oldest one is due
+            cv.wait_until(lock, queue.front().arrival + deadline, [this] {
+                    return stop || queue.empty() || queue.size() >= batch_size;
+                });
+            if (queue.empty())
+                continue;
+
+            std::size_t size = std::min(batch_size, queue.size());
+            for (std::size_t i = 0; i < size; ++i) {
+                batch.push_back(std::move(queue.front()));
+                queue.pop_front();
+            }
+            batch_count++;
+            lock.unlock();
+
+            for (Request & r : batch) {
+                try {
+                    in->data = r.input;
+                    context.forward();
+                    r.result.set_value(out->data);
+                } catch (...) {
+                    r.result.set_exception(std::current_exception());
+                }
+            }
+            batch.clear();
+
+            lock.lock();
+        }
+    }
+
+} // namespace nl
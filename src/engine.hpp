@@ -0,0 +1,114 @@
+#ifndef NEURAL_LIB_ENGINE_H
+#define NEURAL_LIB_ENGINE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Eigen/unsupported/CXX11/Tensor>
+
+#include "block.hpp"
+#include "context.hpp"
+#include "net.hpp"
+
+namespace nl {
+
+    ///
+    /// In-process inference server. Requests of single samples are queued
+    /// and worker threads take them in batches: a batch is closed when it
+    /// is full or when its oldest request has waited for the deadline.
+    /// Every worker runs the batch on its own Context and fulfils futures
+    /// of the requests.
+    ///
+    /// Blocks hold a single sample, so requests of a batch are computed
+    /// one after another. Batching saves waking a worker and taking the
+    /// queue lock for every request, the deadline bounds the latency
+    /// added by waiting for a batch to fill.
+    ///
+    class Engine {
+    public:
+        /// Result of a request, data of the output block.
+        typedef Eigen::Tensor<float, 3> Tensor;
+
+        ///
+        /// Constructor, starts the workers.
+        /// @param net trained network, it has to outlive the engine and
+        ///        its weights must not change meanwhile
+        /// @param input name of the block that receives request data
+        /// @param output name of the block whose data is the result
+        /// @param workers number of worker threads
+        /// @throw InputException if the network has no such blocks or
+        ///        there are no workers
+        ///
+        Engine(Net & net, const std::string & input,
+               const std::string & output, std::size_t workers=1);
+
+        /// Destructor, pending requests are still computed.
+        ~Engine();
+
+        ///
+        /// Set the largest number of requests in a batch.
+        /// @throw InputException if size is zero
+        ///
+        void setBatchSize(std::size_t size);
+
+        /// Set the longest time a request waits for its batch to fill.
+        void setDeadline(std::chrono::microseconds deadline);
+
+        ///
+        /// Queue a request.
+        /// @param input data of the input block
+        /// @return future result, it holds the exception if the forward
+        ///         pass threw one
+        /// @throw DimensionException if input has other dimensions than
+        ///        the input block
+        ///
+        std::future<Tensor> submit(Tensor input);
+
+        /// Number of batches run so far.
+        std::size_t batches();
+
+        Engine(const Engine &) = delete;
+        Engine & operator=(const Engine &) = delete;
+
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        /// A queued request.
+        struct Request {
+            Tensor input;
+            std::promise<Tensor> result;
+            Clock::time_point arrival;
+        };
+
+        /// Loop of a worker thread.
+        void work(Context & context);
+
+        /// Names of input and output blocks.
+        std::string input, output;
+        /// Dimensions of the input block.
+        std::vector<index_t> input_dims;
+        /// Context of every worker.
+        std::vector<std::unique_ptr<Context>> contexts;
+        std::vector<std::thread> threads;
+        /// Guards all members below.
+        std::mutex mutex;
+        /// Signals new requests and stopping.
+        std::condition_variable cv;
+        std::deque<Request> queue;
+        std::size_t batch_size = 8;
+        std::chrono::microseconds deadline{1000};
+        std::size_t batch_count = 0;
+        /// True iff the engine is being destroyed.
+        bool stop = false;
+    };
+
+} // namespace nl
+
+#endif // NEURAL_LIB_ENGINE_H
@@ -13,7 +13,7 @@ namespace nl {
             throw InputException();
 
         // compute error for each pair
-        for (uint16_t i = 0; i < net_outputs.size(); i++) {
+        for (std::size_t i = 0; i < net_outputs.size(); i++) {
             // subtract one tensor from the other and 
             // square the resulting elements
             Eigen::Tensor<float,3> t = 
@@ -46,7 +46,7 @@ namespace nl {
 
         std::vector<Eigen::Tensor<float, 3>> ret;
 
-        for (uint16_t i = 0; i < net_outputs.size(); i++) {
+        for (std::size_t i = 0; i < net_outputs.size(); i++) {
             Eigen::Tensor<float,3> t = 
                 (net_outputs[i]->data - correct_outputs[i]->data);
             ret.push_back(t/t.abs());
@@ -77,7 +77,7 @@ namespace nl {
             throw InputException();
         
         // compute error for each pair
-        for (uint16_t i = 0; i < net_outputs.size(); i++) {
+        for (std::size_t i = 0; i < net_outputs.size(); i++) {
             // subtract one tensor from the other and 
             // square the resulting elements
             Eigen::Tensor<float,3> t = 
@@ -111,7 +111,7 @@ namespace nl {
 
         std::vector<Eigen::Tensor<float, 3>> ret;
 
-        for (uint16_t i = 0; i < net_outputs.size(); i++) {
+        for (std::size_t i = 0; i < net_outputs.size(); i++) {
             Eigen::Tensor<float,3> t = 
                 (net_outputs[i]->data - correct_outputs[i]->data);
             ret.push_back(t);
@@ -1,6 +1,8 @@
 #ifndef NEURAL_LIB_EXCEPTIONS_H
 #define NEURAL_LIB_EXCEPTIONS_H
 
+#include <exception>
+
 namespace nl {
 
     ///
@@ -58,6 +60,28 @@ namespace nl {
         }
     };
 
+    ///
+    /// Operation is not supported by the object, for example backward
+    /// pass of an op meant only for inference.
+    ///
+    struct UnsupportedException : public std::exception {
+        /// Return brief message about the reason of this exception.
+        const char * what() const throw () {
+            return "Operation is not supported.";
+        }
+    };
+
+    ///
+    /// Communication with another process failed, for example because
+    /// connection could not be established or was closed by the peer.
+    ///
+    struct CommunicationException : public std::exception {
+        /// Return brief message about the reason of this exception.
+        const char * what() const throw () {
+            return "Communication with other process failed.";
+        }
+    };
+
 }
 
 #endif // NEURAL_LIB_EXCEPTIONS_H
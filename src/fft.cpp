@@ -0,0 +1,103 @@
+
+#include <cmath>
+
+#include "fft.hpp"
+
+namespace nl {
+
+    index_t FFT::size(index_t n) {
+        index_t s = 1;
+        while (s < n)
+            s *= 2;
+        return s;
+    }
+
+    std::vector<FFT::complex> FFT::twiddles(index_t n, bool inverse) {
+        // computed in double precision, recurrences lose too much
+        const double pi = std::acos(-1.0);
+        double sign = inverse ? 1 : -1;
+        std::vector<complex> w(n / 2);
+        for (index_t k = 0; k < n / 2; ++k) {
+            double angle = sign * 2 * pi * k / n;
+            w[k] = complex(std::cos(angle), std::sin(angle));
+        }
+        return w;
+    }
+
+    void FFT::transform(complex* data, index_t n,
+                        const std::vector<complex> & w) {
+
+        // reorder to bit reversed indices
+        for (index_t i = 1, j = 0; i < n; ++i) {
+            index_t bit = n >> 1;
+            for (; j & bit; bit >>= 1)
+                j ^= bit;
+            j ^= bit;
+            if (i < j)
+                std::swap(data[i], data[j]);
+        }
+
+        // butterflies, twiddle factor of a stage of length len is every
+        // (n/len)-th one of the whole sequence; products are written out
+        // to avoid slow checks of infinities in complex multiplication
+        for (index_t len = 2; len <= n; len *= 2) {
+            index_t half = len / 2;
+            index_t step = n / len;
+            for (index_t i = 0; i < n; i += len) {
+                for (index_t k = 0; k < half; ++k) {
+                    const complex & t = w[k * step];
+                    complex & a = data[i + k];
+                    complex & b = data[i + k + half];
+                    float re = b.real() * t.real() - b.imag() * t.imag();
+                    float im = b.real() * t.imag() + b.imag() * t.real();
+                    b = complex(a.real() - re, a.imag() - im);
+                    a = complex(a.real() + re, a.imag() + im);
+                }
+            }
+        }
+    }
+
+    void FFT::transform(complex* data, index_t n, bool inverse) {
+        transform(data, n, twiddles(n, inverse));
+        if (inverse) {
+            for (index_t i = 0; i < n; ++i) {
+                data[i] /= (float) n;
+            }
+        }
+    }
+
+    void FFT::transform(complex* data, index_t width, index_t height,
+                        bool inverse) {
+
+        std::vector<complex> w = twiddles(width, inverse);
+        for (index_t z = 0; z < height; ++z) {
+            transform(data + width * z, width, w);
+        }
+
+        // columns are copied to a contiguous buffer and back
+        w = twiddles(height, inverse);
+        std::vector<complex> column(height);
+        float scale = inverse ? 1.0f / (width * height) : 1.0f;
+        for (index_t y = 0; y < width; ++y) {
+            for (index_t z = 0; z < height; ++z) {
+                column[z] = data[y + width * z];
+            }
+            transform(column.data(), height, w);
+            for (index_t z = 0; z < height; ++z) {
+                data[y + width * z] = column[z] * scale;
+            }
+        }
+    }
+
+    void FFT::multiply_add(const complex* a, const complex* b,
+                           complex* acc, index_t n, bool conjugate) {
+        float sign = conjugate ? -1 : 1;
+        for (index_t i = 0; i < n; ++i) {
+            float b_im = sign * b[i].imag();
+            acc[i] = complex(
+                acc[i].real() + a[i].real() * b[i].real() - a[i].imag() * b_im,
+                acc[i].imag() + a[i].real() * b_im + a[i].imag() * b[i].real());
+        }
+    }
+
+} // namespace nl
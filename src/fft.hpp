@@ -0,0 +1,65 @@
+#ifndef NEURAL_LIB_FFT_H
+#define NEURAL_LIB_FFT_H
+
+#include <complex>
+#include <vector>
+
+#include "block.hpp"
+
+namespace nl {
+
+    ///
+    /// Radix-2 fast Fourier transform of complex single precision data.
+    /// Sizes have to be powers of two, see FFT::size().
+    ///
+    class FFT {
+    public:
+        typedef std::complex<float> complex;
+
+        /// Smallest power of two which is not less than n.
+        static index_t size(index_t n);
+
+        ///
+        /// Transform of a single sequence in place.
+        /// @param data sequence of n values
+        /// @param n length, power of two
+        /// @param inverse compute inverse transform, which includes
+        ///        scaling by 1/n
+        ///
+        static void transform(complex* data, index_t n, bool inverse);
+
+        ///
+        /// Transform of two dimensional data in place, first along width
+        /// and then along height.
+        /// @param data values, width is the faster dimension
+        /// @param width first dimension, power of two
+        /// @param height second dimension, power of two
+        /// @param inverse compute inverse transform, which includes
+        ///        scaling by 1/(width*height)
+        ///
+        static void transform(complex* data, index_t width, index_t height,
+                              bool inverse);
+
+        ///
+        /// Add elementwise product of two sequences to accumulator.
+        /// @param a first factor
+        /// @param b second factor
+        /// @param acc accumulator
+        /// @param n length of sequences
+        /// @param conjugate multiply by complex conjugate of b
+        ///
+        static void multiply_add(const complex* a, const complex* b,
+                                 complex* acc, index_t n, bool conjugate);
+
+    private:
+        /// Transform using precomputed twiddle factors of the sequence size.
+        static void transform(complex* data, index_t n,
+                              const std::vector<complex> & twiddles);
+
+        /// Twiddle factors exp(-2*pi*i*k/n) for k < n/2.
+        static std::vector<complex> twiddles(index_t n, bool inverse);
+    };
+
+} // namespace nl
+
+#endif // NEURAL_LIB_FFT_H
@@ -0,0 +1,129 @@
+
+#include <algorithm>
+#include <limits>
+
+#include "gradient_exchange.hpp"
+
+namespace nl {
+
+    GradientExchange::GradientExchange(Net & net, Ring & ring):
+        ring(ring) {
+
+        std::vector<Op*> ordering = net.get_ordering();
+
+        // position in backward pass of the last op using each block,
+        // blocks not used by any op are exchanged at the very end
+        std::unordered_map<std::string, std::size_t> last;
+        for (auto & block_pair : net.blocks) {
+            if (block_pair.second->trainable)
+                last[block_pair.first] = std::numeric_limits<std::size_t>::max();
+        }
+        for (std::size_t i = 0; i < ordering.size(); ++i) {
+            Op* op = ordering[ordering.size() - 1 - i];
+            for (auto & block_pair : op->inputs()) {
+                if (block_pair.second->trainable)
+                    last[block_pair.first] = i;
+            }
+        }
+
+        // schedule is sorted by position, ties by name so that
+        // it is the same in all processes
+        std::vector<std::pair<std::size_t, std::string>> order;
+        for (auto & pair : last) {
+            order.push_back({pair.second, pair.first});
+        }
+        std::sort(order.begin(), order.end());
+        for (auto & pair : order) {
+            schedule.push_back(net.blocks[pair.second]);
+        }
+
+        // number of final blocks after backward pass of each op
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < ordering.size(); ++i) {
+            while (count < order.size() && order[count].first == i)
+                count++;
+            finalized[ordering[ordering.size() - 1 - i]] = count;
+        }
+
+        // networks of all processes must have the same size
+        uint64_t size = 0;
+        for (auto & b : schedule) {
+            size += b->data.size();
+        }
+        uint64_t previous_size;
+        ring.shift(&size, &previous_size, sizeof(size));
+        if (size != previous_size)
+            throw DimensionException();
+
+        // start from weights of the first process
+        for (auto & b : schedule) {
+            ring.broadcast(b->data.data(), b->data.size());
+            b->store();
+        }
+    }
+
+    GradientExchange::~GradientExchange() {
+        if (!worker.joinable())
+            return;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready = schedule.size();
+        }
+        cv.notify_one();
+        worker.join();
+    }
+
+    void GradientExchange::begin() {
+        ready = 0;
+        error = nullptr;
+        worker = std::thread(&GradientExchange::run, this);
+    }
+
+    void GradientExchange::done(Op* op) {
+        auto it = finalized.find(op);
+        if (it == finalized.end())
+            return;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready = std::max(ready, it->second);
+        }
+        cv.notify_one();
+    }
+
+    void GradientExchange::end() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready = schedule.size();
+        }
+        cv.notify_one();
+        worker.join();
+
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    void GradientExchange::run() {
+
+        float scale = 1.0 / ring.size;
+
+        try {
+            for (std::size_t i = 0; i < schedule.size(); ++i) {
+
+                // wait until gradient of the block is final
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cv.wait(lock, [&] { return ready > i; });
+                }
+
+                block_ptr b = schedule[i];
+                ring.all_reduce(b->grad.data(), b->grad.size());
+                b->grad = b->grad * scale;
+            }
+        } catch (...) {
+            error = std::current_exception();
+        }
+    }
+
+} // namespace nl
@@ -0,0 +1,87 @@
+#ifndef NEURAL_LIB_GRADIENT_EXCHANGE_H
+#define NEURAL_LIB_GRADIENT_EXCHANGE_H
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "block.hpp"
+#include "net.hpp"
+#include "ring.hpp"
+
+namespace nl {
+
+    ///
+    /// Averages gradient of trainable blocks of a network over all
+    /// processes of a Ring. Every process trains its own copy of the same
+    /// network, after the exchange all copies hold the same mean gradient
+    /// and perform the same weight update.
+    ///
+    /// Exchange overlaps with the backward pass. Gradient of a block is
+    /// final once the last op using the block finishes its backward pass,
+    /// so a background thread reduces blocks in the order in which they
+    /// become final while the remaining ops are still being computed.
+    /// Order is given by the ordering of ops in the network and is the
+    /// same in all processes.
+    ///
+    class GradientExchange {
+    public:
+        ///
+        /// Constructor. Checks that all processes train networks with
+        /// the same number of trainable values and copies trainable
+        /// blocks of rank 0 to all other ranks so that training starts
+        /// from identical weights. Has to be called by all ranks.
+        /// @param net network whose gradient is exchanged
+        /// @param ring processes taking part in training
+        ///
+        GradientExchange(Net & net, Ring & ring);
+        /// Destructor.
+        ~GradientExchange();
+        /// Start exchanging gradient of the current backward pass.
+        void begin();
+        /// Notify that op has finished its backward pass.
+        /// @param op op of the network
+        void done(Op* op);
+        ///
+        /// Wait until gradient of all blocks is exchanged. Gradient of
+        /// blocks that were not reported by done() is exchanged now.
+        /// Rethrows exception from communication, if there was any.
+        ///
+        void end();
+        /// Processes taking part in training.
+        Ring & ring;
+
+        GradientExchange(const GradientExchange &) = delete;
+        GradientExchange & operator=(const GradientExchange &) = delete;
+
+    private:
+        /// Reduce gradient of blocks one by one as they become final.
+        void run();
+        ///
+        /// Trainable blocks in the order in which their gradient becomes
+        /// final during backward pass.
+        ///
+        std::vector<block_ptr> schedule;
+        ///
+        /// Number of blocks from the beginning of 'schedule' that become
+        /// final once given op finishes backward pass.
+        ///
+        std::unordered_map<Op*, std::size_t> finalized;
+        /// Number of blocks in 'schedule' whose gradient is final.
+        std::size_t ready = 0;
+        /// Thread reducing gradient during the current backward pass.
+        std::thread worker;
+        /// Exception thrown by worker.
+        std::exception_ptr error;
+        /// Guards 'ready'.
+        std::mutex mutex;
+        /// Worker is notified about final blocks through this variable.
+        std::condition_variable cv;
+    };
+
+} // namespace nl
+
+#endif // NEURAL_LIB_GRADIENT_EXCHANGE_H
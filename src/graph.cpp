@@ -1,98 +1,159 @@
 
-#include <iostream>
+#include <queue>
 
 #include "graph.hpp"
 
-void nl::Graph::visit(Vertex & v, vector<Vertex *> & vect) {
-
-    // return immediately if vertex is already in the vector
-    if (v.mark == Mark::VISITED)
-        return;
-
-    // graph contains ordered cycle
-    if (v.mark == Mark::CURRENT)
-        throw nl::TopologicalException();
-
-    v.mark = Mark::CURRENT;
-
-    // visit all successors
-    for (auto &  succ : v.outgoing) {
-        visit(*succ, vect);   
-    }
-        
-    v.mark = Mark::VISITED;
-
-    // push vertex to the end of the vector
-    vect.push_back(&v);
+std::size_t nl::Graph::vertex(const string & name) {
+    auto it = ids.find(name);
+    if (it != ids.end())
+        return it->second;
+
+    // a vertex without edges may go last
+    std::size_t v = names.size();
+    ids.emplace(name, v);
+    names.push_back(name);
+    outgoing.emplace_back();
+    incoming.emplace_back();
+    rank.push_back(order.size());
+    order.push_back(v);
+    marked.push_back(false);
+    return v;
 }
 
-bool nl::Graph::add_vertex(string name) {
-    bool success = vertices.insert(make_pair(name, Vertex(name))).second;        
-    return success; // fail if there was already a vertex of the same name
+bool nl::Graph::add_vertex(const string & name) {
+    // fail if there was already a vertex of the same name
+    if (ids.count(name) > 0)
+        return false;
+    vertex(name);
+    return true;
 }
 
-bool nl::Graph::add_edge(string from, string to) {
+bool nl::Graph::add_edge(const string & from, const string & to) {
 
     // single-vertex cycles are forbidden
     if (from == to)
         return false;
 
-    // try to find vertices
-    auto origin = vertices.find(from);
-    auto destination = vertices.find(to);
-        
-    // add vertices if they don't exist
-    if (origin == vertices.end()) {
-        if (!add_vertex(from))
-            return false;
-        origin = vertices.find(from);
-    }
-    if (destination == vertices.end()) {
-        if (!add_vertex(to))
-            return false;
-        destination = vertices.find(to);
-    }
-                
-    Vertex * from_v = &(origin->second);
-    Vertex * to_v = &(destination->second);        
+    std::size_t u = vertex(from);
+    std::size_t v = vertex(to);
 
     // add edge if not already present
-    if (std::find(from_v->outgoing.begin(), from_v->outgoing.end(), to_v) == from_v->outgoing.end()) {
-        from_v->outgoing.push_back(to_v);
-    }        
-    if (std::find(to_v->incoming.begin(), to_v->incoming.end(), from_v) == to_v->incoming.end()) {
-        to_v->incoming.push_back(from_v);            
+    if (std::find(outgoing[u].begin(), outgoing[u].end(), v) != outgoing[u].end())
+        return true;
+    outgoing[u].push_back(v);
+    incoming[v].push_back(u);
+
+    // an edge spanning much of the order is left to a single sort
+    if (sorted && rank[u] > rank[v] &&
+        (rank[u] - rank[v] > reorder_limit || !reorder(u, v)))
+        sorted = false;
+    return true;
+}
+
+bool nl::Graph::reach(std::size_t start, std::size_t low, std::size_t high,
+                      bool forward, std::size_t stop,
+                      vector<std::size_t> & found) {
+    vector<std::size_t> stack = {start};
+    marked[start] = true;
+    bool acyclic = true;
+    while (!stack.empty()) {
+        std::size_t v = stack.back();
+        stack.pop_back();
+        found.push_back(v);
+        for (std::size_t w : forward ? outgoing[v] : incoming[v]) {
+            if (w == stop)
+                acyclic = false;
+            if (!marked[w] && rank[w] >= low && rank[w] <= high) {
+                marked[w] = true;
+                stack.push_back(w);
+            }
+        }
     }
+    return acyclic;
+}
+
+bool nl::Graph::reorder(std::size_t from, std::size_t to) {
+
+    // successors of 'to' and predecessors of 'from' that lie between
+    // them have to swap sides, nothing outside this range moves
+    std::size_t low = rank[to], high = rank[from];
+    vector<std::size_t> after, before;
+    bool acyclic = reach(to, low, high, true, from, after);
+    if (acyclic)
+        reach(from, low, high, false, to, before);
+    for (std::size_t v : after)
+        marked[v] = false;
+    for (std::size_t v : before)
+        marked[v] = false;
+    if (!acyclic)
+        return false;
 
+    auto by_rank = [this](std::size_t a, std::size_t b) {
+        return rank[a] < rank[b];
+    };
+    std::sort(after.begin(), after.end(), by_rank);
+    std::sort(before.begin(), before.end(), by_rank);
+
+    // the same positions are given to predecessors first
+    vector<std::size_t> positions;
+    for (std::size_t v : before)
+        positions.push_back(rank[v]);
+    for (std::size_t v : after)
+        positions.push_back(rank[v]);
+    std::sort(positions.begin(), positions.end());
+
+    std::size_t i = 0;
+    for (auto group : {&before, &after}) {
+        for (std::size_t v : *group) {
+            rank[v] = positions[i++];
+            order[rank[v]] = v;
+        }
+    }
     return true;
 }
 
-vector<string> nl::Graph::get_ordering() {
+void nl::Graph::sort() {
 
-    // create empty vector for results
-    vector<Vertex *> order;
+    vector<std::size_t> degree(names.size());
+    for (auto & successors : outgoing) {
+        for (std::size_t v : successors)
+            ++degree[v];
+    }
 
-    // iterate over all vertices in graph
-    for (auto & vertex_it : vertices) {
-        // all vertices must be marked NONE or VISITED when 
-        // search is not running
-        assert(vertex_it.second.mark != Mark::CURRENT);
+    // vertices without predecessors in order of insertion
+    std::queue<std::size_t> ready;
+    for (std::size_t v = 0; v < names.size(); ++v) {
+        if (degree[v] == 0)
+            ready.push(v);
+    }
 
-        if (vertex_it.second.mark == Mark::NONE)
-            visit(vertex_it.second, order);
+    order.clear();
+    while (!ready.empty()) {
+        std::size_t v = ready.front();
+        ready.pop();
+        rank[v] = order.size();
+        order.push_back(v);
+        for (std::size_t w : outgoing[v]) {
+            if (--degree[w] == 0)
+                ready.push(w);
+        }
     }
 
-    reverse(order.begin(), order.end());
+    // graph contains ordered cycle
+    if (order.size() != names.size())
+        throw nl::TopologicalException();
+    sorted = true;
+}
 
-    // restore marks for next iteration
-    for (auto & vertex_it : vertices) {
-        Vertex& v = vertex_it.second;
-        v.mark = Mark::NONE;
-    }
+vector<string> nl::Graph::get_ordering() {
+
+    if (!sorted)
+        sort();
 
     vector<string> ret;
-    for (auto & ptr : order) {
-        ret.push_back(ptr->name);
+    ret.reserve(order.size());
+    for (std::size_t v : order) {
+        ret.push_back(names[v]);
     }
     return ret;
 }
@@ -10,8 +10,10 @@
 #include <boost/serialization/base_object.hpp>
 #include <boost/serialization/access.hpp>
 #include <boost/serialization/export.hpp>
+#include <boost/serialization/split_member.hpp>
 #include <boost/serialization/unordered_map.hpp>
 #include <boost/serialization/vector.hpp>
+#include <boost/serialization/version.hpp>
 
 #include "exceptions.hpp"
 
@@ -19,16 +21,28 @@ using namespace std;
 
 namespace nl {
 
-    /// Oriented graph
+    ///
+    /// Oriented graph. Vertices are numbered in order of insertion and
+    /// edges are kept as arrays of these numbers. A topological order is
+    /// maintained as the graph grows: a new vertex goes last, and an edge
+    /// against the order moves only the vertices between its ends
+    /// (Pearce-Kelly). Edges spanning more than reorder_limit vertices
+    /// are left to a single sort by get_ordering(), which also reports
+    /// cycles.
+    ///
     class Graph {
     public:
     
         /// Add vertex
         /// @param name name of the new vertex
-        bool add_vertex(string name);
+        /// @return false if there was already a vertex of the same name
+        bool add_vertex(const string & name);
 
-        /// Add edge
-        bool add_edge(string from, string to);
+        ///
+        /// Add edge, missing vertices are added as well.
+        /// @return false for an edge from a vertex to itself
+        ///
+        bool add_edge(const string & from, const string & to);
 
         ///
         /// Get topological order of vertices. If there is no such order, 
@@ -38,81 +52,122 @@ namespace nl {
         ///    
         vector<string> get_ordering();
 
-    private:
+        /// Number of vertices.
+        std::size_t size() const {
+            return names.size();
+        }
 
-        /// enum used during topological sort
-        enum Mark {
-            NONE,    /// vertex was not marked
-            CURRENT, /// current search passed through this vertex
-            VISITED  /// ended search passed through this vertex
-        };
+        /// Most vertices moved by an edge against the order.
+        static const std::size_t reorder_limit = 1024;
+
+    private:
 
-        /// Structure representing a single vertex in the graph
-        class Vertex {
-        public:
-            /// constructor
-            /// @param name of the new vertex
-            Vertex(string name): name(name), mark(Mark::NONE) {}
+        /// Number of vertex, inserting it if it is missing.
+        std::size_t vertex(const string & name);
 
-            string name; /// unique name of vertex
-            vector<Vertex*> outgoing; /// outgoing edges
-            vector<Vertex*> incoming; /// incoming edges
-            Mark mark; /// used during topogical sort
+        ///
+        /// Restore the order after an edge from 'from' to 'to', which
+        /// precedes it, by reordering vertices between them.
+        /// @return false if the edge closes a cycle
+        ///
+        bool reorder(std::size_t from, std::size_t to);
 
-            // Default constructor, for serialization purposes
-            Vertex(): Vertex("default_name") {}
+        ///
+        /// Vertices reachable from 'start' whose rank lies in [low, high],
+        /// following edges forward or backward, by an explicit stack.
+        /// @param stop vertex whose reaching means a cycle
+        /// @return false if 'stop' was reached
+        ///
+        bool reach(std::size_t start, std::size_t low, std::size_t high,
+                   bool forward, std::size_t stop,
+                   vector<std::size_t> & found);
+
+        /// Compute the order from scratch by Kahn's algorithm.
+        void sort();
+
+        /// Name of every vertex.
+        vector<string> names;
+        /// Number of every vertex.
+        unordered_map<string, std::size_t> ids;
+        /// Successors and predecessors of every vertex.
+        vector<vector<std::size_t>> outgoing, incoming;
+        /// Vertices in topological order, valid iff 'sorted'.
+        vector<std::size_t> order;
+        /// Position of every vertex in 'order'.
+        vector<std::size_t> rank;
+        /// False if the order was lost to a cycle.
+        bool sorted = true;
+        /// Marks of vertices found by reach(), all false between calls.
+        vector<char> marked;
+
+        /// Vertex as stored by version 0 of Graph.
+        struct LegacyVertex {
+            string name;
+            int mark = 0;
+            vector<LegacyVertex*> outgoing;
+            vector<LegacyVertex*> incoming;
 
-            // serialization code
             template<class Archive>
-            void serialize(Archive & ar, const unsigned int version)
+            void serialize(Archive & ar, const unsigned int)
             {
                 ar & name;
                 ar & mark;
-                // to get rid of an "boost::archive::archive_exception"
-                // pointer conflict, 'outgoing' and 'incoming' vertices
-                // need to be serialized separately
-                // For a reasoning, check for example:
-                // http://www.bnikolic.co.uk/blog/cpp-boost-ser-conflict.html
             }
-            friend class boost::serialization::access;
         };
 
-        ///
-        /// Auxiliary function used during topogical sorting. Modified
-        /// Depth First search.
-        /// @param v vertex from which search is being run
-        /// @param vect vector in which results are being stored
-        ///
-        void visit(Vertex & v, vector<Vertex *> & vect);
-
-        /// Vector of all vertices in a graph
-        unordered_map<string, Vertex> vertices;
-            
         template<class Archive>
-        void serialize(Archive & ar, const unsigned int version)
+        void save(Archive & ar, const unsigned int) const
         {
-            ar & vertices;
-
-            // get all keys in vertices
-            std::vector<std::string> keys;
-            for (auto & pair : vertices) 
-                keys.push_back(pair.first);
+            ar & names;
+            ar & outgoing;
+        }
 
-            // sort keys 
-            std::sort(keys.begin(), keys.end());
+        template<class Archive>
+        void load(Archive & ar, const unsigned int version)
+        {
+            *this = Graph();
+            if (version == 0) {
+                // map of vertices followed by edges of every vertex in
+                // order of names
+                unordered_map<string, LegacyVertex> vertices;
+                ar & vertices;
+                std::vector<std::string> keys;
+                for (auto & pair : vertices)
+                    keys.push_back(pair.first);
+                std::sort(keys.begin(), keys.end());
+                for (auto & key : keys) {
+                    ar & vertices[key].incoming;
+                    ar & vertices[key].outgoing;
+                }
+                for (auto & key : keys) {
+                    add_vertex(key);
+                }
+                for (auto & key : keys) {
+                    for (LegacyVertex* to : vertices[key].outgoing)
+                        add_edge(key, to->name);
+                }
+                return;
+            }
 
-            for (auto & key : keys) {
-                ar & vertices[key].incoming;
-                ar & vertices[key].outgoing;
+            vector<string> loaded;
+            vector<vector<std::size_t>> edges;
+            ar & loaded;
+            ar & edges;
+            for (auto & name : loaded) {
+                add_vertex(name);
+            }
+            for (std::size_t v = 0; v < edges.size(); ++v) {
+                for (std::size_t to : edges[v])
+                    add_edge(loaded[v], loaded[to]);
             }
-            
         }
+        BOOST_SERIALIZATION_SPLIT_MEMBER()
 
         friend class boost::serialization::access;
     };
 
 } // namespace nl
 
-#endif // NEURAL_LIB_GRAPH_H
-
+BOOST_CLASS_VERSION(nl::Graph, 1)
 
+#endif // NEURAL_LIB_GRAPH_H
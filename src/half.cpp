@@ -0,0 +1,309 @@
+
+#include <cmath>
+#include <cstring>
+#include <string>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NEURAL_LIB_X86
+#include <immintrin.h>
+#endif
+
+#include "half.hpp"
+
+namespace nl {
+
+    namespace {
+
+        std::uint32_t bits_of(float f) {
+            std::uint32_t u;
+            std::memcpy(&u, &f, sizeof(u));
+            return u;
+        }
+
+        float float_of(std::uint32_t u) {
+            float f;
+            std::memcpy(&f, &u, sizeof(f));
+            return f;
+        }
+
+        std::uint16_t fp16_of(float f) {
+            std::uint32_t x = bits_of(f);
+            std::uint32_t sign = (x >> 16) & 0x8000;
+            x &= 0x7fffffff;
+
+            // infinity and NaN, or too large for a finite half
+            if (x >= 0x47800000)
+                return sign | (x > 0x7f800000 ? 0x7e00 : 0x7c00);
+
+            // subnormal half, the addition rounds to its mantissa
+            if (x < 0x38800000) {
+                const std::uint32_t magic = 0x3f000000;
+                return sign | (bits_of(float_of(x) + float_of(magic)) - magic);
+            }
+
+            // rebias exponent and round the 13 dropped bits to nearest even,
+            // carry may overflow to infinity
+            x += 0xc8000fff + ((x >> 13) & 1);
+            return sign | (x >> 13);
+        }
+
+        float float_of_fp16(std::uint16_t h) {
+            std::uint32_t sign = (std::uint32_t) (h & 0x8000) << 16;
+            std::uint32_t exponent = (h >> 10) & 0x1f;
+            std::uint32_t mantissa = h & 0x3ff;
+            if (exponent == 0) {
+                float f = std::ldexp((float) mantissa, -24);
+                return sign ? -f : f;
+            }
+            if (exponent == 0x1f)
+                return float_of(sign | 0x7f800000 | mantissa << 13);
+            return float_of(sign | (exponent + 112) << 23 | mantissa << 13);
+        }
+
+        std::uint16_t bf16_of(float f) {
+            std::uint32_t x = bits_of(f);
+            // NaN stays quiet NaN instead of rounding to infinity
+            if ((x & 0x7fffffff) > 0x7f800000)
+                return (x >> 16) | 0x40;
+            x += 0x7fff + ((x >> 16) & 1);
+            return x >> 16;
+        }
+
+        float float_of_bf16(std::uint16_t h) {
+            return float_of((std::uint32_t) h << 16);
+        }
+
+        void pack_portable(const float* in, index_t n, std::uint16_t* out) {
+            for (index_t i = 0; i < n; ++i) {
+                out[i] = fp16_of(in[i]);
+            }
+        }
+
+        void unpack_portable(const std::uint16_t* in, index_t n, float* out) {
+            for (index_t i = 0; i < n; ++i) {
+                out[i] = float_of_fp16(in[i]);
+            }
+        }
+
+        float dot_fp16_portable(const float* a, const std::uint16_t* w,
+                                index_t n) {
+            float sum = 0;
+            for (index_t i = 0; i < n; ++i) {
+                sum += a[i] * float_of_fp16(w[i]);
+            }
+            return sum;
+        }
+
+        float dot_bf16_portable(const float* a, const std::uint16_t* w,
+                                index_t n) {
+            float sum = 0;
+            for (index_t i = 0; i < n; ++i) {
+                sum += a[i] * float_of_bf16(w[i]);
+            }
+            return sum;
+        }
+
+        float dot_bf16_pairs_portable(const std::uint16_t* a,
+                                      const std::uint16_t* w, index_t n) {
+            float sum = 0;
+            for (index_t i = 0; i < n; ++i) {
+                sum += float_of_bf16(a[i]) * float_of_bf16(w[i]);
+            }
+            return sum;
+        }
+
+#ifdef NEURAL_LIB_X86
+        // kernels are compiled for their instruction set regardless of
+        // compiler flags and picked at run time
+
+        __attribute__((target("avx")))
+        float horizontal_sum(__m256 v) {
+            __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v),
+                                    _mm256_extractf128_ps(v, 1));
+            sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+            sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+            return _mm_cvtss_f32(sum);
+        }
+
+        __attribute__((target("avx,f16c")))
+        void pack_f16c(const float* in, index_t n, std::uint16_t* out) {
+            index_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(in + i),
+                                            _MM_FROUND_TO_NEAREST_INT |
+                                            _MM_FROUND_NO_EXC);
+                _mm_storeu_si128((__m128i*) (out + i), h);
+            }
+            pack_portable(in + i, n - i, out + i);
+        }
+
+        __attribute__((target("avx,f16c")))
+        void unpack_f16c(const std::uint16_t* in, index_t n, float* out) {
+            index_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                __m128i h = _mm_loadu_si128((const __m128i*) (in + i));
+                _mm256_storeu_ps(out + i, _mm256_cvtph_ps(h));
+            }
+            unpack_portable(in + i, n - i, out + i);
+        }
+
+        __attribute__((target("avx2,fma,f16c")))
+        float dot_fp16_f16c(const float* a, const std::uint16_t* w,
+                            index_t n) {
+            // two accumulators hide latency of the fused multiply-add
+            __m256 acc0 = _mm256_setzero_ps();
+            __m256 acc1 = _mm256_setzero_ps();
+            index_t i = 0;
+            for (; i + 16 <= n; i += 16) {
+                __m256 w0 = _mm256_cvtph_ps(
+                    _mm_loadu_si128((const __m128i*) (w + i)));
+                __m256 w1 = _mm256_cvtph_ps(
+                    _mm_loadu_si128((const __m128i*) (w + i + 8)));
+                acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), w0, acc0);
+                acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), w1, acc1);
+            }
+            return horizontal_sum(_mm256_add_ps(acc0, acc1)) +
+                dot_fp16_portable(a + i, w + i, n - i);
+        }
+
+        __attribute__((target("avx2,fma")))
+        __m256 widen_bf16(const std::uint16_t* w) {
+            __m256i h = _mm256_cvtepu16_epi32(
+                _mm_loadu_si128((const __m128i*) w));
+            return _mm256_castsi256_ps(_mm256_slli_epi32(h, 16));
+        }
+
+        __attribute__((target("avx2,fma")))
+        float dot_bf16_avx2(const float* a, const std::uint16_t* w,
+                            index_t n) {
+            __m256 acc0 = _mm256_setzero_ps();
+            __m256 acc1 = _mm256_setzero_ps();
+            index_t i = 0;
+            for (; i + 16 <= n; i += 16) {
+                acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i),
+                                       widen_bf16(w + i), acc0);
+                acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8),
+                                       widen_bf16(w + i + 8), acc1);
+            }
+            return horizontal_sum(_mm256_add_ps(acc0, acc1)) +
+                dot_bf16_portable(a + i, w + i, n - i);
+        }
+
+        __attribute__((target("avx2,fma")))
+        float dot_bf16_pairs_avx2(const std::uint16_t* a,
+                                  const std::uint16_t* w, index_t n) {
+            __m256 acc = _mm256_setzero_ps();
+            index_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                acc = _mm256_fmadd_ps(widen_bf16(a + i), widen_bf16(w + i),
+                                      acc);
+            }
+            return horizontal_sum(acc) +
+                dot_bf16_pairs_portable(a + i, w + i, n - i);
+        }
+
+        __attribute__((target("avx2,fma,avx512bf16,avx512vl")))
+        float dot_bf16_pairs_avx512(const std::uint16_t* a,
+                                    const std::uint16_t* w, index_t n) {
+            // products of pairs of neighbours are added to single precision
+            __m256 acc0 = _mm256_setzero_ps();
+            __m256 acc1 = _mm256_setzero_ps();
+            index_t i = 0;
+            for (; i + 32 <= n; i += 32) {
+                __m256i a0 = _mm256_loadu_si256((const __m256i*) (a + i));
+                __m256i w0 = _mm256_loadu_si256((const __m256i*) (w + i));
+                __m256i a1 = _mm256_loadu_si256((const __m256i*) (a + i + 16));
+                __m256i w1 = _mm256_loadu_si256((const __m256i*) (w + i + 16));
+                acc0 = _mm256_dpbf16_ps(acc0, (__m256bh) a0, (__m256bh) w0);
+                acc1 = _mm256_dpbf16_ps(acc1, (__m256bh) a1, (__m256bh) w1);
+            }
+            return horizontal_sum(_mm256_add_ps(acc0, acc1)) +
+                dot_bf16_pairs_portable(a + i, w + i, n - i);
+        }
+#endif
+
+        typedef void (*PackFn)(const float*, index_t, std::uint16_t*);
+        typedef void (*UnpackFn)(const std::uint16_t*, index_t, float*);
+        typedef float (*DotFn)(const float*, const std::uint16_t*, index_t);
+        typedef float (*PairsFn)(const std::uint16_t*, const std::uint16_t*,
+                                 index_t);
+
+        /// Fastest kernels supported by this CPU and their names.
+        struct Dispatch {
+            PackFn pack_fp16 = pack_portable;
+            UnpackFn unpack_fp16 = unpack_portable;
+            DotFn dot_fp16 = dot_fp16_portable;
+            DotFn dot_bf16 = dot_bf16_portable;
+            PairsFn dot_bf16_pairs = dot_bf16_pairs_portable;
+            std::string isa = "portable";
+
+            Dispatch() {
+#ifdef NEURAL_LIB_X86
+                __builtin_cpu_init();
+                bool avx2 = __builtin_cpu_supports("avx2") &&
+                    __builtin_cpu_supports("fma") &&
+                    __builtin_cpu_supports("f16c");
+                if (avx2) {
+                    pack_fp16 = pack_f16c;
+                    unpack_fp16 = unpack_f16c;
+                    dot_fp16 = dot_fp16_f16c;
+                    dot_bf16 = dot_bf16_avx2;
+                    dot_bf16_pairs = dot_bf16_pairs_avx2;
+                    isa = "f16c,avx2";
+                }
+                if (avx2 && __builtin_cpu_supports("avx512bf16") &&
+                    __builtin_cpu_supports("avx512vl")) {
+                    dot_bf16_pairs = dot_bf16_pairs_avx512;
+                    isa += ",avx512bf16";
+                }
+#endif
+            }
+        };
+
+        const Dispatch & dispatch() {
+            static const Dispatch d;
+            return d;
+        }
+
+    } // namespace
+
+    void Half::pack(const float* in, index_t n, Precision precision,
+                    std::uint16_t* out) {
+        if (precision == FP16) {
+            dispatch().pack_fp16(in, n, out);
+            return;
+        }
+        // simple enough for the compiler to vectorize
+        for (index_t i = 0; i < n; ++i) {
+            out[i] = bf16_of(in[i]);
+        }
+    }
+
+    void Half::unpack(const std::uint16_t* in, index_t n, Precision precision,
+                      float* out) {
+        if (precision == FP16) {
+            dispatch().unpack_fp16(in, n, out);
+            return;
+        }
+        for (index_t i = 0; i < n; ++i) {
+            out[i] = float_of_bf16(in[i]);
+        }
+    }
+
+    float Half::dot(const float* a, const std::uint16_t* w, index_t n,
+                    Precision precision) {
+        if (precision == FP16)
+            return dispatch().dot_fp16(a, w, n);
+        return dispatch().dot_bf16(a, w, n);
+    }
+
+    float Half::dot(const std::uint16_t* a, const std::uint16_t* w,
+                    index_t n) {
+        return dispatch().dot_bf16_pairs(a, w, n);
+    }
+
+    const char* Half::isa() {
+        return dispatch().isa.c_str();
+    }
+
+} // namespace nl
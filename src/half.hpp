@@ -0,0 +1,66 @@
+#ifndef NEURAL_LIB_HALF_H
+#define NEURAL_LIB_HALF_H
+
+#include <cstdint>
+
+#include "block.hpp"
+
+namespace nl {
+
+    ///
+    /// Conversions between single precision and the 16-bit formats of
+    /// Precision, and dot products that convert 16-bit values in registers.
+    /// Both formats round to nearest even.
+    ///
+    /// F16C, AVX2 and AVX-512 BF16 are used whenever the CPU supports them
+    /// and portable code otherwise. Conversions give identical results on
+    /// all of them, dot products may differ in rounding of the sum.
+    ///
+    class Half {
+    public:
+        ///
+        /// Round values to 16 bits.
+        /// @param in values
+        /// @param n number of values
+        /// @param precision FP16 or BF16
+        /// @param out rounded values
+        ///
+        static void pack(const float* in, index_t n, Precision precision,
+                         std::uint16_t* out);
+
+        ///
+        /// Widen 16-bit values to single precision, exactly.
+        /// @param in values
+        /// @param n number of values
+        /// @param precision FP16 or BF16
+        /// @param out widened values
+        ///
+        static void unpack(const std::uint16_t* in, index_t n,
+                           Precision precision, float* out);
+
+        ///
+        /// Dot product of single precision and 16-bit vectors.
+        /// @param a values in single precision
+        /// @param w 16-bit values
+        /// @param n length of both vectors
+        /// @param precision format of 'w', FP16 or BF16
+        ///
+        static float dot(const float* a, const std::uint16_t* w, index_t n,
+                         Precision precision);
+
+        ///
+        /// Dot product of two BF16 vectors, accumulated in single precision.
+        /// @param a values
+        /// @param w values
+        /// @param n length of both vectors
+        ///
+        static float dot(const std::uint16_t* a, const std::uint16_t* w,
+                         index_t n);
+
+        /// Names of the instruction sets used by dot().
+        static const char* isa();
+    };
+
+} // namespace nl
+
+#endif // NEURAL_LIB_HALF_H
@@ -0,0 +1,131 @@
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NEURAL_LIB_X86
+#include <immintrin.h>
+#endif
+
+#include "int8.hpp"
+
+namespace nl {
+
+    namespace {
+
+        std::int32_t dot_portable(const std::uint8_t* a, const std::int8_t* w,
+                                  index_t n) {
+            std::int32_t sum = 0;
+            for (index_t i = 0; i < n; ++i) {
+                sum += (std::int32_t) a[i] * w[i];
+            }
+            return sum;
+        }
+
+#ifdef NEURAL_LIB_X86
+        // kernels are compiled for their instruction set regardless of
+        // compiler flags and picked at run time
+
+        __attribute__((target("avx2")))
+        std::int32_t horizontal_sum(__m256i v) {
+            __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(v),
+                                        _mm256_extracti128_si256(v, 1));
+            sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4e));
+            sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xb1));
+            return _mm_cvtsi128_si32(sum);
+        }
+
+        __attribute__((target("avx2")))
+        std::int32_t dot_avx2(const std::uint8_t* a, const std::int8_t* w,
+                              index_t n) {
+            const __m256i ones = _mm256_set1_epi16(1);
+            __m256i acc = _mm256_setzero_si256();
+            index_t i = 0;
+            for (; i + 32 <= n; i += 32) {
+                __m256i va = _mm256_loadu_si256((const __m256i*) (a + i));
+                __m256i vw = _mm256_loadu_si256((const __m256i*) (w + i));
+                // pairs of products in 16 bits, then quads in 32 bits
+                __m256i pairs = _mm256_maddubs_epi16(va, vw);
+                acc = _mm256_add_epi32(acc, _mm256_madd_epi16(pairs, ones));
+            }
+            return horizontal_sum(acc) + dot_portable(a + i, w + i, n - i);
+        }
+
+        __attribute__((target("avx2,avx512vnni,avx512vl")))
+        std::int32_t dot_vnni(const std::uint8_t* a, const std::int8_t* w,
+                              index_t n) {
+            __m256i acc = _mm256_setzero_si256();
+            index_t i = 0;
+            for (; i + 32 <= n; i += 32) {
+                __m256i va = _mm256_loadu_si256((const __m256i*) (a + i));
+                __m256i vw = _mm256_loadu_si256((const __m256i*) (w + i));
+                acc = _mm256_dpbusd_epi32(acc, va, vw);
+            }
+            return horizontal_sum(acc) + dot_portable(a + i, w + i, n - i);
+        }
+#endif
+
+        typedef std::int32_t (*DotFn)(const std::uint8_t*, const std::int8_t*,
+                                      index_t);
+
+        /// Fastest dot product supported by this CPU and its name.
+        struct Dispatch {
+            DotFn dot = dot_portable;
+            const char* isa = "portable";
+
+            Dispatch() {
+#ifdef NEURAL_LIB_X86
+                __builtin_cpu_init();
+                if (__builtin_cpu_supports("avx512vnni") &&
+                    __builtin_cpu_supports("avx512vl")) {
+                    dot = dot_vnni;
+                    isa = "avx512vnni";
+                } else if (__builtin_cpu_supports("avx2")) {
+                    dot = dot_avx2;
+                    isa = "avx2";
+                }
+#endif
+            }
+        };
+
+        const Dispatch & dispatch() {
+            static const Dispatch d;
+            return d;
+        }
+
+    } // namespace
+
+    void Int8::quantize(const float* in, index_t n, float scale,
+                        std::uint8_t* out) {
+        float inverse = 1 / scale;
+        for (index_t i = 0; i < n; ++i) {
+            float q = std::nearbyint(in[i] * inverse);
+            q = std::min<float>(std::max<float>(q, -activation_max), activation_max);
+            out[i] = (std::uint8_t) ((int) q + zero_point);
+        }
+    }
+
+    float Int8::quantize_weights(const float* in, index_t n, std::int8_t* out) {
+        float range = 0;
+        for (index_t i = 0; i < n; ++i) {
+            range = std::max(range, std::abs(in[i]));
+        }
+
+        // channel of zeros stays zero with any scale
+        float scale = range > 0 ? range / weight_max : 1;
+        for (index_t i = 0; i < n; ++i) {
+            out[i] = (std::int8_t) std::nearbyint(in[i] / scale);
+        }
+        return scale;
+    }
+
+    std::int32_t Int8::dot(const std::uint8_t* a, const std::int8_t* w,
+                           index_t n) {
+        return dispatch().dot(a, w, n);
+    }
+
+    const char* Int8::isa() {
+        return dispatch().isa;
+    }
+
+} // namespace nl
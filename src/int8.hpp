@@ -0,0 +1,68 @@
+#ifndef NEURAL_LIB_INT8_H
+#define NEURAL_LIB_INT8_H
+
+#include <cstdint>
+
+#include "block.hpp"
+
+namespace nl {
+
+    ///
+    /// Kernels of 8-bit quantized inference. Activations are stored as
+    /// unsigned bytes shifted by zero_point, weights as signed bytes, and
+    /// their dot products are accumulated in 32-bit integers.
+    ///
+    /// The dot product uses AVX-512 VNNI or AVX2 whenever the CPU supports
+    /// them and portable code otherwise, all of them give identical results.
+    ///
+    class Int8 {
+    public:
+        /// Stored value of activation zero.
+        static const int zero_point = 128;
+        /// Largest magnitude of quantized activation.
+        static const int activation_max = 127;
+        ///
+        /// Largest magnitude of quantized weight. AVX2 adds products of two
+        /// neighbouring activations and weights in 16 bits with saturation,
+        /// 7 bits of weight keep the sum exact.
+        ///
+        static const int weight_max = 63;
+
+        ///
+        /// Quantize activations.
+        /// @param in values
+        /// @param n number of values
+        /// @param scale value of a single quantization step
+        /// @param out quantized values, rounded and clamped to
+        ///        activation_max and shifted by zero_point
+        ///
+        static void quantize(const float* in, index_t n, float scale,
+                             std::uint8_t* out);
+
+        ///
+        /// Quantize weights of a single output channel symmetrically.
+        /// @param in weights
+        /// @param n number of weights
+        /// @param out quantized weights
+        /// @return value of a single quantization step
+        ///
+        static float quantize_weights(const float* in, index_t n,
+                                      std::int8_t* out);
+
+        ///
+        /// Dot product of quantized activations and weights, zero point
+        /// of activations is not subtracted.
+        /// @param a activations
+        /// @param w weights
+        /// @param n length of both vectors
+        ///
+        static std::int32_t dot(const std::uint8_t* a, const std::int8_t* w,
+                                index_t n);
+
+        /// Name of the instruction set used by dot().
+        static const char* isa();
+    };
+
+} // namespace nl
+
+#endif // NEURAL_LIB_INT8_H
@@ -1,47 +1,148 @@
 
+#include <algorithm>
+#include <limits>
+
 #include "maxpool.hpp"
 
-namespace nl {    
+namespace nl {
+
+    namespace {
+
+        /// Value together with its offset in input block.
+        struct Candidate {
+            float value;
+            index_t position;
+        };
+
+        ///
+        /// Maxima of all windows of 'window' consecutive candidates,
+        /// by the van Herk/Gil-Werman algorithm. Sequence is split into
+        /// blocks of window size, every window is covered by a suffix of
+        /// one block and a prefix of the next one, so maximum of each
+        /// window takes three comparisons. Ties are resolved in favour
+        /// of the earlier candidate.
+        /// @param in candidates, each window starts at one of them
+        /// @param window length of window
+        /// @param out maxima, one for each window that fits into 'in'
+        /// @param prefix buffer for maxima of block prefixes
+        /// @param suffix buffer for maxima of block suffixes
+        ///
+        void running_max(const std::vector<Candidate> & in, index_t window,
+                         std::vector<Candidate> & out,
+                         std::vector<Candidate> & prefix,
+                         std::vector<Candidate> & suffix) {
+
+            index_t n = in.size();
+            prefix.resize(n);
+            suffix.resize(n);
+
+            for (index_t i = 0; i < n; ++i) {
+                if (i % window == 0 || in[i].value > prefix[i - 1].value)
+                    prefix[i] = in[i];
+                else
+                    prefix[i] = prefix[i - 1];
+            }
+            for (index_t i = n - 1; i >= 0; --i) {
+                if (i % window == window - 1 || i == n - 1 ||
+                    in[i].value >= suffix[i + 1].value)
+                    suffix[i] = in[i];
+                else
+                    suffix[i] = suffix[i + 1];
+            }
 
-    MaxPool::MaxPool(std::string name, block_ptr input,
-                     uint16_t window_size, uint16_t padding_size):
-        Op(name), input(input), 
-        window_size(window_size), padding_size(padding_size){
-            
-        if (input == nullptr)
-            throw nl::InputException();
+            out.resize(n - window + 1);
+            for (index_t i = 0; i + window <= n; ++i) {
+                const Candidate & right = prefix[i + window - 1];
+                out[i] = right.value > suffix[i].value ? right : suffix[i];
+            }
+        }
 
-        auto input_dims = input->dimensions();
-        if (input_dims.size() != 3)
-            throw nl::DimensionException();
+        ///
+        /// Maxima of windows without padding, with window and stride fixed
+        /// at compile time so that loops over the window are unrolled.
+        /// Ties are resolved as in MaxPool::find_maxima_direct().
+        /// @param in data of input block
+        /// @param depth depth of input and output
+        /// @param in_width width of input
+        /// @param out_width width of output
+        /// @param out_height height of output
+        /// @param out data of output block
+        /// @param argmax position of every maximum in 'in'
+        ///
+        template<int Window, int Stride>
+        void maxima_fixed(const float* in, index_t depth, index_t in_width,
+                          index_t out_width, index_t out_height,
+                          float* out, index_t* argmax) {
+            for (index_t h = 0; h < out_height; ++h) {
+                for (index_t w = 0; w < out_width; ++w) {
+                    index_t corner = depth * (Stride * w + in_width * Stride * h);
+                    for (index_t d = 0; d < depth; ++d) {
+                        float current = std::numeric_limits<float>::lowest();
+                        index_t position = corner + d;
+                        for (int y = 0; y < Window; ++y) {
+                            for (int z = 0; z < Window; ++z) {
+                                index_t i = corner + d + depth * (y + in_width * z);
+                                if (in[i] > current) {
+                                    current = in[i];
+                                    position = i;
+                                }
+                            }
+                        }
+                        *out++ = current;
+                        *argmax++ = position;
+                    }
+                }
+            }
+        }
 
-        // there is no reason to generate max from all zeros
-        if (padding_size >= window_size)
-            throw nl::InputException();
+        /// Shape of a specialized max pooling without padding.
+        struct PoolKernel {
+            index_t window, stride;
+            void (*maxima)(const float*, index_t, index_t, index_t, index_t,
+                           float*, index_t*);
+        };
 
-        // window is greater than observed area in at least one dim.
-        if (window_size > input_dims[1] + 2 * padding_size ||
-            window_size > input_dims[2] + 2 * padding_size)
-            throw nl::InputException();            
+        /// Window and stride of common max pooling layers.
+        const PoolKernel pool_kernels[] = {
+            {2, 1, maxima_fixed<2, 1>},
+            {2, 2, maxima_fixed<2, 2>},
+            {3, 1, maxima_fixed<3, 1>},
+            {3, 2, maxima_fixed<3, 2>},
+            {4, 4, maxima_fixed<4, 4>}
+        };
 
-        // create output
-        output = std::make_shared<Block>(name + "_out",
-                           input_dims[0], // same depth as input block
-                           input_dims[1] + 2 * padding_size - (window_size - 1),
-                           input_dims[2] + 2 * padding_size - (window_size - 1));
+    } // namespace
+
+    bool MaxPool::specialized = true;
+
+    MaxPool::MaxPool(std::string name, block_ptr input,
+                     index_t window_size, index_t padding_size,
+                     index_t stride):
+        Op(name), input(input),
+        window_size(window_size), padding_size(padding_size), stride(stride) {
+
+        init();
 
     }
 
-    MaxPool::MaxPool(std::string name, Op & op, 
-                     uint16_t window_size, uint16_t padding_size):
-        Op(name), window_size(window_size), padding_size(padding_size){
+    MaxPool::MaxPool(std::string name, Op & op,
+                     index_t window_size, index_t padding_size,
+                     index_t stride):
+        Op(name), window_size(window_size), padding_size(padding_size),
+        stride(stride) {
 
         if (op.outputs().size() != 1)
             throw nl::InputException();
 
         // take the only output of op as input of this max pool layer
         input = op.outputs().begin()->second;
-            
+
+        init();
+
+    }
+
+    void MaxPool::init() {
+
         if (input == nullptr)
             throw nl::InputException();
 
@@ -50,59 +151,46 @@ namespace nl {
             throw nl::DimensionException();
 
         // there is no reason to generate max from all zeros
-        if (padding_size >= window_size)
+        if (padding_size >= window_size || stride < 1)
             throw nl::InputException();
 
+        index_t padded_width = input_dims[1] + 2 * padding_size;
+        index_t padded_height = input_dims[2] + 2 * padding_size;
+
         // window is greater than observed area in at least one dim.
-        if (window_size > input_dims[1] + 2 * padding_size ||
-            window_size > input_dims[2] + 2 * padding_size)
-            throw nl::InputException();            
+        if (window_size > padded_width ||
+            window_size > padded_height)
+            throw nl::InputException();
+
+        // input depth slice would not be covered symmetricaly
+        // by windows due to stride
+        if ((padded_width - window_size) % stride != 0 ||
+            (padded_height - window_size) % stride != 0)
+            throw nl::InputException();
 
         // create output
         output = std::make_shared<Block>(name + "_out",
-                           input_dims[0],
-                           input_dims[1] + 2 * padding_size - (window_size - 1),
-                           input_dims[2] + 2 * padding_size - (window_size - 1));
+                           input_dims[0], // same depth as input block
+                           (padded_width - window_size) / stride + 1,
+                           (padded_height - window_size) / stride + 1);
 
     }
 
     void MaxPool::forward() {
-
-        // specify cell in output block that is being computed.
-        for (uint16_t x = 0; x < output->dimensions()[0]; ++x) {
-            for (uint16_t y = 0; y < output->dimensions()[1]; ++y) {
-                for (uint16_t z = 0; z < output->dimensions()[2]; ++z) {
-                    
-                    // get max for window for given output cell
-                    output->data(x,y,z) = 
-                         window_max(x,y - padding_size, z - padding_size);
-
-                }
-            }
-        }
-
+        find_maxima();
     }
 
     void MaxPool::backward() {
 
-        // specify cell in output block
-        for (uint16_t x = 0; x < output->dimensions()[0]; ++x) {
-            for (uint16_t y = 0; y < output->dimensions()[1]; ++y) {
-                for (uint16_t z = 0; z < output->dimensions()[2]; ++z) {
-
-                    // get first input cell that correspond to value 
-                    // in output cell
-                    auto coords = window_max_element(x,
-                                                     y - padding_size,
-                                                     z - padding_size);                    
-                    // add up gradient of that cell
-                    input->grad(std::get<0>(coords),
-                                std::get<1>(coords),
-                                std::get<2>(coords)) 
-                        += output->grad(x,y,z);
-                    
-                }
-            }
+        // maxima are known only after forward pass
+        if (argmax.size() != (std::size_t) output->data.size())
+            find_maxima();
+
+        // each output cell adds its gradient to its maximum
+        const float* out_grad = output->grad.data();
+        float* in_grad = input->grad.data();
+        for (std::size_t i = 0; i < argmax.size(); ++i) {
+            in_grad[argmax[i]] += out_grad[i];
         }
 
     }
@@ -111,7 +199,7 @@ namespace nl {
         block_map map;
         map.insert(std::pair<std::string, block_ptr>(output->name,
                                                   output));
-        return map;   
+        return map;
     }
 
     block_map MaxPool::inputs() {
@@ -121,50 +209,141 @@ namespace nl {
         return map;
     }
 
-    float MaxPool::window_max(uint16_t d, int16_t w, 
-                              int16_t h) {
-        float current = std::numeric_limits<float>::lowest();
+    void MaxPool::share(const block_map & blocks) {
+        replace(input, blocks);
+        replace(output, blocks);
+    }
+
+    Cost MaxPool::forward_cost() {
+        double in = input->data.size();
+        double out = output->data.size();
+
+        Cost c;
+        if (separable()) {
+            // three comparisons for every window along height
+            // and then along width
+            double columns = out / output->dimensions()[1] *
+                input->dimensions()[1];
+            c.flops = 3 * (columns + out);
+        } else {
+            // comparison for every cell of every window
+            c.flops = out * window_size * window_size;
+        }
+        c.bytes_read = in * sizeof(float);
+        c.bytes_written = out * sizeof(float);
+        return c;
+    }
 
-        int16_t x = d;
-        for (int16_t y = w; y < w + window_size; ++y) {
-            for (int16_t z = h; z < h + window_size; ++z) {
+    Cost MaxPool::backward_cost() {
+        double in = input->data.size();
+        double out = output->data.size();
 
-                if (y >= 0 && z >= 0)
-                    current = std::max(current, 
-                                       input->data(x,y,z));
+        // gradient of each output cell is added to its maximum
+        Cost c;
+        c.flops = out;
+        c.bytes_read = (in + out) * sizeof(float) + out * sizeof(index_t);
+        c.bytes_written = in * sizeof(float);
+        return c;
+    }
 
+    void MaxPool::find_maxima() {
+        argmax.resize(output->data.size());
+        if (separable())
+            find_maxima_separable();
+        else
+            find_maxima_direct();
+    }
+
+    void MaxPool::find_maxima_direct() {
+
+        auto in_dims = input->dimensions();
+        auto out_dims = output->dimensions();
+
+        for (const PoolKernel & k : pool_kernels) {
+            if (specialized && padding_size == 0 &&
+                k.window == window_size && k.stride == stride) {
+                k.maxima(input->data.data(), in_dims[0], in_dims[1],
+                         out_dims[1], out_dims[2], output->data.data(),
+                         argmax.data());
+                return;
             }
         }
 
-        return current;
+        // cells of output block in order of memory
+        std::size_t i = 0;
+        for (index_t h = 0; h < out_dims[2]; ++h) {
+            index_t z_from = std::max<index_t>(stride * h - padding_size, 0);
+            index_t z_to = std::min(stride * h - padding_size + window_size,
+                                    in_dims[2]);
+
+            for (index_t w = 0; w < out_dims[1]; ++w) {
+                index_t y_from = std::max<index_t>(stride * w - padding_size, 0);
+                index_t y_to = std::min(stride * w - padding_size + window_size,
+                                        in_dims[1]);
+
+                for (index_t d = 0; d < out_dims[0]; ++d) {
+                    float current = std::numeric_limits<float>::lowest();
+                    index_t position = d + in_dims[0] * (y_from + in_dims[1] * z_from);
+
+                    for (index_t y = y_from; y < y_to; ++y) {
+                        for (index_t z = z_from; z < z_to; ++z) {
+                            if (input->data(d,y,z) > current) {
+                                current = input->data(d,y,z);
+                                position = d + in_dims[0] * (y + in_dims[1] * z);
+                            }
+                        }
+                    }
+
+                    output->data.data()[i] = current;
+                    argmax[i++] = position;
+                }
+            }
+        }
     }
 
-    std::tuple<uint16_t, uint16_t, uint16_t>
-    MaxPool::window_max_element(uint16_t d, int16_t w, 
-                                int16_t h) {
-
-        float prev, current = std::numeric_limits<float>::lowest();            
-        int w_max = 0, h_max = 0; 
-
-        int16_t x = d;
-        for (int16_t y = w; y < w + window_size; ++y) {
-            for (int16_t z = h; z < h + window_size; ++z) {
-                
-                if (y >= 0 && z >= 0) {
-                    prev = current;
-                    current = std::max(current, 
-                                       input->data(x,y,z));
-                    // update coordinates if changer occured
-                    if (prev != current) {
-                        w_max = y;
-                        h_max = z;
-                    }                       
+    void MaxPool::find_maxima_separable() {
+
+        auto in_dims = input->dimensions();
+        auto out_dims = output->dimensions();
+
+        // cells of padding never win
+        const Candidate pad = {-std::numeric_limits<float>::infinity(), 0};
+
+        std::vector<Candidate> line, maxima, prefix, suffix;
+        // maxima along height, for every input column and output row
+        std::vector<Candidate> columns(in_dims[1] * out_dims[2]);
+
+        for (index_t d = 0; d < in_dims[0]; ++d) {
+
+            // windows along height, ties are won by the upper cell
+            for (index_t y = 0; y < in_dims[1]; ++y) {
+                line.assign(out_dims[2] + window_size - 1, pad);
+                for (index_t z = 0; z < in_dims[2]; ++z) {
+                    index_t position = d + in_dims[0] * (y + in_dims[1] * z);
+                    line[z + padding_size] = {input->data.data()[position],
+                                              position};
+                }
+                running_max(line, window_size, maxima, prefix, suffix);
+                for (index_t h = 0; h < out_dims[2]; ++h) {
+                    columns[y + in_dims[1] * h] = maxima[h];
                 }
+            }
 
+            // windows of column maxima along width, ties are won by
+            // the left column, which is the order of direct scan
+            for (index_t h = 0; h < out_dims[2]; ++h) {
+                line.assign(out_dims[1] + window_size - 1, pad);
+                for (index_t y = 0; y < in_dims[1]; ++y) {
+                    line[y + padding_size] = columns[y + in_dims[1] * h];
+                }
+                running_max(line, window_size, maxima, prefix, suffix);
+                for (index_t w = 0; w < out_dims[1]; ++w) {
+                    index_t i = d + out_dims[0] * (w + out_dims[1] * h);
+                    output->data.data()[i] = maxima[w].value;
+                    argmax[i] = maxima[w].position;
+                }
             }
         }
-
-        return std::make_tuple(d, w_max, h_max);
     }
 
 } // namespace nl
@@ -4,9 +4,10 @@
 
 #include <unordered_map>
 #include <limits>
-#include <tuple>
+#include <vector>
 
 #include <boost/serialization/shared_ptr.hpp>
+#include <boost/serialization/version.hpp>
 
 #include "block.hpp"
 #include "op.hpp"
@@ -19,7 +20,13 @@ namespace nl {
     /// maximum. Window moves in second and third dimensions (width & height) so
     /// the output block has the same depth as the input block. It is possible 
     /// to  pad input block with min. values on the side to allow higher 
-    /// flexibility of output.
+    /// flexibility of output. Window moving by more than one cell 
+    /// (typically by its own size) downsamples the input.
+    ///
+    /// With stride one, windows of at least 'separable_window' cells
+    /// are computed by the van Herk/Gil-Werman algorithm separately along
+    /// height and width, which costs a constant number of comparisons 
+    /// per output cell regardless of window size.
     /// 
     class MaxPool : public Op {
     public:
@@ -29,18 +36,22 @@ namespace nl {
         /// @param input block
         /// @param window_size length of the perception rectangle
         /// @param padding_size number of min. values added to input block
+        /// @param stride by how much does window move
         /// 
         MaxPool(std::string name, block_ptr input,
-                uint16_t window_size, uint16_t padding_size=0);        
+                index_t window_size, index_t padding_size=0, 
+                index_t stride=1);
         
         /// Constructor
         /// @param name name of the operation
         /// @param op output of this operation is used as input
         /// @param window_size length of the perception rectangle
         /// @param padding_size number of min. values added to input block
+        /// @param stride by how much does window move
         /// 
         MaxPool(std::string name, Op & op, 
-                uint16_t window_size, uint16_t padding_size=0);
+                index_t window_size, index_t padding_size=0,
+                index_t stride=1);
 
         virtual void forward();
 
@@ -50,7 +61,33 @@ namespace nl {
 
         virtual block_map inputs();
 
+        virtual void share(const block_map & blocks);
+
+        virtual Cost forward_cost();
+
+        virtual Cost backward_cost();
+
+        /// Smallest window computed by the separable algorithm.
+        static const index_t separable_window = 5;
+
+        ///
+        /// Use kernels compiled for fixed window and stride, which unroll
+        /// loops over the window, whenever one matches a layer without
+        /// padding. Other shapes are computed by the generic kernel.
+        /// Enabled by default.
+        /// @param enabled false to always use the generic kernel
+        ///
+        static void setSpecialized(bool enabled) {
+            specialized = enabled;
+        }
+
     private:
+        /// Shared init method
+        void init();
+        /// true iff windows are computed by the separable algorithm
+        bool separable() const {
+            return stride == 1 && window_size >= separable_window;
+        }
         /// Input block
         block_ptr input;
         /// Output block
@@ -60,7 +97,7 @@ namespace nl {
         /// The window is rectangular and two-dimensional so 
         /// the depth of a window is 1.
         ///
-        uint16_t window_size;
+        index_t window_size;
         ///
         /// Padding size
         /// Input gets padded equally along the borders in width
@@ -74,19 +111,30 @@ namespace nl {
         /// 000000
         /// 000000
         /// 
-        uint16_t padding_size;
-        /// Get maximum in window specified by its left upper corner
-        /// @param d first coordinate of corner
-        /// @param w second coordinate of corner
-        /// @param h third coordinate of corner
-        float window_max(uint16_t depth, int16_t width, int16_t height);
-        /// Get a position in block in which has the specified window the 
-        /// highest element
-        /// @param d first coordinate of corner
-        /// @param w second coordinate of corner
-        /// @param h third coordinate of corner
-        std::tuple<uint16_t, uint16_t, uint16_t>
-        window_max_element(uint16_t d, int16_t w, int16_t h);
+        index_t padding_size;
+        ///
+        /// How much does the window move after each iteration. Identical for
+        /// both dimensions of movement. 
+        /// 
+        index_t stride = 1;
+        ///
+        /// Position of the maximum of each window, as offset into data
+        /// of input block, in order of cells of output block. Filled
+        /// by forward pass and used by backward pass.
+        ///
+        std::vector<index_t> argmax;
+        /// True iff find_maxima_direct() may use a specialized kernel.
+        static bool specialized;
+        ///
+        /// Find maximum of every window, store it in output block and its
+        /// position in 'argmax'. Cells of padding are skipped, the first
+        /// maximum in order of width and then height wins.
+        ///
+        void find_maxima();
+        /// find_maxima() scanning every window.
+        void find_maxima_direct();
+        /// find_maxima() by running maxima along height and then width.
+        void find_maxima_separable();
 
         // default constructor, for serialization
         MaxPool(): Op("default_name") {}
@@ -99,10 +147,16 @@ namespace nl {
             ar & output;
             ar & window_size;
             ar & padding_size;
+            if (version > 0)
+                ar & stride;
         }
         friend class boost::serialization::access;
+        friend class ConvPool;
+        friend class Codegen;
     };
 
 } // namespace nl
 
+BOOST_CLASS_VERSION(nl::MaxPool, 1)
+
 #endif // NEURAL_LIB_MAXPOOL_H
@@ -1,5 +1,7 @@
 
+#include "conv_pool.hpp"
 #include "net.hpp"
+#include "profiler.hpp"
 
 namespace nl {
             
@@ -9,6 +11,11 @@ namespace nl {
         if (op == this)
             throw InputException();
 
+        // adding the same op again changes nothing
+        auto found = ops.find(op->name);
+        if (found != ops.end() && found->second == op)
+            return;
+
         // current ordering is invalid
         changed = true;
 
@@ -19,28 +26,27 @@ namespace nl {
         // insert op into graph
         g.add_vertex(op->name);
 
-        // add oriented edges leading from this op into the graph
+        // add oriented edges leading from this op to readers of its outputs
+        // and from writers of its inputs, only ops sharing a block with
+        // 'op' are visited
         for (auto & block_pair : op->outputs()) {
-            for (auto & op_pair : ops) {
-                Op* op2 = op_pair.second;
-                // there is a block that is simultaneously output of 'op'
-                // and input of 'op2'
-                if (op2->inputs()[block_pair.first])
-                    g.add_edge(op->name, op2->name);
+            auto readers = consumers.find(block_pair.first);
+            if (readers == consumers.end())
+                continue;
+            for (Op* op2 : readers->second) {
+                g.add_edge(op->name, op2->name);
             }
         }
-
-        // add oriented edges leading to this op into the graph
         for (auto & block_pair : op->inputs()) {
-            for (auto & op_pair : ops) {
-                Op* op2 = op_pair.second;
-                // there is a block that is simultaneously output of 'op2'
-                // and input of 'op'
-                if (op2->outputs()[block_pair.first])
-                    g.add_edge(op2->name, op->name);
+            auto writers = producers.find(block_pair.first);
+            if (writers == producers.end())
+                continue;
+            for (Op* op2 : writers->second) {
+                g.add_edge(op2->name, op->name);
             }
-        }        
-        
+        }
+
+        index(op);
     }
 
     void Net::forward() {
@@ -48,6 +54,7 @@ namespace nl {
         ordering_is_current();
         // sequentially run all (in reverse)
         for (auto & op : ordering) {
+            Profiler::Scope scope(op, "forward");
             op->forward();
         }
     } 
@@ -56,23 +63,28 @@ namespace nl {
         // make sure that we are working with up-to-date op order
         ordering_is_current();
         // sequetially run all (in reverse)
-        for (int16_t i = ordering.size() - 1; i >= 0; --i) {
+        for (index_t i = ordering.size() - 1; i >= 0; --i) {
+            Profiler::Scope scope(ordering[i], "backward");
             ordering[i]->backward();            
         }
     } 
 
+    void Net::backward(const std::function<void(Op*)> & done) {
+        ordering_is_current();
+        for (index_t i = ordering.size() - 1; i >= 0; --i) {
+            {
+                Profiler::Scope scope(ordering[i], "backward");
+                ordering[i]->backward();
+            }
+            done(ordering[i]);
+        }
+    }
+
     block_map Net::inputs() {
         block_map map;
         // find blocks that do not serve as output of any op in the net
-        for (auto & block_pair : blocks) { // try all blocks
-            bool present = false;
-            for (auto & op_pair : ops) { 
-                Op* op = op_pair.second;
-                if (op->outputs()[block_pair.first] != nullptr)
-                    present = true;
-            }
-
-            if (!present)
+        for (auto & block_pair : blocks) {
+            if (producers.find(block_pair.first) == producers.end())
                 map.insert(block_pair);
         }
         return map;
@@ -81,20 +93,110 @@ namespace nl {
     block_map Net::outputs() {
         block_map map;
         // find blocks that do not serve as input of any op in the net
-        for (auto & block_pair : blocks) { // try all blocks
-            bool present = false;
-            for (auto & op_pair : ops) { 
-                Op* op = op_pair.second;
-                if (op->inputs()[block_pair.first] != nullptr)
-                    present = true;
-            }
-
-            if (!present)
+        for (auto & block_pair : blocks) {
+            if (consumers.find(block_pair.first) == consumers.end())
                 map.insert(block_pair);
         }
         return map;
     }
 
+    void Net::shard(index_t index, index_t count) {
+        for (auto & op_pair : ops) {
+            op_pair.second->shard(index, count);
+        }
+    }
+
+    void Net::share(const block_map & shared) {
+
+        for (auto & op_pair : ops) {
+            op_pair.second->share(shared);
+        }
+
+        // keep map of blocks consistent with ops
+        for (auto & block_pair : blocks) {
+            replace(block_pair.second, shared);
+        }
+    }
+
+    Cost Net::forward_cost() {
+        Cost c;
+        for (auto & op_pair : ops) {
+            c += op_pair.second->forward_cost();
+        }
+        return c;
+    }
+
+    Cost Net::backward_cost() {
+        Cost c;
+        for (auto & op_pair : ops) {
+            c += op_pair.second->backward_cost();
+        }
+        return c;
+    }
+
+    std::size_t Net::fuse() {
+
+        std::vector<std::unique_ptr<Op>> created;
+        std::vector<Op*> replaced;
+
+        for (auto & op_pair : ops) {
+            Conv* conv = dynamic_cast<Conv*>(op_pair.second);
+            if (conv == nullptr)
+                continue;
+
+            // output of the convolution must be read only by max pooling
+            std::string out = conv->outputs().begin()->first;
+            auto readers = consumers.find(out);
+            MaxPool* pool = readers != consumers.end() &&
+                readers->second.size() == 1 ?
+                dynamic_cast<MaxPool*>(readers->second[0]) : nullptr;
+            if (pool == nullptr)
+                continue;
+
+            created.emplace_back(new ConvPool(*conv, *pool));
+            replaced.push_back(conv);
+            replaced.push_back(pool);
+        }
+
+        std::size_t count = created.size();
+        if (count > 0)
+            replace_ops(replaced, std::move(created));
+        return count;
+    }
+
+    void Net::replace_ops(const std::vector<Op*> & removed,
+                          std::vector<std::unique_ptr<Op>> added) {
+
+        std::unordered_map<Op*, bool> is_removed;
+        for (Op* op : removed) {
+            is_removed[op] = true;
+        }
+
+        // build the network again from remaining and added ops
+        std::vector<Op*> remaining;
+        for (auto & op_pair : ops) {
+            if (!is_removed[op_pair.second])
+                remaining.push_back(op_pair.second);
+        }
+        for (auto & op : added) {
+            remaining.push_back(op.get());
+        }
+
+        ops.clear();
+        blocks.clear();
+        producers.clear();
+        consumers.clear();
+        g = Graph();
+        ordering.clear();
+        for (Op* op : remaining) {
+            add(op);
+        }
+
+        for (auto & op : added) {
+            owned.push_back(std::move(op));
+        }
+    }
+
     void Net::insert_into_maps(Op* op) {        
         // insert op into map of ops
         if (ops[op->name] != nullptr && // value is in map
@@ -124,6 +226,15 @@ namespace nl {
         }        
     }
 
+    void Net::index(Op* op) {
+        for (auto & block_pair : op->outputs()) {
+            producers[block_pair.first].push_back(op);
+        }
+        for (auto & block_pair : op->inputs()) {
+            consumers[block_pair.first].push_back(op);
+        }
+    }
+
     void Net::ordering_is_current() {
 
         // if there is no change in graph from last update or graph is empty,
@@ -136,7 +247,7 @@ namespace nl {
         std::vector<Op*> new_ordering;
 
         // translate names to block pointers and update 'ordering'
-        for (uint16_t i = 0; i < ordering_names.size(); ++i) {
+        for (std::size_t i = 0; i < ordering_names.size(); ++i) {
             new_ordering.push_back(ops[ordering_names[i]]);
         }
 
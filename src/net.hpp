@@ -1,7 +1,9 @@
 #ifndef NEURAL_LIB_NET_H
 #define NEURAL_LIB_NET_H
 
+#include <functional>
 #include <iostream>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
@@ -34,10 +36,45 @@ namespace nl {
 
         virtual void backward();
 
+        /// Backward pass that reports every op once it is computed.
+        /// @param done function called with each op after its backward pass
+        void backward(const std::function<void(Op*)> & done);
+
         virtual block_map inputs();
 
         virtual block_map outputs();
 
+        /// Split data sources of all ops in the net.
+        virtual void shard(index_t index, index_t count);
+
+        /// Replace blocks in all ops of the net and in map 'blocks'.
+        virtual void share(const block_map & shared);
+
+        virtual Cost forward_cost();
+
+        virtual Cost backward_cost();
+
+        ///
+        /// Replace chains of ops by fused ops that compute the same result
+        /// with less memory traffic. Currently every Conv whose output is
+        /// read only by a single MaxPool is fused with it into ConvPool.
+        /// Output block of such Conv is removed from the network and 
+        /// is no longer updated. Fused ops are owned by the network,
+        /// nested networks are not affected.
+        /// @return number of created fused ops
+        ///
+        std::size_t fuse();
+
+        ///
+        /// Replace ops of the network by other ops, which are owned by
+        /// the network from then on. Network is built again from the
+        /// remaining and added ops.
+        /// @param removed ops that are removed
+        /// @param added ops that are inserted
+        ///
+        void replace_ops(const std::vector<Op*> & removed,
+                         std::vector<std::unique_ptr<Op>> added);
+
         /// Unordered set of all blocks in the net identified by their names.        
 		block_map blocks;
         /// Unordered map of all ops in the net identified by their names.
@@ -55,6 +92,8 @@ namespace nl {
         /// Insert op and its corresponding input and output blocks 
         /// into maps 'ops' and 'blocks'
         void insert_into_maps(Op* op);
+        /// Record op as producer of its outputs and consumer of its inputs.
+        void index(Op* op);
         /// True iff some changes were made to the graph (new edge
         /// or vertex was added) after last call of g.get_ordering().
         bool changed = false;
@@ -63,6 +102,12 @@ namespace nl {
         /// Sequence of operations that describes order of computation
         /// in forward pass. Everything is reversed in backward pass
         std::vector<Op*> ordering;
+        /// Ops writing every block, by name of the block.
+        std::unordered_map<std::string, std::vector<Op*>> producers;
+        /// Ops reading every block, by name of the block.
+        std::unordered_map<std::string, std::vector<Op*>> consumers;
+        /// Ops created by fuse() and given to replace_ops().
+        std::vector<std::unique_ptr<Op>> owned;
         
         // Default constructor, for serialization purposes
         Net(): Op("default_name") {}
@@ -87,6 +132,10 @@ namespace nl {
             ar & g;
             ar & ordering;
             ar & changed;
+            // indexes are not saved, they follow from the ops
+            for (auto & op_pair : ops) {
+                index(op_pair.second);
+            }
         }
         BOOST_SERIALIZATION_SPLIT_MEMBER()
 
@@ -1,18 +1,36 @@
 #ifndef NEURAL_LIB_H
 #define NEURAL_LIB_H
 
+#include "autotuner.hpp"
 #include "block.hpp"
+#include "codegen.hpp"
+#include "context.hpp"
 #include "conv.hpp"
+#include "conv_pool.hpp"
+#include "csr.hpp"
 #include "dense.hpp"
+#include "engine.hpp"
 #include "error.hpp"
+#include "fft.hpp"
 #include "exceptions.hpp"
+#include "gradient_exchange.hpp"
 #include "graph.hpp"
+#include "half.hpp"
+#include "int8.hpp"
 #include "maxpool.hpp"
 #include "net.hpp"
 #include "neuron.hpp"
 #include "op.hpp"
+#include "parallel_solver.hpp"
+#include "profiler.hpp"
+#include "pruner.hpp"
+#include "quantized_conv.hpp"
+#include "quantized_dense.hpp"
+#include "quantizer.hpp"
 #include "random.hpp"
 #include "reader.hpp"
+#include "replica.hpp"
+#include "ring.hpp"
 #include "serialization.hpp"
 #include "softmax.hpp"
 #include "solver.hpp"
@@ -0,0 +1,182 @@
+
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#include <boost/archive/text_iarchive.hpp>
+
+#include "context.hpp"
+#include "neural_c.h"
+#include "net.hpp"
+
+/// Loaded network, ops created by the archive are owned by the model.
+struct nl_model {
+    nl::Net net{"model"};
+
+    ~nl_model() {
+        release(net);
+    }
+
+    /// Delete ops of a network, including those of nested networks.
+    static void release(nl::Net & net) {
+        for (auto & op_pair : net.ops) {
+            nl::Net* nested = dynamic_cast<nl::Net*>(op_pair.second);
+            if (nested != nullptr)
+                release(*nested);
+            delete op_pair.second;
+        }
+    }
+};
+
+/// Context with buffers bound to its blocks.
+struct nl_context {
+    explicit nl_context(nl::Net & net): context(net) {}
+
+    /// A bound input buffer.
+    struct Binding {
+        nl::block_ptr block;
+        const float* data;
+    };
+
+    nl::Context context;
+    std::vector<Binding> bindings;
+};
+
+namespace {
+
+    /// Block of a context, or null if there is no such block.
+    nl::block_ptr find(nl_context* context, const char* name) {
+        auto & blocks = context->context.net().blocks;
+        auto it = blocks.find(name);
+        return it == blocks.end() ? nullptr : it->second;
+    }
+
+} // namespace
+
+extern "C" {
+
+const char* nl_status_string(nl_status status) {
+    switch (status) {
+        case NL_OK:
+            return "Success.";
+        case NL_ERROR_FILE:
+            return "Model file could not be opened.";
+        case NL_ERROR_FORMAT:
+            return "Model file is not a saved network.";
+        case NL_ERROR_NAME:
+            return "No block of given name.";
+        case NL_ERROR_DIMENSION:
+            return "Dimension mismatch.";
+        case NL_ERROR_ARGUMENT:
+            return "Invalid argument.";
+        case NL_ERROR_RUN:
+            return "Forward pass failed.";
+    }
+    return "Unknown status.";
+}
+
+nl_status nl_model_load(const char* path, nl_model** model) {
+    if (path == nullptr || model == nullptr)
+        return NL_ERROR_ARGUMENT;
+
+    std::ifstream ifs(path);
+    if (!ifs)
+        return NL_ERROR_FILE;
+
+    std::unique_ptr<nl_model> loaded(new nl_model());
+    try {
+        boost::archive::text_iarchive ia(ifs);
+        ia >> loaded->net;
+    } catch (...) {
+        return NL_ERROR_FORMAT;
+    }
+    *model = loaded.release();
+    return NL_OK;
+}
+
+void nl_model_free(nl_model* model) {
+    delete model;
+}
+
+nl_status nl_context_create(nl_model* model, nl_context** context) {
+    if (model == nullptr || context == nullptr)
+        return NL_ERROR_ARGUMENT;
+    try {
+        *context = new nl_context(model->net);
+    } catch (...) {
+        return NL_ERROR_RUN;
+    }
+    return NL_OK;
+}
+
+void nl_context_free(nl_context* context) {
+    delete context;
+}
+
+nl_status nl_context_dims(nl_context* context, const char* name,
+                          int64_t dims[3]) {
+    if (context == nullptr || name == nullptr || dims == nullptr)
+        return NL_ERROR_ARGUMENT;
+    nl::block_ptr b = find(context, name);
+    if (b == nullptr)
+        return NL_ERROR_NAME;
+    std::vector<nl::index_t> d = b->dimensions();
+    for (int i = 0; i < 3; ++i) {
+        dims[i] = d[i];
+    }
+    return NL_OK;
+}
+
+nl_status nl_context_bind_input(nl_context* context, const char* name,
+                                const float* data, int64_t size) {
+    if (context == nullptr || name == nullptr || data == nullptr)
+        return NL_ERROR_ARGUMENT;
+    nl::block_ptr b = find(context, name);
+    if (b == nullptr)
+        return NL_ERROR_NAME;
+    if (size != b->data.size())
+        return NL_ERROR_DIMENSION;
+
+    for (auto & binding : context->bindings) {
+        if (binding.block == b) {
+            binding.data = data;
+            return NL_OK;
+        }
+    }
+    context->bindings.push_back({b, data});
+    return NL_OK;
+}
+
+nl_status nl_context_run(nl_context* context) {
+    if (context == nullptr)
+        return NL_ERROR_ARGUMENT;
+    try {
+        for (auto & binding : context->bindings) {
+            nl::Block & b = *binding.block;
+            std::memcpy(b.data.data(), binding.data,
+                        b.data.size() * sizeof(float));
+            if (b.precision() != nl::FP32)
+                b.store();
+        }
+        context->context.forward();
+    } catch (...) {
+        return NL_ERROR_RUN;
+    }
+    return NL_OK;
+}
+
+nl_status nl_context_output(nl_context* context, const char* name,
+                            const float** data, int64_t* size) {
+    if (context == nullptr || name == nullptr || data == nullptr)
+        return NL_ERROR_ARGUMENT;
+    nl::block_ptr b = find(context, name);
+    if (b == nullptr)
+        return NL_ERROR_NAME;
+    *data = b->data.data();
+    if (size != nullptr)
+        *size = b->data.size();
+    return NL_OK;
+}
+
+} // extern "C"
@@ -0,0 +1,113 @@
+#ifndef NEURAL_LIB_C_H
+#define NEURAL_LIB_C_H
+
+/*
+C interface of neural_lib for inference. It depends on no C++ types, so
+programs in C and languages with a C foreign function interface can run
+trained networks from libneural without sharing its compiler, C++ ABI
+or boost version.
+
+A model is a network saved by boost::archive::text_oarchive. Any number
+of contexts may be created from a model and run from different threads
+at the same time, each context from a single thread; all of them share
+weights of the model, which has to outlive them.
+
+Blocks are identified by their names and hold depth x width x height
+values in single precision; value (d, x, y) is at d + depth * (x + width
+* y). Input buffers are bound once and read by every run, output pointers
+stay valid until the context is freed. Runs allocate no memory.
+*/
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Result of every call that may fail. */
+typedef enum {
+    NL_OK = 0,
+    /** model file could not be opened */
+    NL_ERROR_FILE,
+    /** model file is not a saved network */
+    NL_ERROR_FORMAT,
+    /** network has no block of given name */
+    NL_ERROR_NAME,
+    /** buffer size differs from size of the block */
+    NL_ERROR_DIMENSION,
+    /** null pointer passed */
+    NL_ERROR_ARGUMENT,
+    /** forward pass failed */
+    NL_ERROR_RUN
+} nl_status;
+
+/** Loaded network with weights. */
+typedef struct nl_model nl_model;
+
+/** Execution context of a model, with its own activations. */
+typedef struct nl_context nl_context;
+
+/** Brief description of a status. */
+const char* nl_status_string(nl_status status);
+
+/**
+ * Load a model.
+ * @param path file written by boost::archive::text_oarchive from nl::Net
+ * @param model loaded model, released by nl_model_free()
+ */
+nl_status nl_model_load(const char* path, nl_model** model);
+
+/** Release a model, all of its contexts have to be freed before. */
+void nl_model_free(nl_model* model);
+
+/**
+ * Create an execution context.
+ * @param model loaded model
+ * @param context new context, released by nl_context_free()
+ */
+nl_status nl_context_create(nl_model* model, nl_context** context);
+
+/** Release a context. */
+void nl_context_free(nl_context* context);
+
+/**
+ * Dimensions of a block.
+ * @param context execution context
+ * @param name name of the block
+ * @param dims depth, width and height of the block
+ */
+nl_status nl_context_dims(nl_context* context, const char* name,
+                          int64_t dims[3]);
+
+/**
+ * Bind a buffer that is copied into a block before every run. Binding
+ * the same block again replaces the buffer.
+ * @param context execution context
+ * @param name name of the block
+ * @param data buffer, it has to stay valid while the context runs
+ * @param size number of values in the buffer, equal to size of the block
+ */
+nl_status nl_context_bind_input(nl_context* context, const char* name,
+                                const float* data, int64_t size);
+
+/**
+ * Run the forward pass on bound inputs.
+ * @param context execution context
+ */
+nl_status nl_context_run(nl_context* context);
+
+/**
+ * Values of a block, e.g. of the output, without a copy.
+ * @param context execution context
+ * @param name name of the block
+ * @param data values, they change with every run of the context
+ * @param size number of values, may be null
+ */
+nl_status nl_context_output(nl_context* context, const char* name,
+                            const float** data, int64_t* size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NEURAL_LIB_C_H */
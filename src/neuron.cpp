@@ -170,4 +170,35 @@ namespace nl {
         return map;
     }
 
+    void Neuron::share(const block_map & blocks) {
+        for (auto & p : input_vector) {
+            replace(p.input, blocks);
+            replace(p.weight, blocks);
+        }
+        replace(output, blocks);
+        replace(threshold, blocks);
+    }
+
+    Cost Neuron::forward_cost() {
+        double n = input_vector.size();
+
+        // weighted sum, threshold and transfer function
+        Cost c;
+        c.flops = 2 * n + 2;
+        c.bytes_read = (2 * n + 1) * sizeof(float);
+        c.bytes_written = sizeof(float);
+        return c;
+    }
+
+    Cost Neuron::backward_cost() {
+        double n = input_vector.size();
+
+        // transfer function, gradient of inputs, weights and threshold
+        Cost c;
+        c.flops = 4 * n + 3;
+        c.bytes_read = (4 * n + 3) * sizeof(float);
+        c.bytes_written = (2 * n + 1) * sizeof(float);
+        return c;
+    }
+
 } // namespace nl
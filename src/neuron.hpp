@@ -85,6 +85,12 @@ namespace nl {
 
         virtual block_map inputs();
 
+        virtual void share(const block_map & blocks);
+
+        virtual Cost forward_cost();
+
+        virtual Cost backward_cost();
+
     private:
         friend class boost::serialization::access;
 
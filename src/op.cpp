@@ -16,4 +16,51 @@ namespace nl {
         }
     }
 
+    Cost Op::forward_cost() {
+        Cost c;
+        for (auto & pair : inputs()) {
+            c.bytes_read += bytes(pair.second);
+        }
+        for (auto & pair : outputs()) {
+            c.bytes_written += bytes(pair.second);
+        }
+        return c;
+    }
+
+    Cost Op::backward_cost() {
+        Cost c;
+        // data and gradient of inputs are read, gradient is written
+        for (auto & pair : inputs()) {
+            c.bytes_read += 2 * bytes(pair.second);
+            c.bytes_written += bytes(pair.second);
+        }
+        for (auto & pair : outputs()) {
+            c.bytes_read += bytes(pair.second);
+        }
+        return c;
+    }
+
+    void Op::share(const block_map & blocks) {
+        for (auto & pair : inputs()) {
+            if (blocks.count(pair.second->name))
+                throw UnsupportedException();
+        }
+        for (auto & pair : outputs()) {
+            if (blocks.count(pair.second->name))
+                throw UnsupportedException();
+        }
+    }
+
+    void Op::replace(block_ptr & block, const block_map & blocks) {
+
+        auto it = blocks.find(block->name);
+        if (it == blocks.end())
+            return;
+
+        if (it->second->dimensions() != block->dimensions())
+            throw DimensionException();
+
+        block = it->second;
+    }
+
 } // namespace nl
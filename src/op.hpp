@@ -5,12 +5,44 @@
 #include <unordered_map>
 
 #include "block.hpp"
+#include "exceptions.hpp"
 
 // resolve circular dependency
 class Block;
 
 namespace nl {
 
+    ///
+    /// Analytic amount of work of a single pass of an op, derived from
+    /// dimensions of its blocks. A multiplication followed by an addition
+    /// counts as two floating point operations, comparisons and
+    /// transfer functions count as one.
+    ///
+    struct Cost {
+        /// floating point operations
+        double flops = 0;
+        /// bytes read from blocks
+        double bytes_read = 0;
+        /// bytes written to blocks
+        double bytes_written = 0;
+
+        /// Total number of bytes moved.
+        double bytes() const {
+            return bytes_read + bytes_written;
+        }
+        /// Arithmetic intensity, floating point operations per byte.
+        double intensity() const {
+            return bytes() > 0 ? flops / bytes() : 0;
+        }
+        /// Add work of another pass.
+        Cost & operator+=(const Cost & other) {
+            flops += other.flops;
+            bytes_read += other.bytes_read;
+            bytes_written += other.bytes_written;
+            return *this;
+        }
+    };
+
     /// Abstract class representing all nodes in computational graph
     /// that actually perform any kind of computation.
 	class Op {
@@ -47,12 +79,62 @@ namespace nl {
         ///
         void zero_grad();
 
+        ///
+        /// Restrict the op to a single part of its data source. Parts are
+        /// disjoint and together cover the whole source, so several copies
+        /// of a network can each process their own share of samples.
+        /// Only ops that read data (readers) are affected, the rest 
+        /// ignore this call.
+        /// @param index index of the part that is used, lower than count
+        /// @param count number of parts the data source is split into
+        ///
+        virtual void shard(index_t index, index_t count) {}
+
+        ///
+        /// Replace blocks used by the op with blocks of the same name from
+        /// given map. Blocks that are not in the map are kept. This allows 
+        /// several copies of a network to work with the same weights.
+        /// Op keeps its blocks in its own members, so by default it only
+        /// accepts a map that contains none of them.
+        /// @param blocks blocks that should be used instead of current ones
+        /// @throw UnsupportedException if the op should replace a block
+        /// and does not override this method
+        ///
+        virtual void share(const block_map & blocks);
+
+        ///
+        /// Work done by forward pass. By default, no arithmetic is counted
+        /// and all inputs are read and all outputs written once.
+        ///
+        virtual Cost forward_cost();
+
+        ///
+        /// Work done by backward pass. By default, no arithmetic is counted,
+        /// inputs and gradient of outputs are read and gradient of inputs
+        /// is accumulated.
+        ///
+        virtual Cost backward_cost();
+
         ///
         /// Name of the operation. It needs to be unique within a network 
         /// as it is used as an identifier,
         ///
 		std::string name;        
 
+    protected:
+        ///
+        /// Replace block by a block of the same name from given map,
+        /// if there is one. Both blocks must have the same dimensions.
+        /// @param block block that is possibly replaced
+        /// @param blocks blocks that should be used instead of current ones
+        ///
+        static void replace(block_ptr & block, const block_map & blocks);
+
+        /// Number of bytes of data tensor of block.
+        static double bytes(const block_ptr & block) {
+            return block->data.size() * sizeof(float);
+        }
+
     private:
         template<class Archive>
         void serialize(Archive & ar, const unsigned int version)
@@ -0,0 +1,247 @@
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+
+#include "parallel_solver.hpp"
+
+namespace nl {
+
+    ParallelSolver::ParallelSolver(Net & net, block_ptr output_block,
+                                   block_ptr desired_block,
+                                   index_t replica_count):
+        net(net) {
+
+        if (replica_count == 0)
+            throw InputException();
+
+        std::vector<block_ptr> output = {output_block};
+        std::vector<block_ptr> desired = {desired_block};
+        init(replica_count, output, desired);
+    }
+
+    ParallelSolver::ParallelSolver(Net & net,
+                                   std::vector<block_ptr> output,
+                                   std::vector<block_ptr> desired,
+                                   index_t replica_count):
+        net(net) {
+
+        if (replica_count == 0)
+            throw InputException();
+
+        init(replica_count, output, desired);
+    }
+
+    ParallelSolver::~ParallelSolver() {
+        // original network reads all of its data again
+        net.shard(0, 1);
+    }
+
+    void ParallelSolver::init(index_t replica_count,
+                              std::vector<block_ptr> output,
+                              std::vector<block_ptr> desired) {
+
+        // names of trainable blocks, identical in all replicas
+        std::vector<std::string> names;
+        for (auto & block_pair : net.blocks) {
+            if (block_pair.second->trainable)
+                names.push_back(block_pair.first);
+        }
+        std::sort(names.begin(), names.end());
+
+        // original network is the first replica
+        net.shard(0, replica_count);
+        solvers.emplace_back(new Solver(net, output, desired));
+        trainable.emplace_back();
+        gradient_size = 0;
+        for (auto & name : names) {
+            trainable[0].push_back(net.blocks[name]);
+            gradient_size += net.blocks[name]->grad.size();
+        }
+
+        for (index_t i = 1; i < replica_count; ++i) {
+
+            replicas.emplace_back(new Replica(net));
+            Net & copy = replicas.back()->net();
+            copy.shard(i, replica_count);
+
+            // weights of the original network are read by all replicas,
+            // each replica accumulates gradient of its own
+            block_map weights;
+            for (auto & name : names) {
+                weights[name] = Block::alias(*net.blocks[name]);
+            }
+            copy.share(weights);
+
+            // desired blocks do not have to be part of the network,
+            // in that case they are shared by all replicas
+            solvers.emplace_back(new Solver(copy, 
+                                            Solver::corresponding(copy, output),
+                                            Solver::corresponding(copy, desired)));
+
+            trainable.emplace_back();
+            for (auto & name : names) {
+                trainable[i].push_back(copy.blocks[name]);
+            }
+        }
+
+    }
+
+    float ParallelSolver::train(index_t cycles) {
+
+        index_t count = solvers.size();
+        Barrier barrier(count);
+        solvers[0]->init_master();
+        std::vector<std::exception_ptr> errors(count);
+
+        auto work = [&](index_t index) {
+            try {
+                run(index, cycles, barrier);
+            } catch (...) {
+                // let other threads finish instead of waiting forever
+                errors[index] = std::current_exception();
+                barrier.do_break();
+            }
+        };
+
+        // first replica is trained by the calling thread
+        std::vector<std::thread> threads;
+        for (index_t i = 1; i < count; ++i) {
+            threads.emplace_back(work, i);
+        }
+        work(0);
+        for (auto & t : threads) {
+            t.join();
+        }
+
+        for (auto & e : errors) {
+            if (e)
+                std::rethrow_exception(e);
+        }
+
+        // mean error of all replicas
+        float error = 0;
+        for (auto & s : solvers) {
+            error += Error::L2(s->output, s->desired);
+        }
+        return error / count;
+    }
+
+    void ParallelSolver::run(index_t index, index_t cycles,
+                             Barrier & barrier) {
+
+        Solver & solver = *solvers[index];
+
+        for (index_t i = 0; i < cycles; ++i) {
+
+            // shared weights are updated only by the first replica
+            if (index == 0)
+                solver.begin_cycle();
+
+            // momentum step needs to be done before forward passes
+            if (!barrier.wait())
+                return;
+
+            solver.accumulate_gradient();
+
+            // all replicas need to finish their batch
+            if (!barrier.wait())
+                return;
+
+            all_reduce(index);
+
+            // all parts of gradient need to be reduced
+            if (!barrier.wait())
+                return;
+
+            if (index == 0)
+                solver.end_cycle();
+        }
+
+    }
+
+    void ParallelSolver::all_reduce(index_t index) {
+
+        std::size_t count = trainable.size();
+
+        // part of the gradient vector reduced by this thread
+        std::size_t begin = gradient_size * index / count;
+        std::size_t end = gradient_size * (index + 1) / count;
+
+        float scale = 1.0 / count;
+
+        // position of current block in gradient vector
+        std::size_t offset = 0;
+
+        for (std::size_t b = 0; b < trainable[0].size(); ++b) {
+
+            std::size_t size = trainable[0][b]->grad.size();
+
+            // intersection of block with reduced part
+            std::size_t from = std::max(begin, offset);
+            std::size_t to = std::min(end, offset + size);
+            offset += size;
+
+            if (from >= to)
+                continue;
+
+            from -= offset - size;
+            to -= offset - size;
+
+            // mean of gradients is stored in the first replica,
+            // which updates the weights
+            float* sum = trainable[0][b]->grad.data();
+            for (std::size_t r = 1; r < count; ++r) {
+                const float* g = trainable[r][b]->grad.data();
+                for (std::size_t j = from; j < to; ++j) {
+                    sum[j] += g[j];
+                }
+            }
+            for (std::size_t j = from; j < to; ++j) {
+                sum[j] *= scale;
+            }
+        }
+
+    }
+
+    void ParallelSolver::setMethod(std::string name) {
+        solvers[0]->setMethod(name);
+    }
+
+    void ParallelSolver::setLRDecay(float multiplier, index_t period) {
+        solvers[0]->setLRDecay(multiplier, period);
+    }
+
+    void ParallelSolver::setBatchSize(index_t size) {
+        for (auto & s : solvers) {
+            s->setBatchSize(size);
+        }
+    }
+
+    bool ParallelSolver::Barrier::wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        if (broken)
+            return false;
+
+        uint64_t current = generation;
+
+        // last thread releases all others
+        if (++waiting == count) {
+            waiting = 0;
+            generation++;
+            cv.notify_all();
+            return true;
+        }
+
+        cv.wait(lock, [&] { return current != generation || broken; });
+        return current != generation;
+    }
+
+    void ParallelSolver::Barrier::do_break() {
+        std::lock_guard<std::mutex> lock(mutex);
+        broken = true;
+        cv.notify_all();
+    }
+
+} // namespace nl
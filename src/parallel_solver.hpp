@@ -0,0 +1,134 @@
+#ifndef NEURAL_LIB_PARALLEL_SOLVER_H
+#define NEURAL_LIB_PARALLEL_SOLVER_H
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "block.hpp"
+#include "net.hpp"
+#include "replica.hpp"
+#include "solver.hpp"
+
+namespace nl {
+
+    ///
+    /// Solver that trains a network synchronously on several threads.
+    /// Network is copied into replicas, the original network being the
+    /// first of them, and each replica is trained by its own thread
+    /// on its own shard of data read by reader ops. All replicas read
+    /// the weights of the original network, but accumulate gradient in
+    /// blocks of their own (see Block::alias()). After every replica
+    /// accumulates gradient of its batch, gradients of all replicas are
+    /// averaged (all-reduce) into the original network and its solver
+    /// performs the single weight update.
+    ///
+    /// Replicas are created in the constructor, changes to the network
+    /// made afterwards are not reflected in them.
+    ///
+    class ParallelSolver {
+    public:
+        /// Constructor.
+        /// @param net neural network that is being trained
+        /// @param output_block block in which computation result will
+        /// be stored
+        /// @param desired_block block with correct result data
+        /// @param replica_count number of replicas and threads
+        ParallelSolver(Net & net, block_ptr output_block,
+                       block_ptr desired_block, index_t replica_count);
+        /// Constructor.
+        /// @param net neural network that is being trained
+        /// @param output vector of blocks in which computation result will
+        /// be stored
+        /// @param desired vector of blocks with correct result data.
+        /// @param replica_count number of replicas and threads
+        ParallelSolver(Net & net,
+                       std::vector<block_ptr> output,
+                       std::vector<block_ptr> desired,
+                       index_t replica_count);
+        /// Destructor. Original network reads whole data source again.
+        ~ParallelSolver();
+        /// Run given number of training cycles on all replicas. In each
+        /// cycle, every replica processes a single batch so the update
+        /// is computed from replica_count * batch size samples.
+        /// @param cycles how many times should the update be performed
+        /// @return mean error of all replicas from the last cycle
+        float train(index_t cycles=1);
+        /// Specify learning method, same as Solver::setMethod().
+        void setMethod(std::string name);
+        /// Set learning rate decay, same as Solver::setLRDecay().
+        void setLRDecay(float multiplier, index_t period);
+        /// Set batch size of each replica, same as Solver::setBatchSize().
+        void setBatchSize(index_t size);
+
+        ParallelSolver(const ParallelSolver &) = delete;
+        ParallelSolver & operator=(const ParallelSolver &) = delete;
+
+    private:
+        ///
+        /// Reusable synchronization point for a fixed number of threads.
+        /// If a thread breaks the barrier, all waiting threads are released.
+        ///
+        class Barrier {
+        public:
+            /// Constructor.
+            /// @param count number of threads that meet at barrier
+            Barrier(index_t count): count(count), waiting(0),
+                                     generation(0), broken(false) {}
+            /// Wait until all threads arrive.
+            /// @return false iff barrier was broken
+            bool wait();
+            /// Release all waiting threads, all following waits fail.
+            void do_break();
+        private:
+            /// guards all members
+            std::mutex mutex;
+            /// waiting threads are notified through this variable
+            std::condition_variable cv;
+            /// number of threads that meet at barrier
+            index_t count;
+            /// number of threads currently waiting
+            index_t waiting;
+            /// number of times all threads met at barrier
+            uint64_t generation;
+            /// true iff barrier was broken
+            bool broken;
+        };
+        /// Create replicas, their solvers and lists of trainable blocks.
+        void init(index_t replica_count,
+                  std::vector<block_ptr> output,
+                  std::vector<block_ptr> desired);
+        /// Training loop of a single replica.
+        /// @param index index of replica
+        /// @param cycles number of training cycles
+        /// @param barrier barrier shared by all replicas
+        void run(index_t index, index_t cycles, Barrier & barrier);
+        ///
+        /// Average part of gradient of all replicas and store the mean
+        /// in the original network. Gradients of all trainable blocks
+        /// are viewed as a single vector that is split into replica_count
+        /// parts, so that all threads together reduce whole gradient.
+        /// @param index which part of the gradient is reduced
+        ///
+        void all_reduce(index_t index);
+        /// Copies of the network sharing its weights, original network
+        /// is not included.
+        std::vector<std::unique_ptr<Replica>> replicas;
+        /// Solver of each replica, the first one trains original network.
+        std::vector<std::unique_ptr<Solver>> solvers;
+        ///
+        /// Trainable blocks of each replica, aliases of the original ones
+        /// except for the first replica. Blocks with the same index
+        /// correspond to each other.
+        ///
+        std::vector<std::vector<block_ptr>> trainable;
+        /// Number of trainable values in the network.
+        std::size_t gradient_size;
+        /// Network that is being trained.
+        Net & net;
+    };
+
+} // namespace nl
+
+#endif // NEURAL_LIB_PARALLEL_SOLVER_H
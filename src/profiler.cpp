@@ -0,0 +1,185 @@
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+#include "profiler.hpp"
+
+namespace nl {
+
+    namespace {
+
+        /// Escape string so that it can be used in JSON.
+        std::string json_escape(const std::string & s) {
+            std::string ret;
+            for (char c : s) {
+                if (c == '"' || c == '\\')
+                    ret += '\\';
+                ret += c;
+            }
+            return ret;
+        }
+
+    } // namespace
+
+    std::atomic<bool> Profiler::on(false);
+    bool Profiler::tracing = false;
+    std::mutex Profiler::mutex;
+    std::chrono::steady_clock::time_point Profiler::origin;
+    std::map<std::pair<std::string, std::string>, Profiler::Stats>
+        Profiler::table;
+    std::vector<Profiler::Event> Profiler::events;
+    std::unordered_map<std::thread::id, std::size_t> Profiler::threads;
+    Profiler::Stats Profiler::top_level;
+    thread_local std::size_t Profiler::depth = 0;
+
+    void Profiler::enable(bool trace) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (table.empty() && events.empty())
+            origin = std::chrono::steady_clock::now();
+        tracing = trace;
+        on = true;
+    }
+
+    void Profiler::disable() {
+        on = false;
+    }
+
+    void Profiler::reset() {
+        std::lock_guard<std::mutex> lock(mutex);
+        table.clear();
+        events.clear();
+        threads.clear();
+        top_level = Stats();
+        origin = std::chrono::steady_clock::now();
+    }
+
+    std::map<std::pair<std::string, std::string>, Profiler::Stats>
+    Profiler::stats() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return table;
+    }
+
+    Cost Profiler::cost(Op* op, const char* phase) {
+        if (std::string(phase) == "backward")
+            return op->backward_cost();
+        return op->forward_cost();
+    }
+
+    void Profiler::Scope::begin(const std::string & name, const char* phase,
+                                Cost cost) {
+        active = true;
+        this->name = name;
+        this->phase = phase;
+        this->cost = cost;
+        depth++;
+        start = std::chrono::steady_clock::now();
+    }
+
+    void Profiler::Scope::end() {
+        auto stop = std::chrono::steady_clock::now();
+        depth--;
+
+        double seconds = std::chrono::duration<double>(stop - start).count();
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        Stats & s = table[{name, phase}];
+        s.calls++;
+        s.time += seconds;
+        s.cost += cost;
+
+        if (depth == 0) {
+            top_level.calls++;
+            top_level.time += seconds;
+            top_level.cost += cost;
+        }
+
+        if (!tracing)
+            return;
+
+        auto it = threads.find(std::this_thread::get_id());
+        if (it == threads.end())
+            it = threads.insert({std::this_thread::get_id(),
+                                 threads.size()}).first;
+
+        double since_origin =
+            std::chrono::duration<double, std::micro>(start - origin).count();
+        events.push_back({name, phase, since_origin, seconds * 1e6,
+                          cost, it->second});
+    }
+
+    void Profiler::summary(std::ostream & out) {
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // most expensive first
+        std::vector<std::pair<std::pair<std::string, std::string>, Stats>>
+            rows(table.begin(), table.end());
+        std::sort(rows.begin(), rows.end(), [](const auto & a, const auto & b) {
+                return a.second.time > b.second.time;
+            });
+
+        out << std::left << std::setw(24) << "name"
+            << std::setw(12) << "phase"
+            << std::right << std::setw(10) << "calls"
+            << std::setw(12) << "total ms"
+            << std::setw(12) << "mean us"
+            << std::setw(8) << "%"
+            << std::setw(12) << "MB"
+            << std::setw(10) << "GFLOP/s"
+            << std::setw(10) << "FLOP/B" << std::endl;
+
+        auto print = [&](const std::string & name, const std::string & phase,
+                         const Stats & s) {
+            out << std::left << std::setw(24) << name
+                << std::setw(12) << phase
+                << std::right << std::setw(10) << s.calls
+                << std::fixed << std::setprecision(3)
+                << std::setw(12) << s.time * 1e3
+                << std::setw(12) << (s.calls ? s.time * 1e6 / s.calls : 0)
+                << std::setprecision(1)
+                << std::setw(8)
+                << (top_level.time > 0 ? 100 * s.time / top_level.time : 0)
+                << std::setprecision(3)
+                << std::setw(12) << s.cost.bytes() / 1e6
+                << std::setw(10) << s.flops_per_second() / 1e9
+                << std::setw(10) << s.cost.intensity() << std::endl;
+        };
+
+        for (auto & row : rows) {
+            print(row.first.first, row.first.second, row.second);
+        }
+        print("total", "", top_level);
+
+        out.unsetf(std::ios_base::floatfield);
+    }
+
+    void Profiler::write_trace(const std::string & file_addr) {
+
+        std::ofstream f(file_addr);
+        if (!f)
+            throw InputException();
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // complete events ("X") with start and duration in microseconds
+        f << "{\"traceEvents\":[";
+        for (std::size_t i = 0; i < events.size(); ++i) {
+            const Event & e = events[i];
+            if (i > 0)
+                f << ",";
+            f << "\n{\"name\":\"" << json_escape(e.name) << "\","
+              << "\"cat\":\"" << e.phase << "\","
+              << "\"ph\":\"X\","
+              << "\"ts\":" << std::fixed << std::setprecision(3) << e.start
+              << ",\"dur\":" << e.duration << ","
+              << "\"pid\":0,\"tid\":" << e.thread << ","
+              << "\"args\":{\"phase\":\"" << e.phase << "\","
+              << "\"flops\":" << e.cost.flops << ","
+              << "\"bytes\":" << e.cost.bytes() << "}}";
+        }
+        f << "\n],\"displayTimeUnit\":\"ms\"}" << std::endl;
+    }
+
+} // namespace nl
@@ -0,0 +1,161 @@
+#ifndef NEURAL_LIB_PROFILER_H
+#define NEURAL_LIB_PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "op.hpp"
+
+namespace nl {
+
+    ///
+    /// Collects wall time, number of calls, floating point operations and
+    /// bytes touched by ops of networks and phases of solvers. Measurements are grouped by name
+    /// and phase ("forward", "backward", "zero_grad", ...), summarized
+    /// in a table and optionally kept as individual events that can be
+    /// written in Chrome trace_event format and viewed in chrome://tracing.
+    ///
+    /// Profiling is disabled by default, instrumented code then costs
+    /// a single branch. Defining NEURAL_LIB_NO_PROFILER at compile time
+    /// removes even that. All methods are thread-safe.
+    ///
+    class Profiler {
+    public:
+        ///
+        /// Measures time from its construction to its destruction and
+        /// records it, if profiler was enabled at construction.
+        ///
+        class Scope {
+        public:
+            /// Measure a pass of an op, work is given by the analytic
+            /// cost of the op.
+            /// @param op measured op
+            /// @param phase "forward" or "backward"
+            Scope(Op* op, const char* phase) {
+                if (enabled())
+                    begin(op->name, phase, Profiler::cost(op, phase));
+            }
+            /// Measure an arbitrary part of code.
+            /// @param name name of the measured part
+            /// @param phase phase of the measured part
+            /// @param cost work done by the measured part, if known
+            Scope(const std::string & name, const char* phase,
+                  Cost cost=Cost()) {
+                if (enabled())
+                    begin(name, phase, cost);
+            }
+            /// Destructor, records the measurement.
+            ~Scope() {
+                if (active)
+                    end();
+            }
+
+            Scope(const Scope &) = delete;
+            Scope & operator=(const Scope &) = delete;
+
+        private:
+            void begin(const std::string & name, const char* phase,
+                       Cost cost);
+            void end();
+            /// true iff the measurement is recorded
+            bool active = false;
+            std::string name;
+            const char* phase;
+            Cost cost;
+            std::chrono::steady_clock::time_point start;
+        };
+
+        /// Aggregated measurements of a single name and phase.
+        struct Stats {
+            /// number of measurements
+            std::size_t calls = 0;
+            /// total time in seconds
+            double time = 0;
+            /// total work
+            Cost cost;
+
+            /// Achieved floating point operations per second.
+            double flops_per_second() const {
+                return time > 0 ? cost.flops / time : 0;
+            }
+        };
+
+        ///
+        /// Start profiling.
+        /// @param trace true iff individual events should be kept for
+        /// write_trace(), memory used by them grows with every call
+        ///
+        static void enable(bool trace=true);
+        /// Stop profiling, collected measurements are kept.
+        static void disable();
+        /// true iff profiling is enabled
+        static bool enabled() {
+#ifdef NEURAL_LIB_NO_PROFILER
+            return false;
+#else
+            return on.load(std::memory_order_relaxed);
+#endif
+        }
+        /// Remove all collected measurements.
+        static void reset();
+        /// Aggregated measurements identified by name and phase.
+        static std::map<std::pair<std::string, std::string>, Stats> stats();
+        ///
+        /// Print table of measurements sorted by total time, with the share
+        /// of total time measured at the outermost level, achieved GFLOP/s
+        /// and arithmetic intensity. The last row sums all measurements 
+        /// at the outermost level.
+        /// @param out stream the table is written to
+        ///
+        static void summary(std::ostream & out=std::cout);
+        ///
+        /// Write collected events as Chrome trace_event JSON.
+        /// @param file_addr address of the created file
+        ///
+        static void write_trace(const std::string & file_addr);
+
+    private:
+        /// Single measurement kept for trace.
+        struct Event {
+            std::string name;
+            const char* phase;
+            /// start in microseconds since profiler was enabled
+            double start;
+            /// duration in microseconds
+            double duration;
+            Cost cost;
+            /// index of thread
+            std::size_t thread;
+        };
+        /// Analytic cost of a pass of op.
+        static Cost cost(Op* op, const char* phase);
+        /// true iff profiling is enabled
+        static std::atomic<bool> on;
+        /// true iff events are kept
+        static bool tracing;
+        /// guards all collected data
+        static std::mutex mutex;
+        /// time at which profiler was first enabled after reset
+        static std::chrono::steady_clock::time_point origin;
+        /// aggregated measurements
+        static std::map<std::pair<std::string, std::string>, Stats> table;
+        /// individual measurements
+        static std::vector<Event> events;
+        /// small indices of threads that recorded measurements
+        static std::unordered_map<std::thread::id, std::size_t> threads;
+        /// measurements at the outermost level of each thread
+        static Stats top_level;
+        /// current nesting level of each thread
+        static thread_local std::size_t depth;
+    };
+
+} // namespace nl
+
+#endif // NEURAL_LIB_PROFILER_H
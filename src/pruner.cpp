@@ -0,0 +1,74 @@
+
+#include <algorithm>
+#include <cmath>
+
+#include "pruner.hpp"
+
+namespace nl {
+
+    std::size_t Pruner::prune(float limit) {
+        std::size_t count = 0;
+        for (Dense* dense : layers()) {
+            count += dense->prune(limit);
+        }
+        return count;
+    }
+
+    std::size_t Pruner::keep(std::size_t count) {
+
+        std::vector<Dense*> dense = layers();
+        std::vector<float> magnitudes;
+        for (Dense* d : dense) {
+            block_ptr w = weight_of(d);
+            for (index_t i = 0; i < w->data.size(); ++i) {
+                magnitudes.push_back(std::abs(w->data.data()[i]));
+            }
+        }
+        if (count >= magnitudes.size())
+            return prune(0);
+
+        // magnitude of the last kept weight
+        auto nth = magnitudes.begin() + count;
+        std::nth_element(magnitudes.begin(), nth, magnitudes.end(),
+                         [](float a, float b) { return a > b; });
+        float limit = *std::max_element(nth, magnitudes.end());
+        std::size_t above = std::count_if(magnitudes.begin(), magnitudes.end(),
+                                          [&](float m) { return m > limit; });
+        std::size_t zeroed = prune(limit);
+        if (limit == 0)
+            return zeroed;
+
+        // some of the weights equal to the limit are over the count
+        std::size_t ties = count - above;
+        for (Dense* d : dense) {
+            block_ptr w = weight_of(d);
+            for (index_t i = 0; i < w->data.size(); ++i) {
+                float & v = w->data.data()[i];
+                if (std::abs(v) != limit)
+                    continue;
+                if (ties > 0) {
+                    ties--;
+                } else {
+                    v = 0;
+                    zeroed++;
+                }
+            }
+            w->store();
+        }
+        return zeroed;
+    }
+
+    std::vector<Dense*> Pruner::layers() {
+        std::vector<Dense*> dense;
+        for (auto & op_pair : net.ops) {
+            if (Dense* d = dynamic_cast<Dense*>(op_pair.second))
+                dense.push_back(d);
+        }
+        return dense;
+    }
+
+    block_ptr Pruner::weight_of(Dense* dense) {
+        return dense->inputs()[dense->name + "_w"];
+    }
+
+} // namespace nl
@@ -0,0 +1,51 @@
+#ifndef NEURAL_LIB_PRUNER_H
+#define NEURAL_LIB_PRUNER_H
+
+#include <vector>
+
+#include "block.hpp"
+#include "dense.hpp"
+#include "net.hpp"
+
+namespace nl {
+
+    ///
+    /// Magnitude pruning of weights of all Dense ops of a network. Pruned
+    /// weights are set to zero and stay zero in further training, see
+    /// Dense::prune(). Layers whose density falls below their crossover
+    /// then compute with sparse kernels. Nested networks are not affected.
+    ///
+    class Pruner {
+    public:
+        /// Constructor.
+        /// @param net trained network
+        Pruner(Net & net): net(net) {}
+
+        ///
+        /// Zero weights of magnitude below 'limit'.
+        /// @param limit smallest magnitude of a kept weight
+        /// @return number of weights that were zeroed
+        ///
+        std::size_t prune(float limit);
+
+        ///
+        /// Keep 'count' weights of largest magnitude over all Dense ops
+        /// and zero the others. Which of weights of equal magnitude are
+        /// kept at the boundary is unspecified.
+        /// @param count number of kept weights
+        /// @return number of weights that were zeroed
+        ///
+        std::size_t keep(std::size_t count);
+
+    private:
+        /// Dense ops of the network.
+        std::vector<Dense*> layers();
+        /// Weight block of a Dense op.
+        static block_ptr weight_of(Dense* dense);
+        /// Pruned network.
+        Net & net;
+    };
+
+} // namespace nl
+
+#endif // NEURAL_LIB_PRUNER_H
@@ -0,0 +1,129 @@
+
+#include <algorithm>
+#include <cstring>
+
+#include "quantized_conv.hpp"
+
+namespace nl {
+
+    QuantizedConv::QuantizedConv(const Conv & conv, float range):
+        Op(conv.name), input(conv.input), output(conv.output),
+        window_size(conv.window_size), padding_size(conv.padding_size),
+        stride(conv.stride), groups(conv.groups),
+        transfer_fn(conv.transfer_fn) {
+
+        index_t out_depth = conv.weights.size();
+        index_t rows = conv.weights[0].kernel->data.size();
+
+        // kernels are padded by zeros to whole vectors of Int8::dot
+        index_t padded = (rows + 31) / 32 * 32;
+        kernels.assign(out_depth * padded, 0);
+        scales.resize(out_depth);
+        offsets.resize(out_depth);
+        thresholds.resize(out_depth);
+        for (index_t o = 0; o < out_depth; ++o) {
+            const Conv::WeightPair & p = conv.weights[o];
+            scales[o] = Int8::quantize_weights(p.kernel->data.data(), rows,
+                                               &kernels[padded * o]);
+            std::int32_t sum = 0;
+            for (index_t r = 0; r < rows; ++r) {
+                sum += kernels[padded * o + r];
+            }
+            offsets[o] = Int8::zero_point * sum;
+            thresholds[o] = p.threshold->data(0,0,0);
+        }
+
+        input_scale = range > 0 ? range / Int8::activation_max : 1;
+    }
+
+    void QuantizedConv::forward() {
+
+        auto in_dims = input->dimensions();
+        auto out_dims = output->dimensions();
+        index_t in_group = in_dims[0] / groups;
+        index_t out_group = out_dims[0] / groups;
+        index_t padded = kernels.size() / scales.size();
+
+        quantized.resize(input->data.size());
+        Int8::quantize(input->data.data(), input->data.size(), input_scale,
+                       quantized.data());
+        // bytes past the window meet zeros of padded kernels
+        window.resize(padded);
+
+        float* result = output->data.data();
+        for (index_t h = 0; h < out_dims[2]; ++h) {
+            for (index_t w = 0; w < out_dims[1]; ++w) {
+                for (index_t g = 0; g < groups; ++g) {
+
+                    // lower the window in memory order of kernels, cells
+                    // of padding hold zero
+                    const std::uint8_t* in = quantized.data() + g * in_group;
+                    for (index_t z = 0; z < window_size; ++z) {
+                        index_t i_z = stride * h + z - padding_size;
+                        for (index_t y = 0; y < window_size; ++y) {
+                            index_t i_y = stride * w + y - padding_size;
+                            std::uint8_t* tap = &window[in_group * (y + window_size * z)];
+                            if (i_y < 0 || i_y >= in_dims[1] ||
+                                i_z < 0 || i_z >= in_dims[2])
+                                std::fill(tap, tap + in_group, Int8::zero_point);
+                            else
+                                std::memcpy(tap, in + in_dims[0] * (i_y + in_dims[1] * i_z),
+                                            in_group);
+                        }
+                    }
+
+                    float* cell = result + out_dims[0] * (w + out_dims[1] * h);
+                    for (index_t o = g * out_group; o < (g + 1) * out_group; ++o) {
+                        std::int32_t sum = Int8::dot(window.data(),
+                                                     &kernels[padded * o], padded)
+                            - offsets[o];
+                        cell[o] = transfer_fn->forward(
+                            sum * input_scale * scales[o] + thresholds[o]);
+                    }
+                }
+            }
+        }
+
+    }
+
+    void QuantizedConv::backward() {
+        throw UnsupportedException();
+    }
+
+    block_map QuantizedConv::inputs() {
+        block_map map;
+        map.insert(std::pair<std::string, block_ptr>(input->name, input));
+        return map;
+    }
+
+    block_map QuantizedConv::outputs() {
+        block_map map;
+        map.insert(std::pair<std::string, block_ptr>(output->name, output));
+        return map;
+    }
+
+    void QuantizedConv::share(const block_map & blocks) {
+        replace(input, blocks);
+        replace(output, blocks);
+    }
+
+    Cost QuantizedConv::forward_cost() {
+        double in = input->data.size();
+        double out = output->data.size();
+        double rows = kernels.size() / scales.size();
+
+        // quantization of input, weighted sums of bytes over windows
+        // including padding, rescaling, threshold and transfer function
+        Cost c;
+        c.flops = in + 2 * rows * out + 4 * out;
+        c.bytes_read = in * sizeof(float) + kernels.size() +
+            scales.size() * (2 * sizeof(float) + sizeof(std::int32_t));
+        c.bytes_written = out * sizeof(float);
+        return c;
+    }
+
+    Cost QuantizedConv::backward_cost() {
+        return Cost();
+    }
+
+} // namespace nl
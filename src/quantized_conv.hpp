@@ -0,0 +1,113 @@
+#ifndef NEURAL_LIB_QUANTIZED_CONV_H
+#define NEURAL_LIB_QUANTIZED_CONV_H
+
+#include <cstdint>
+#include <vector>
+
+#include <boost/serialization/base_object.hpp>
+#include <boost/serialization/shared_ptr.hpp>
+#include <boost/serialization/vector.hpp>
+
+#include "block.hpp"
+#include "conv.hpp"
+#include "int8.hpp"
+#include "op.hpp"
+#include "transfer_fns.hpp"
+
+namespace nl {
+
+    ///
+    /// Convolutional layer with kernels quantized to 8 bits, meant for
+    /// inference only. Every output depth slice has its own kernel scale,
+    /// input is quantized with a single scale given by its expected range,
+    /// see Int8. Each window is lowered to a vector of bytes once and
+    /// multiplied with kernels of all output depth slices of its group.
+    ///
+    /// Usually created by Quantizer rather than directly.
+    ///
+    class QuantizedConv : public Op {
+    public:
+        ///
+        /// Constructor. Kernels and thresholds are copied at construction,
+        /// input and output blocks are shared with the original layer.
+        /// @param conv trained layer
+        /// @param range largest magnitude of input, larger values are
+        ///        clamped
+        ///
+        QuantizedConv(const Conv & conv, float range);
+
+        virtual void forward();
+
+        /// Not supported, throws UnsupportedException.
+        virtual void backward();
+
+        /// Input block only, kernels are not blocks any more.
+        virtual block_map inputs();
+
+        virtual block_map outputs();
+
+        virtual void share(const block_map & blocks);
+
+        virtual Cost forward_cost();
+
+        virtual Cost backward_cost();
+
+    private:
+        /// Input block
+        block_ptr input;
+        /// Output block
+        block_ptr output;
+        /// Window size
+        index_t window_size;
+        /// Padding size
+        index_t padding_size;
+        /// Stride
+        index_t stride;
+        /// Number of groups of depth slices.
+        index_t groups;
+        ///
+        /// Quantized kernels one after another, each in memory order
+        /// of its kernel block padded by zeros to a multiple of 32 bytes.
+        ///
+        std::vector<std::int8_t> kernels;
+        /// Kernel scale of every output depth slice.
+        std::vector<float> scales;
+        /// Zero point of input times sum of kernel of every output depth slice.
+        std::vector<std::int32_t> offsets;
+        /// Threshold of every output depth slice.
+        std::vector<float> thresholds;
+        /// Quantization step of input.
+        float input_scale;
+        /// Transfer function
+        TransferFn* transfer_fn;
+        /// Quantized input.
+        std::vector<std::uint8_t> quantized;
+        /// Lowered window of a single group.
+        std::vector<std::uint8_t> window;
+
+        // default constructor, for serialization
+        QuantizedConv(): Op("default_name") {}
+
+        template<class Archive>
+        void serialize(Archive & ar, const unsigned int version)
+        {
+            ar & boost::serialization::base_object<nl::Op>(*this);
+            ar & input;
+            ar & output;
+            ar & window_size;
+            ar & padding_size;
+            ar & stride;
+            ar & groups;
+            ar & kernels;
+            ar & scales;
+            ar & offsets;
+            ar & thresholds;
+            ar & input_scale;
+            ar & transfer_fn;
+        }
+        friend class boost::serialization::access;
+    };
+
+} // namespace nl
+
+#endif // NEURAL_LIB_QUANTIZED_CONV_H
@@ -0,0 +1,90 @@
+
+#include "quantized_dense.hpp"
+
+namespace nl {
+
+    QuantizedDense::QuantizedDense(const Dense & dense, float range):
+        Op(dense.name), input(dense.input), output(dense.output),
+        transfer_fn(dense.transfer_fn) {
+
+        index_t in = input->data.size();
+        index_t out = output->data.size();
+
+        // weights of a single output cell are contiguous
+        weights.resize(in * out);
+        scales.resize(out);
+        offsets.resize(out);
+        for (index_t o = 0; o < out; ++o) {
+            scales[o] = Int8::quantize_weights(dense.weight->data.data() + in * o,
+                                               in, &weights[in * o]);
+            std::int32_t sum = 0;
+            for (index_t i = 0; i < in; ++i) {
+                sum += weights[in * o + i];
+            }
+            offsets[o] = Int8::zero_point * sum;
+        }
+
+        thresholds.assign(dense.threshold->data.data(),
+                          dense.threshold->data.data() + out);
+        input_scale = range > 0 ? range / Int8::activation_max : 1;
+    }
+
+    void QuantizedDense::forward() {
+
+        index_t in = input->data.size();
+        index_t out = output->data.size();
+
+        quantized.resize(in);
+        Int8::quantize(input->data.data(), in, input_scale, quantized.data());
+
+        float* result = output->data.data();
+        for (index_t o = 0; o < out; ++o) {
+            std::int32_t sum = Int8::dot(quantized.data(), &weights[in * o], in)
+                - offsets[o];
+            result[o] = transfer_fn->forward(
+                sum * input_scale * scales[o] + thresholds[o]);
+        }
+
+    }
+
+    void QuantizedDense::backward() {
+        throw UnsupportedException();
+    }
+
+    block_map QuantizedDense::inputs() {
+        block_map map;
+        map.insert(std::pair<std::string, block_ptr>(input->name, input));
+        return map;
+    }
+
+    block_map QuantizedDense::outputs() {
+        block_map map;
+        map.insert(std::pair<std::string, block_ptr>(output->name, output));
+        return map;
+    }
+
+    void QuantizedDense::share(const block_map & blocks) {
+        replace(input, blocks);
+        replace(output, blocks);
+    }
+
+    Cost QuantizedDense::forward_cost() {
+        double in = input->data.size();
+        double out = output->data.size();
+        double w = in * out;
+
+        // quantization of input, weighted sum of bytes, rescaling,
+        // threshold and transfer function
+        Cost c;
+        c.flops = in + 2 * w + 4 * out;
+        c.bytes_read = w + in * sizeof(float) +
+            out * (2 * sizeof(float) + sizeof(std::int32_t));
+        c.bytes_written = out * sizeof(float);
+        return c;
+    }
+
+    Cost QuantizedDense::backward_cost() {
+        return Cost();
+    }
+
+} // namespace nl
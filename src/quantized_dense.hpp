@@ -0,0 +1,94 @@
+#ifndef NEURAL_LIB_QUANTIZED_DENSE_H
+#define NEURAL_LIB_QUANTIZED_DENSE_H
+
+#include <cstdint>
+#include <vector>
+
+#include <boost/serialization/base_object.hpp>
+#include <boost/serialization/shared_ptr.hpp>
+#include <boost/serialization/vector.hpp>
+
+#include "block.hpp"
+#include "dense.hpp"
+#include "int8.hpp"
+#include "op.hpp"
+#include "transfer_fns.hpp"
+
+namespace nl {
+
+    ///
+    /// Dense layer with weights quantized to 8 bits, meant for inference
+    /// only. Every output cell has its own weight scale, input is quantized
+    /// with a single scale given by its expected range, see Int8.
+    ///
+    /// Usually created by Quantizer rather than directly.
+    ///
+    class QuantizedDense : public Op {
+    public:
+        ///
+        /// Constructor. Weights and thresholds are copied at construction,
+        /// input and output blocks are shared with the original layer.
+        /// @param dense trained layer
+        /// @param range largest magnitude of input, larger values are
+        ///        clamped
+        ///
+        QuantizedDense(const Dense & dense, float range);
+
+        virtual void forward();
+
+        /// Not supported, throws UnsupportedException.
+        virtual void backward();
+
+        /// Input block only, weights are not blocks any more.
+        virtual block_map inputs();
+
+        virtual block_map outputs();
+
+        virtual void share(const block_map & blocks);
+
+        virtual Cost forward_cost();
+
+        virtual Cost backward_cost();
+
+    private:
+        /// Input block
+        block_ptr input;
+        /// Output block
+        block_ptr output;
+        /// Quantized weights, a row of input size for every output cell.
+        std::vector<std::int8_t> weights;
+        /// Weight scale of every output cell.
+        std::vector<float> scales;
+        /// Zero point of input times sum of weights of every output cell.
+        std::vector<std::int32_t> offsets;
+        /// Threshold of every output cell.
+        std::vector<float> thresholds;
+        /// Quantization step of input.
+        float input_scale;
+        /// Transfer function
+        TransferFn* transfer_fn;
+        /// Quantized input.
+        std::vector<std::uint8_t> quantized;
+
+        // default constructor, for serialization
+        QuantizedDense(): Op("default_name") {}
+
+        template<class Archive>
+        void serialize(Archive & ar, const unsigned int version)
+        {
+            ar & boost::serialization::base_object<nl::Op>(*this);
+            ar & input;
+            ar & output;
+            ar & weights;
+            ar & scales;
+            ar & offsets;
+            ar & thresholds;
+            ar & input_scale;
+            ar & transfer_fn;
+        }
+        friend class boost::serialization::access;
+    };
+
+} // namespace nl
+
+#endif // NEURAL_LIB_QUANTIZED_DENSE_H
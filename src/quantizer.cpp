@@ -0,0 +1,68 @@
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "conv.hpp"
+#include "dense.hpp"
+#include "quantized_conv.hpp"
+#include "quantized_dense.hpp"
+#include "quantizer.hpp"
+
+namespace nl {
+
+    void Quantizer::calibrate(std::size_t passes) {
+        for (std::size_t pass = 0; pass < passes; ++pass) {
+            net.forward();
+            for (auto & op_pair : net.ops) {
+                Op* op = op_pair.second;
+                if (dynamic_cast<Dense*>(op) == nullptr &&
+                    dynamic_cast<Conv*>(op) == nullptr)
+                    continue;
+
+                Eigen::Tensor<float, 0> max = input_of(op)->data.abs().maximum();
+                float & r = ranges[op->name];
+                r = std::max(r, max());
+            }
+        }
+    }
+
+    float Quantizer::range(const std::string & op_name) {
+        auto it = ranges.find(op_name);
+        return it == ranges.end() ? 0 : it->second;
+    }
+
+    std::size_t Quantizer::quantize() {
+
+        std::vector<Op*> removed;
+        std::vector<std::unique_ptr<Op>> added;
+        for (auto & op_pair : net.ops) {
+            auto it = ranges.find(op_pair.first);
+            if (it == ranges.end())
+                continue;
+
+            Op* op = op_pair.second;
+            if (Dense* dense = dynamic_cast<Dense*>(op))
+                added.emplace_back(new QuantizedDense(*dense, it->second));
+            else if (Conv* conv = dynamic_cast<Conv*>(op))
+                added.emplace_back(new QuantizedConv(*conv, it->second));
+            else
+                continue;
+            removed.push_back(op);
+        }
+
+        std::size_t count = added.size();
+        if (count > 0)
+            net.replace_ops(removed, std::move(added));
+        return count;
+    }
+
+    block_ptr Quantizer::input_of(Op* op) {
+        for (auto & block_pair : op->inputs()) {
+            if (!block_pair.second->trainable)
+                return block_pair.second;
+        }
+        throw InputException();
+    }
+
+} // namespace nl
@@ -0,0 +1,60 @@
+#ifndef NEURAL_LIB_QUANTIZER_H
+#define NEURAL_LIB_QUANTIZER_H
+
+#include <string>
+#include <unordered_map>
+
+#include "block.hpp"
+#include "net.hpp"
+#include "op.hpp"
+
+namespace nl {
+
+    ///
+    /// Post-training quantization of a network. Range of input of every
+    /// Dense and Conv op is first recorded over a few forward passes,
+    /// the ops are then replaced by QuantizedDense and QuantizedConv.
+    ///
+    /// Readers of the network load a new sample in every forward pass,
+    /// so calibration sees the same data as the network. Nested networks
+    /// are not affected.
+    ///
+    class Quantizer {
+    public:
+        /// Constructor.
+        /// @param net trained network, its ops are replaced by quantize()
+        Quantizer(Net & net): net(net) {}
+
+        ///
+        /// Run forward pass of the network and record the largest
+        /// magnitude of input of every Dense and Conv op.
+        /// @param passes number of forward passes
+        ///
+        void calibrate(std::size_t passes=1);
+
+        ///
+        /// Largest magnitude of input of an op seen by calibrate().
+        /// @param op_name name of the op
+        /// @return range, zero if the op was not calibrated
+        ///
+        float range(const std::string & op_name);
+
+        ///
+        /// Replace every calibrated Dense and Conv op of the network by
+        /// its quantized counterpart, which is owned by the network.
+        /// @return number of replaced ops
+        ///
+        std::size_t quantize();
+
+    private:
+        /// Input block of an op, its only input that is not trainable.
+        static block_ptr input_of(Op* op);
+        /// Quantized network.
+        Net & net;
+        /// Largest magnitude of input of every calibrated op.
+        std::unordered_map<std::string, float> ranges;
+    };
+
+} // namespace nl
+
+#endif // NEURAL_LIB_QUANTIZER_H
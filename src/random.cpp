@@ -10,9 +10,9 @@ namespace nl {
 
         auto dims = block->dimensions();
         
-        for (uint16_t i = 0; i < dims[0]; i++) {
-            for (uint16_t j = 0; j < dims[1]; j++) {
-                for (uint16_t k = 0; k < dims[2]; k++) {
+        for (index_t i = 0; i < dims[0]; i++) {
+            for (index_t j = 0; j < dims[1]; j++) {
+                for (index_t k = 0; k < dims[2]; k++) {
                     block->data(i,j,k) = Generator::get();
                 }
             }
@@ -14,7 +14,7 @@ namespace nl {
           and that they are valid floats
         */
         bool first_read = false;
-        uint16_t record_count = 0;
+        index_t record_count = 0;
         std::string line;
         while (std::getline(file, line)) {
             std::stringstream line_stream(line);
@@ -56,23 +56,13 @@ namespace nl {
     }
 
     void CsvReader::forward() {            
-        std::string line;
-
-        if (!std::getline(line_stream, line)) {
-            // issue with reading from file, not end of file
-            if (!line_stream.eof()) {
-                throw InputException();
-            }
-            // otherwise start reading again from the beginning
-            line_stream = std::ifstream(file_addr, std::ifstream::in);
-            std::getline(line_stream, line);
-        }
+        std::string line = next_line();
 
         std::stringstream line_stream(line);
         std::string record;
 
         // load sequence of records on a single line to output blocks
-        uint16_t i = 0;
+        index_t i = 0;
         while(std::getline(line_stream, record, 
                            CsvReader::delimiter)) {                
             output->data(0,0,i) = std::stof(record);
@@ -81,6 +71,48 @@ namespace nl {
 
     }
     
+    std::string CsvReader::next_line() {
+        std::string line;
+        bool restarted = false;
+
+        // skip lines that belong to other shards
+        do {
+            if (!std::getline(line_stream, line)) {
+                // issue with reading from file, not end of file
+                if (!line_stream.eof()) {
+                    throw InputException();
+                }
+                // whole file was read without finding line of this shard
+                if (restarted)
+                    throw InputException();
+                // otherwise start reading again from the beginning
+                restarted = true;
+                line_stream = std::ifstream(file_addr, std::ifstream::in);
+                line_no = 0;
+                std::getline(line_stream, line);
+            }
+        } while (line_no++ % shard_count != shard_index);
+
+        return line;
+    }
+
+    void CsvReader::shard(index_t index, index_t count) {
+
+        if (count < 1 || index < 0 || index >= count)
+            throw InputException();
+
+        shard_index = index;
+        shard_count = count;
+
+        // start reading from the beginning
+        line_stream = std::ifstream(file_addr, std::ifstream::in);
+        line_no = 0;
+    }
+    
+    void CsvReader::share(const block_map & blocks) {
+        replace(output, blocks);
+    }
+
     block_map CsvReader::inputs() {
         return block_map();
     }
@@ -102,7 +134,7 @@ namespace nl {
         // each line contains a valid filename of an image
         // all images must be of the same size
         bool first = false;
-        uint16_t channel_no = 0, width = 0, height = 0;
+        index_t channel_no = 0, width = 0, height = 0;
         std::string img_address;
         while (std::getline(file, img_address)) {
             cimg_library::CImg<float> img(img_address.c_str());                
@@ -132,15 +164,16 @@ namespace nl {
 
         // set beginning position in text file
         line_stream = std::ifstream(file_addr, std::ifstream::in);
+        line_no = 0;
     }
 
     void ImgReader::forward() {            
         cimg_library::CImg<float> img(next_image_addr().c_str());                
 
         // load data in tensor
-        for (uint16_t s = 0; s < img.spectrum(); ++s) {
-            for (uint16_t w = 0; w < img.width(); ++w) {
-                for (uint16_t h = 0; h < img.height(); ++h) {
+        for (index_t s = 0; s < img.spectrum(); ++s) {
+            for (index_t w = 0; w < img.width(); ++w) {
+                for (index_t h = 0; h < img.height(); ++h) {
                     output_block->data(s, w, h) = img(w, h, s);
                 }
             }
@@ -149,19 +182,41 @@ namespace nl {
 
     std::string ImgReader::next_image_addr() {
         std::string line;
+        bool restarted = false;
 
-        if (!std::getline(line_stream, line)) {
-            // issue with reading from file, not end of line
-            if (!line_stream.eof()) {
-                throw InputException();
+        // skip images that belong to other shards
+        do {
+            if (!std::getline(line_stream, line)) {
+                // issue with reading from file, not end of line
+                if (!line_stream.eof()) {
+                    throw InputException();
+                }
+                // whole file was read without finding line of this shard
+                if (restarted)
+                    throw InputException();
+                // otherwise start reading again from the beginning
+                restarted = true;
+                line_stream = std::ifstream(file_addr, std::ifstream::in);
+                line_no = 0;
+                std::getline(line_stream, line);
             }
-            // otherwise start reading again from the beginning
-            line_stream = std::ifstream(file_addr, std::ifstream::in);
-            std::getline(line_stream, line);
-        }
+        } while (line_no++ % shard_count != shard_index);
             
         return line;
     }
 
+    void ImgReader::shard(index_t index, index_t count) {
+
+        if (count < 1 || index < 0 || index >= count)
+            throw InputException();
+
+        shard_index = index;
+        shard_count = count;
+
+        // start reading from the beginning
+        line_stream = std::ifstream(file_addr, std::ifstream::in);
+        line_no = 0;
+    }
+
 
 } // namespace nl
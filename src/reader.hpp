@@ -41,7 +41,19 @@ namespace nl {
 
         virtual block_map outputs();
 
+        /// Read only lines whose position in file modulo 'count' equals
+        /// 'index'. Reading starts again from the beginning of the file.
+        virtual void shard(index_t index, index_t count);
+
+        virtual void share(const block_map & blocks);
+
     private:
+        ///
+        /// Return next line of the current shard, if end of file 
+        /// was reached start again from the beginning
+        ///
+        std::string next_line();
+
         ///
         /// Delimiter for records on a single line. 
         /// Lines are always delimited by '\n'.
@@ -57,6 +69,15 @@ namespace nl {
         /// csv file address.
         std::string file_addr;
 
+        /// Position of the next line in file.
+        index_t line_no = 0;
+
+        /// Index of shard that is being read.
+        index_t shard_index = 0;
+
+        /// Number of shards the file is split into.
+        index_t shard_count = 1;
+
         // default constructor, for serialization
         CsvReader(): Op("default_name") {}
 
@@ -113,6 +134,14 @@ namespace nl {
             return m;
         }
 
+        /// Read only images whose line in text file modulo 'count' equals
+        /// 'index'. Reading starts again from the beginning of the file.
+        virtual void shard(index_t index, index_t count);
+
+        virtual void share(const block_map & blocks) {
+            replace(output_block, blocks);
+        }
+
     private:
         ///
         /// return next image address in list, 
@@ -129,6 +158,15 @@ namespace nl {
         /// address of text file with image addresses
         std::string file_addr;
 
+        /// position of the next line in text file
+        index_t line_no = 0;
+
+        /// index of shard that is being read
+        index_t shard_index = 0;
+
+        /// number of shards the text file is split into
+        index_t shard_count = 1;
+
         // default constructor, for serialization
         ImgReader(): Op("default_name") {}
 
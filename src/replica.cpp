@@ -0,0 +1,60 @@
+
+#include <sstream>
+
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/archive/binary_iarchive.hpp>
+
+#include "replica.hpp"
+
+namespace nl {
+
+    Replica::Replica(Net & original, bool share_trainable): copy(nullptr) {
+
+        std::stringstream ss;
+
+        // save original network
+        {
+            boost::archive::binary_oarchive oa(ss);
+            const Net* net = &original;
+            oa << net;
+        }
+
+        // load it as a new network
+        {
+            boost::archive::binary_iarchive ia(ss);
+            ia >> copy;
+        }
+
+        if (!share_trainable)
+            return;
+
+        // use trainable blocks of the original network, copied
+        // trainable blocks are released
+        block_map trainable;
+        for (auto & block_pair : original.blocks) {
+            if (block_pair.second->trainable)
+                trainable.insert(block_pair);
+        }
+        copy->share(trainable);
+    }
+
+    Replica::~Replica() {
+        destroy(copy);
+    }
+
+    void Replica::destroy(Net* net) {
+
+        for (auto & op_pair : net->ops) {
+            Op* op = op_pair.second;
+            // nested networks do not own their ops either
+            Net* nested = dynamic_cast<Net*>(op);
+            if (nested != nullptr)
+                destroy(nested);
+            else
+                delete op;
+        }
+
+        delete net;
+    }
+
+} // namespace nl
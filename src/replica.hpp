@@ -0,0 +1,45 @@
+#ifndef NEURAL_LIB_REPLICA_H
+#define NEURAL_LIB_REPLICA_H
+
+#include "net.hpp"
+
+namespace nl {
+
+    ///
+    /// Independent copy of a network. Network is copied through 
+    /// serialization, so the copy has its own ops and blocks with the same
+    /// names, content and structure as the original. All ops of the copy
+    /// are owned by the replica and deleted together with it.
+    /// Optionally, trainable blocks are not copied and the replica uses
+    /// trainable blocks of the original network instead.
+    ///
+    class Replica {
+    public:
+        /// Constructor.
+        /// @param original network that is copied
+        /// @param share_trainable true iff trainable blocks should be 
+        /// shared with original network instead of being copied
+        Replica(Net & original, bool share_trainable=false);
+
+        /// Destructor. Deletes copied network and all of its ops.
+        ~Replica();
+
+        /// Copied network.
+        Net & net() {
+            return *copy;
+        }
+
+        Replica(const Replica &) = delete;
+        Replica & operator=(const Replica &) = delete;
+
+    private:
+        /// Delete network together with all ops inside, including
+        /// ops of nested networks.
+        static void destroy(Net* net);
+        /// Copied network.
+        Net* copy;
+    };
+
+} // namespace nl
+
+#endif // NEURAL_LIB_REPLICA_H
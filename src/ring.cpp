@@ -0,0 +1,288 @@
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "ring.hpp"
+
+namespace nl {
+
+    namespace {
+
+        /// How long to wait for the next rank to start listening.
+        const auto connect_timeout = std::chrono::seconds(60);
+
+        /// Fill address of Unix socket, path has limited length.
+        sockaddr_un unix_address(const std::string & path) {
+            sockaddr_un addr;
+            std::memset(&addr, 0, sizeof(addr));
+            addr.sun_family = AF_UNIX;
+            if (path.size() >= sizeof(addr.sun_path))
+                throw InputException();
+            std::strcpy(addr.sun_path, path.c_str());
+            return addr;
+        }
+
+        /// Repeat connection attempts until the peer listens.
+        template<typename F>
+        int retry_connect(F attempt) {
+            auto start = std::chrono::steady_clock::now();
+            while (true) {
+                int fd = attempt();
+                if (fd >= 0)
+                    return fd;
+                if (std::chrono::steady_clock::now() - start > connect_timeout)
+                    throw CommunicationException();
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+
+    } // namespace
+
+    Ring::Ring(uint16_t rank, uint16_t size, std::string path):
+        rank(rank), size(size) {
+
+        if (rank >= size)
+            throw InputException();
+
+        if (size == 1)
+            return;
+
+        socket_file = path + "." + std::to_string(rank);
+        std::string next_file = path + "." + std::to_string((rank + 1) % size);
+
+        // socket left by a previous run would prevent binding
+        sockaddr_un addr = unix_address(socket_file);
+        sockaddr_un next_addr = unix_address(next_file);
+        unlink(socket_file.c_str());
+
+        int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listener < 0 ||
+            bind(listener, (sockaddr*) &addr, sizeof(addr)) < 0 ||
+            listen(listener, 1) < 0) {
+            if (listener >= 0)
+                close(listener);
+            throw CommunicationException();
+        }
+
+        connect_ring(listener, [&]() {
+            int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd >= 0 &&
+                connect(fd, (sockaddr*) &next_addr, sizeof(next_addr)) < 0) {
+                close(fd);
+                fd = -1;
+            }
+            return fd;
+        });
+    }
+
+    Ring::Ring(uint16_t rank, std::vector<std::string> hosts, uint16_t port):
+        rank(rank), size(hosts.size()) {
+
+        if (rank >= size)
+            throw InputException();
+
+        if (size == 1)
+            return;
+
+        uint16_t next = (rank + 1) % size;
+
+        // listen on all interfaces
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(port + rank);
+
+        int listener = socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        if (listener < 0 ||
+            setsockopt(listener, SOL_SOCKET, SO_REUSEADDR,
+                       &reuse, sizeof(reuse)) < 0 ||
+            bind(listener, (sockaddr*) &addr, sizeof(addr)) < 0 ||
+            listen(listener, 1) < 0) {
+            if (listener >= 0)
+                close(listener);
+            throw CommunicationException();
+        }
+
+        // resolve address of the next rank
+        addrinfo hints;
+        std::memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* next_addr;
+        std::string service = std::to_string(port + next);
+        if (getaddrinfo(hosts[next].c_str(), service.c_str(),
+                        &hints, &next_addr) != 0) {
+            close(listener);
+            throw CommunicationException();
+        }
+
+        try {
+            connect_ring(listener, [&]() {
+                int fd = socket(AF_INET, SOCK_STREAM, 0);
+                if (fd >= 0 &&
+                    connect(fd, next_addr->ai_addr, next_addr->ai_addrlen) < 0) {
+                    close(fd);
+                    fd = -1;
+                }
+                return fd;
+            });
+        } catch (...) {
+            freeaddrinfo(next_addr);
+            throw;
+        }
+        freeaddrinfo(next_addr);
+
+        // chunks are sent as soon as they are ready
+        int flag = 1;
+        setsockopt(next_fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+    }
+
+    Ring::~Ring() {
+        if (next_fd >= 0)
+            close(next_fd);
+        if (prev_fd >= 0)
+            close(prev_fd);
+        if (!socket_file.empty())
+            unlink(socket_file.c_str());
+    }
+
+    template<typename F>
+    void Ring::connect_ring(int listener, F connect) {
+
+        // connection to the next rank is queued by its listener, so all
+        // ranks can connect first and accept afterwards
+        try {
+            next_fd = retry_connect(connect);
+        } catch (...) {
+            close(listener);
+            throw;
+        }
+        prev_fd = accept(listener, nullptr, nullptr);
+        close(listener);
+        if (prev_fd < 0)
+            throw CommunicationException();
+
+        // both directions are served by a single poll loop
+        fcntl(next_fd, F_SETFL, fcntl(next_fd, F_GETFL) | O_NONBLOCK);
+        fcntl(prev_fd, F_SETFL, fcntl(prev_fd, F_GETFL) | O_NONBLOCK);
+    }
+
+    void Ring::all_reduce(float* data, std::size_t count) {
+
+        if (size == 1)
+            return;
+
+        // boundaries of i-th chunk
+        auto begin = [&](std::size_t i) { return count * i / size; };
+        auto end = [&](std::size_t i) { return count * (i + 1) / size; };
+
+        buffer.resize(count / size + 1);
+
+        // reduce-scatter, after size - 1 steps rank r holds
+        // complete sum of chunk (r + 1) % size
+        for (uint16_t step = 0; step + 1 < size; ++step) {
+            std::size_t s = (rank + size - step) % size;
+            std::size_t r = (rank + size - step - 1) % size;
+            exchange((const char*) (data + begin(s)),
+                     (end(s) - begin(s)) * sizeof(float),
+                     (char*) buffer.data(),
+                     (end(r) - begin(r)) * sizeof(float));
+            for (std::size_t i = begin(r); i < end(r); ++i) {
+                data[i] += buffer[i - begin(r)];
+            }
+        }
+
+        // all-gather, complete chunks travel around the ring
+        for (uint16_t step = 0; step + 1 < size; ++step) {
+            std::size_t s = (rank + 1 + size - step) % size;
+            std::size_t r = (rank + size - step) % size;
+            exchange((const char*) (data + begin(s)),
+                     (end(s) - begin(s)) * sizeof(float),
+                     (char*) (data + begin(r)),
+                     (end(r) - begin(r)) * sizeof(float));
+        }
+    }
+
+    void Ring::broadcast(float* data, std::size_t count) {
+
+        if (size == 1)
+            return;
+
+        std::size_t bytes = count * sizeof(float);
+
+        // data travels from rank 0 to the last rank
+        if (rank != 0)
+            exchange(nullptr, 0, (char*) data, bytes);
+        if (rank != size - 1)
+            exchange((const char*) data, bytes, nullptr, 0);
+    }
+
+    void Ring::shift(const void* out, void* in, std::size_t bytes) {
+        if (size == 1)
+            std::memcpy(in, out, bytes);
+        else
+            exchange((const char*) out, bytes, (char*) in, bytes);
+    }
+
+    void Ring::exchange(const char* out, std::size_t out_bytes,
+                        char* in, std::size_t in_bytes) {
+
+        std::size_t sent = 0;
+        std::size_t received = 0;
+
+        while (sent < out_bytes || received < in_bytes) {
+
+            pollfd fds[2];
+            nfds_t n = 0;
+            if (sent < out_bytes)
+                fds[n++] = {next_fd, POLLOUT, 0};
+            if (received < in_bytes)
+                fds[n++] = {prev_fd, POLLIN, 0};
+
+            if (poll(fds, n, -1) < 0) {
+                if (errno == EINTR)
+                    continue;
+                throw CommunicationException();
+            }
+
+            for (nfds_t i = 0; i < n; ++i) {
+
+                if (fds[i].revents == 0)
+                    continue;
+
+                if (fds[i].fd == next_fd) {
+                    ssize_t k = send(next_fd, out + sent, out_bytes - sent,
+                                     MSG_NOSIGNAL);
+                    if (k < 0 && errno != EAGAIN && errno != EINTR)
+                        throw CommunicationException();
+                    if (k > 0)
+                        sent += k;
+                } else {
+                    ssize_t k = recv(prev_fd, in + received,
+                                     in_bytes - received, 0);
+                    // connection closed by previous rank
+                    if (k == 0)
+                        throw CommunicationException();
+                    if (k < 0 && errno != EAGAIN && errno != EINTR)
+                        throw CommunicationException();
+                    if (k > 0)
+                        received += k;
+                }
+            }
+        }
+    }
+
+} // namespace nl
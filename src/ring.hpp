@@ -0,0 +1,99 @@
+#ifndef NEURAL_LIB_RING_H
+#define NEURAL_LIB_RING_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "exceptions.hpp"
+
+namespace nl {
+
+    ///
+    /// Group of processes connected into a ring by sockets. Each process
+    /// (rank) sends data to the next rank and receives data from the
+    /// previous one, which is enough for bandwidth-optimal all-reduce.
+    /// Processes are connected either by Unix domain sockets, when all
+    /// of them run on the same machine, or by TCP.
+    ///
+    /// Constructor blocks until both neighbours are connected, so all
+    /// processes of the group have to create their Ring at about the same
+    /// time. All collective operations have to be called by all ranks
+    /// in the same order and with buffers of the same size.
+    ///
+    class Ring {
+    public:
+        ///
+        /// Connect processes on a single machine by Unix domain sockets.
+        /// Rank i listens on socket 'path' followed by "." and i.
+        /// @param rank index of this process, lower than size
+        /// @param size number of processes in the group
+        /// @param path prefix of socket file names
+        ///
+        Ring(uint16_t rank, uint16_t size, std::string path);
+        ///
+        /// Connect processes by TCP. Rank i listens on port 'port' + i
+        /// of all interfaces and connects to the next rank on its host.
+        /// @param rank index of this process, lower than hosts.size()
+        /// @param hosts host name or address of each rank
+        /// @param port port of the first rank
+        ///
+        Ring(uint16_t rank, std::vector<std::string> hosts, uint16_t port);
+        /// Destructor, closes connections.
+        ~Ring();
+        ///
+        /// Sum buffers of all ranks element-wise, result is stored in the
+        /// buffer of every rank. Buffer is split into 'size' chunks that
+        /// travel around the ring, first being reduced (reduce-scatter) and
+        /// then distributed (all-gather), so each rank sends and receives
+        /// about 2 * count floats independently of the number of ranks.
+        /// @param data buffer with values of this rank
+        /// @param count number of floats in buffer
+        ///
+        void all_reduce(float* data, std::size_t count);
+        ///
+        /// Copy buffer of rank 0 to all other ranks.
+        /// @param data buffer that is sent by rank 0 and overwritten
+        /// on other ranks
+        /// @param count number of floats in buffer
+        ///
+        void broadcast(float* data, std::size_t count);
+        ///
+        /// Send data to the next rank and receive the same amount of data
+        /// from the previous one. Both directions progress simultaneously,
+        /// so arbitrarily large messages do not deadlock.
+        /// @param out data sent to the next rank
+        /// @param in buffer for data from the previous rank
+        /// @param bytes size of both buffers
+        ///
+        void shift(const void* out, void* in, std::size_t bytes);
+
+        /// Index of this process in the group.
+        const uint16_t rank;
+        /// Number of processes in the group.
+        const uint16_t size;
+
+        Ring(const Ring &) = delete;
+        Ring & operator=(const Ring &) = delete;
+
+    private:
+        /// Finish connection once this rank listens on 'listener'.
+        /// @param connect function connecting to the next rank
+        template<typename F>
+        void connect_ring(int listener, F connect);
+        /// Send and receive simultaneously, sizes may differ.
+        void exchange(const char* out, std::size_t out_bytes,
+                      char* in, std::size_t in_bytes);
+        /// Socket connected to the next rank, used for sending.
+        int next_fd = -1;
+        /// Socket connected to the previous rank, used for receiving.
+        int prev_fd = -1;
+        /// Unix socket file created by this rank, empty for TCP.
+        std::string socket_file;
+        /// Received chunk that is added to local buffer.
+        std::vector<float> buffer;
+    };
+
+} // namespace nl
+
+#endif // NEURAL_LIB_RING_H
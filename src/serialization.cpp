@@ -0,0 +1,10 @@
+
+// Classes are exported only for archives included before serialization.hpp,
+// this is the only unit of the library that exports them: binary archives
+// copy networks into replicas and text archives load saved models.
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/archive/text_oarchive.hpp>
+
+#include "serialization.hpp"
@@ -7,13 +7,27 @@
 #include <boost/serialization/export.hpp>
 
 #include "block.hpp"
+#include "conv.hpp"
+#include "conv_pool.hpp"
+#include "dense.hpp"
+#include "maxpool.hpp"
+#include "net.hpp"
 #include "neuron.hpp"
+#include "quantized_conv.hpp"
+#include "quantized_dense.hpp"
+#include "reader.hpp"
+#include "softmax.hpp"
+#include "transfer_fns.hpp"
 
 BOOST_CLASS_EXPORT_GUID(nl::Op, "Op") 
 BOOST_CLASS_EXPORT_GUID(nl::Neuron, "Neuron") 
 BOOST_CLASS_EXPORT_GUID(nl::Dense, "Dense")
 BOOST_CLASS_EXPORT_GUID(nl::Conv, "Conv")
 BOOST_CLASS_EXPORT_GUID(nl::MaxPool, "MaxPool")
+BOOST_CLASS_EXPORT_GUID(nl::ConvPool, "ConvPool")
+BOOST_CLASS_EXPORT_GUID(nl::QuantizedDense, "QuantizedDense")
+BOOST_CLASS_EXPORT_GUID(nl::QuantizedConv, "QuantizedConv")
+BOOST_CLASS_EXPORT_GUID(nl::Softmax, "Softmax")
 BOOST_CLASS_EXPORT_GUID(nl::CsvReader, "CsvReader")
 BOOST_CLASS_EXPORT_GUID(nl::ImgReader, "ImgReader")
 BOOST_CLASS_EXPORT_GUID(nl::TransferFn, "TransferFn")
@@ -47,13 +47,13 @@ namespace nl {
         Eigen::Tensor<float, 3> t(dim[0], dim[1], dim[2]);
         t.setZero();
         // get first element in tensor, or rather its position
-        for (uint16_t i_1 = 0; i_1 < dim[0]; i_1++) {
-            for (uint16_t j_1 = 0; j_1 < dim[1]; j_1++) {
-                for (uint16_t k_1 = 0; k_1 < dim[2]; k_1++) {
+        for (index_t i_1 = 0; i_1 < dim[0]; i_1++) {
+            for (index_t j_1 = 0; j_1 < dim[1]; j_1++) {
+                for (index_t k_1 = 0; k_1 < dim[2]; k_1++) {
                     // get second element in tensor, or rather its position
-                    for (uint16_t i_2 = 0; i_2 < dim[0]; i_2++) {
-                        for (uint16_t j_2 = 0; j_2 < dim[1]; j_2++) {
-                            for (uint16_t k_2 = 0; k_2 < dim[2]; k_2++) {
+                    for (index_t i_2 = 0; i_2 < dim[0]; i_2++) {
+                        for (index_t j_2 = 0; j_2 < dim[1]; j_2++) {
+                            for (index_t k_2 = 0; k_2 < dim[2]; k_2++) {
 
                                 t(i_1, j_1, k_1) -=                                     
                                     output->data(i_1, j_1, k_1) 
@@ -92,5 +92,31 @@ namespace nl {
         return map;
     }
 
+    void Softmax::share(const block_map & blocks) {
+        replace(input, blocks);
+        replace(output, blocks);
+    }
+
+    Cost Softmax::forward_cost() {
+        double n = input->data.size();
+
+        // exponential, sum and division
+        Cost c;
+        c.flops = 3 * n;
+        c.bytes_read = n * sizeof(float);
+        c.bytes_written = n * sizeof(float);
+        return c;
+    }
+
+    Cost Softmax::backward_cost() {
+        double n = input->data.size();
+
+        // full Jacobian of softmax times output gradient
+        Cost c;
+        c.flops = 3 * n * n + 3 * n;
+        c.bytes_read = 2 * n * sizeof(float);
+        c.bytes_written = n * sizeof(float);
+        return c;
+    }
 
 } // namespace nl
@@ -5,6 +5,7 @@
 #include <unordered_map>
 #include <iostream>
 
+#include <boost/serialization/base_object.hpp>
 #include <boost/serialization/shared_ptr.hpp>
 
 #include "random.hpp"
@@ -41,6 +42,12 @@ namespace nl {
 
         virtual block_map inputs();
 
+        virtual void share(const block_map & blocks);
+
+        virtual Cost forward_cost();
+
+        virtual Cost backward_cost();
+
     private:
         ///
         /// Auxiliary method called by constructor,
@@ -51,6 +58,18 @@ namespace nl {
         block_ptr input;
         /// Output block
         block_ptr output;
+
+        // Default constructor, for serialization
+        Softmax(): Op("default_name") {}
+
+        template<class Archive>
+        void serialize(Archive & ar, const unsigned int version)
+        {
+            ar & boost::serialization::base_object<nl::Op>(*this);
+            ar & input;
+            ar & output;
+        }
+        friend class boost::serialization::access;
     };
 
 } // namespace nl
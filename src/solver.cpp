@@ -1,6 +1,10 @@
 
 
 
+#include <exception>
+#include <thread>
+
+#include "profiler.hpp"
 #include "solver.hpp"
 
 namespace nl {
@@ -13,110 +17,286 @@ namespace nl {
         desired.push_back(desired_block);            
     }
 
-    float Solver::train(uint16_t cycles) {
-        
-        if (nesterov)
-            return train_nesterov(cycles);
-        else 
-            return train_sgd(cycles);
+    Solver::~Solver() {
+        // original network reads all of its data again
+        if (!workers.empty() || exchange)
+            net.shard(0, 1);
+    }
+
+    float Solver::train(index_t cycles) {
+
+        init_master();
+
+        if (!workers.empty())
+            return train_hogwild(cycles);
+
+        for (index_t i = 0; i < cycles; ++i) {
+            begin_cycle();
+            // forward and backward passes for the whole batch
+            accumulate_gradient();
+            end_cycle();
+        }
+
+        return Error::L2(output, desired);
+    }
+
+    void Solver::decay_lr() {
+        // possibly update learning rate
+        if (steps_without_change >= cycle_length)
+            lr *= decay_factor;
+        steps_without_change++;
+    }
+
+    void Solver::begin_cycle() {
+
+        decay_lr();
 
+        if (!nesterov)
+            return;
+
+        Profiler::Scope scope(net.name, "update");
+
+        // update weights using momentum term
+        for (auto & block_pair : net.blocks) {
+            block_ptr b = block_pair.second;
+            if (b->trainable) {
+                weights(*b) -= (lr/3) * momentum[b->name];
+                updated(*b);
+            }
+        }            
     }
 
-    float Solver::train_sgd(uint16_t cycles) {
+    void Solver::end_cycle() {
+
+        Profiler::Scope scope(net.name, "update");
 
-        for (uint16_t i = 0; i < cycles; ++i) {
+        // update weights using mean gradient
+        float step = lr / batch_size;
+        for (auto & block_pair : net.blocks) {
+            block_ptr b = block_pair.second;
+            if (b->trainable) {
+                weights(*b) -= step * b->grad;
+                updated(*b);
+            }
+        }
 
-            // possibly update learning rate
-            if (steps_without_change >= cycle_length)
-                lr *= decay_factor;
-            steps_without_change++;
+        if (!nesterov)
+            return;
 
-            // zero out gradient from previous cycle
+        // update momentum
+        float scale = (1-inertia) / batch_size;
+        for (auto & block_pair : net.blocks) {
+            block_ptr b = block_pair.second;
+            if (b->trainable) 
+                momentum[b->name] =
+                    inertia * momentum[b->name] +
+                    scale * b->grad;
+        }
+    }
+
+    void Solver::accumulate_gradient() {
+
+        // zero out gradient from previous cycle
+        {
+            Profiler::Scope scope(net.name, "zero_grad");
             for (auto & block_pair : net.blocks) {
                 block_ptr b = block_pair.second;
                 b->zero_grad();
             }
+        }
+
+        for (index_t i = 0; i < batch_size; ++i) {
+
+            // gradient of blocks passed through net belongs only 
+            // to the previous sample
+            if (i > 0) {
+                Profiler::Scope scope(net.name, "zero_grad");
+                for (auto & block_pair : net.blocks) {
+                    block_ptr b = block_pair.second;
+                    if (!b->trainable)
+                        b->zero_grad();
+                }
+            }
 
             // forward pass
             net.forward();
                 
             // compute error gradient on the op output and 
             // save it in the output blocks
-            std::vector<Eigen::Tensor<float,3>> grads = 
-                Error::L2_grad(output, desired);
-            for (uint16_t i = 0; i < output.size(); ++i) {
-                output[i]->grad = grads[i];
+            {
+                Profiler::Scope scope(net.name, "loss");
+                std::vector<Eigen::Tensor<float,3>> grads = 
+                    Error::L2_grad(output, desired);
+                for (std::size_t j = 0; j < output.size(); ++j) {
+                    output[j]->grad = grads[j];
+                }
             }
 
-            // backward
-            net.backward();
-
-            // update weights using gradient
-            for (auto & block_pair : net.blocks) {
-                block_ptr b = block_pair.second;
-                if (b->trainable) 
-                    b->data -= lr * b->grad;
+            // backward, gradient of trainable blocks is accumulated
+            if (exchange && i == batch_size - 1) {
+                // gradient of the whole batch is exchanged with other
+                // processes while backward pass continues
+                exchange->begin();
+                net.backward([&](Op* op) { exchange->done(op); });
+                Profiler::Scope scope(net.name, "exchange");
+                exchange->end();
+            } else {
+                net.backward();
             }
-
         }
 
-        return Error::L2(output, desired);
     }
 
-    float Solver::train_nesterov(uint16_t cycles) {
+    float Solver::train_hogwild(index_t cycles) {
 
-        for (uint16_t i = 0; i < cycles; ++i) {
+        index_t threads = workers.size() + 1;
+        float step = lr / batch_size;
 
-            // possibly update learning rate
-            if (steps_without_change >= cycle_length)
-                lr *= decay_factor;
-            steps_without_change++;
-
-            // zero out gradient from previous cycle
-            for (auto & block_pair : net.blocks) {
-                block_ptr b = block_pair.second;
+        // gradient left in shared blocks would be applied by threads
+        for (auto & block_pair : net.blocks) {
+            block_ptr b = block_pair.second;
+            if (b->trainable)
                 b->zero_grad();
+        }
+
+        std::vector<std::exception_ptr> errors(threads);
+
+        auto work = [&](index_t index) {
+            // split cycles evenly between threads
+            index_t count = cycles / threads + (index < cycles % threads);
+            try {
+                if (index == 0) {
+                    hogwild_cycles(net, output, desired, step, count);
+                } else {
+                    Worker & w = workers[index - 1];
+                    hogwild_cycles(w.replica->net(), w.output, w.desired,
+                                   step, count);
+                }
+            } catch (...) {
+                errors[index] = std::current_exception();
             }
+        };
 
-            // update weights using momentum term
-            for (auto & block_pair : net.blocks) {
-                block_ptr b = block_pair.second;
-                if (b->trainable) 
-                    b->data -= (lr/3) * momentum[b->name];
-            }            
+        // original network is trained by the calling thread
+        std::vector<std::thread> pool;
+        for (index_t i = 1; i < threads; ++i) {
+            pool.emplace_back(work, i);
+        }
+        work(0);
+        for (auto & t : pool) {
+            t.join();
+        }
 
-            // forward pass
-            net.forward();
-                
-            // compute error gradient on the op output and 
-            // save it in the output blocks
-            std::vector<Eigen::Tensor<float,3>> grads = 
-                Error::L2_grad(output, desired);
-            for (uint16_t i = 0; i < output.size(); ++i) {
-                output[i]->grad = grads[i];
-            }
+        for (auto & e : errors) {
+            if (e)
+                std::rethrow_exception(e);
+        }
 
-            // backward
-            net.backward();
+        // learning rate is decayed as if cycles ran sequentially
+        for (index_t i = 0; i < cycles; ++i) {
+            decay_lr();
+        }
 
-            // update weights using gradient
-            for (auto & block_pair : net.blocks) {
-                block_ptr b = block_pair.second;
-                if (b->trainable) 
-                    b->data -= lr * b->grad;
+        return Error::L2(output, desired);
+    }
+
+    void Solver::hogwild_cycles(Net & net,
+                                const std::vector<block_ptr> & output,
+                                const std::vector<block_ptr> & desired,
+                                float step, index_t cycles) {
+
+        for (index_t i = 0; i < cycles; ++i) {
+
+            for (index_t j = 0; j < batch_size; ++j) {
+
+                // gradient of shared trainable blocks must not be reset,
+                // it may hold gradient of other threads
+                {
+                    Profiler::Scope scope(net.name, "zero_grad");
+                    for (auto & block_pair : net.blocks) {
+                        block_ptr b = block_pair.second;
+                        if (!b->trainable)
+                            b->zero_grad();
+                    }
+                }
+
+                net.forward();
+
+                {
+                    Profiler::Scope scope(net.name, "loss");
+                    std::vector<Eigen::Tensor<float,3>> grads = 
+                        Error::L2_grad(output, desired);
+                    for (std::size_t k = 0; k < output.size(); ++k) {
+                        output[k]->grad = grads[k];
+                    }
+                }
+
+                net.backward();
             }
 
-            // update momentum
+            // apply and consume accumulated gradient, intentionally racy
+            Profiler::Scope scope(net.name, "update");
             for (auto & block_pair : net.blocks) {
                 block_ptr b = block_pair.second;
-                if (b->trainable) 
-                    momentum[b->name] =
-                        inertia * momentum[b->name] +
-                        (1-inertia) * b->grad;
+                if (!b->trainable)
+                    continue;
+                float* data = weights(*b).data();
+                float* grad = b->grad.data();
+                for (Eigen::Index k = 0; k < b->data.size(); ++k) {
+                    float g = grad[k];
+                    grad[k] = 0;
+                    data[k] -= step * g;
+                }
+                updated(*b);
             }
         }
 
-        return Error::L2(output, desired);
+    }
+
+    void Solver::setHogwild(index_t threads) {
+
+        if (threads == 0 || (threads > 1 && (nesterov || exchange)))
+            throw InputException();
+
+        workers.clear();
+
+        if (threads == 1) {
+            net.shard(0, 1);
+            return;
+        }
+
+        net.shard(0, threads);
+        for (index_t i = 1; i < threads; ++i) {
+            Worker w;
+            w.replica.reset(new Replica(net, true));
+            w.replica->net().shard(i, threads);
+            w.output = corresponding(w.replica->net(), output);
+            w.desired = corresponding(w.replica->net(), desired);
+            workers.push_back(std::move(w));
+        }
+    }
+
+    void Solver::setDistributed(Ring & ring) {
+
+        if (!workers.empty())
+            throw InputException();
+
+        net.shard(ring.rank, ring.size);
+        exchange.reset(new GradientExchange(net, ring));
+    }
+
+    std::vector<block_ptr> 
+    Solver::corresponding(Net & copy, const std::vector<block_ptr> & blocks) {
+
+        std::vector<block_ptr> ret;
+        for (auto & b : blocks) {
+            auto it = copy.blocks.find(b->name);
+            if (it == copy.blocks.end())
+                ret.push_back(b);
+            else
+                ret.push_back(it->second);
+        }
+        return ret;
     }
 
     void Solver::setMethod(std::string name) {
@@ -124,6 +304,10 @@ namespace nl {
         if (name == "sgd")
             nesterov = false;
         else if (name == "nesterov") {            
+            // momentum is not supported by Hogwild training
+            if (!workers.empty())
+                throw InputException();
+
             nesterov = true;
             // potentially initialize momentum map
             if (momentum.empty())
@@ -133,11 +317,49 @@ namespace nl {
 
     }
 
-    void Solver::setLRDecay(float multiplier, uint16_t period) {
+    void Solver::setLRDecay(float multiplier, index_t period) {
         decay_factor = multiplier;
         cycle_length = period;            
     }
 
+    void Solver::setBatchSize(index_t size) {
+
+        if (size == 0)
+            throw InputException();
+
+        batch_size = size;
+    }
+
+    void Solver::init_master() {
+        for (auto & block_pair : net.blocks) {
+            block_ptr b = block_pair.second;
+            if (!b->trainable || b->precision() == FP32)
+                continue;
+            // data changed by someone else replaces master weights
+            auto it = master_version.find(b->name);
+            if (it != master_version.end() && it->second == b->version)
+                continue;
+            master[b->name] = b->data;
+            master_version[b->name] = b->version;
+        }
+    }
+
+    Eigen::Tensor<float,3> & Solver::weights(Block & b) {
+        if (b.precision() == FP32)
+            return b.data;
+        return master.at(b.name);
+    }
+
+    void Solver::updated(Block & b) {
+        if (b.precision() == FP32) {
+            ++b.version;
+            return;
+        }
+        b.data = master.at(b.name);
+        b.store();
+        master_version.at(b.name) = b.version;
+    }
+
     void Solver::init_momentum() {
 
         // create a momentum tensor of correct dimension 
@@ -1,6 +1,7 @@
 #ifndef NEURAL_LIB_SOLVER_H
 #define NEURAL_LIB_SOLVER_H
 
+#include <memory>
 #include <vector>
 #include <unordered_map>
 
@@ -9,6 +10,9 @@
 #include "block.hpp"
 #include "net.hpp"
 #include "error.hpp"
+#include "gradient_exchange.hpp"
+#include "replica.hpp"
+#include "ring.hpp"
 
 namespace nl {
 
@@ -30,12 +34,18 @@ namespace nl {
         Solver(Net & net, 
                std::vector<block_ptr> output, 
                std::vector<block_ptr> desired):
-            net(net), output(output), desired(desired), lr(0.1) {}        
+            net(net), output(output), desired(desired), lr(0.1),
+            nesterov(false),
+            decay_factor(0.1), cycle_length(1000), steps_without_change(0) {}
+        /// Destructor.
+        ~Solver();
         /// Forward pass, backward pass and subsequent weight update
-        /// constitutes a single cycle. 
+        /// constitutes a single cycle. If batch size is greater than one,
+        /// each cycle runs that many forward and backward passes before
+        /// the weights are updated.
         /// @param cycles how many times should the update be performed
         /// @return error from the last cycle
-        float train(uint16_t cycles=1);
+        float train(index_t cycles=1);
         /// Specify learning method. Currently either "nesterov"
         /// for Nesterov gradient descent with momentum or "sgd" for
         /// Stochastic gradient descent.
@@ -50,21 +60,132 @@ namespace nl {
         /// @param period number of iterations after which multiplication is
         /// performed
         ///
-        void setLRDecay(float multiplier, uint16_t period);
+        void setLRDecay(float multiplier, index_t period);
+        ///
+        /// Set number of samples whose gradient is accumulated in
+        /// trainable blocks before a single weight update is performed.
+        /// The update then uses the mean gradient of those samples.
+        /// Batch size of zero is invalid and throws an exception.
+        /// @param size number of forward and backward passes per update
+        ///
+        void setBatchSize(index_t size);
+        ///
+        /// Train network on several threads in the Hogwild manner. Every
+        /// thread has its own copy of blocks passed through the network 
+        /// and its own share of data read by reader ops, but all of them
+        /// use trainable blocks of the original network. Threads update
+        /// these blocks without any locking, see hogwild_cycles().
+        /// Only SGD method is supported. Learning rate decay is applied
+        /// between calls of train(), not during them. Setting a single
+        /// thread returns to standard training.
+        /// @param threads number of threads
+        ///
+        void setHogwild(index_t threads);
+        ///
+        /// Train network together with other processes of the ring. Each
+        /// process reads its own share of data and, for every update,
+        /// gradient is averaged over all processes so that their networks
+        /// stay identical. Weights of rank 0 are copied to other ranks,
+        /// all of them have to call this method. Cannot be combined 
+        /// with Hogwild training.
+        /// @param ring processes taking part in training, it has to
+        /// outlive the solver
+        ///
+        void setDistributed(Ring & ring);
+
+        Solver(const Solver &) = delete;
+        Solver & operator=(const Solver &) = delete;
     private:
+        friend class ParallelSolver;
+        /// Possibly decay learning rate, called once per training cycle.
+        void decay_lr();
         ///
-        /// Single training cycle as defined by the method "train"
-        /// using Stochastic Gradient Descent.
-        /// 
-        float train_sgd(uint16_t cycles);
+        /// First part of a single training cycle as defined by the method
+        /// "train". Possibly decays learning rate and, for Nesterov
+        /// Gradient Descent with Momentum, moves weights by momentum term.
+        ///
+        void begin_cycle();
+        ///
+        /// Last part of a single training cycle as defined by the method 
+        /// "train". Updates weights using mean gradient accumulated in
+        /// trainable blocks and, for Nesterov Gradient Descent with Momentum,
+        /// updates momentum.
         ///
-        /// Single training cycle as defined by the method "train"
-        /// using Nesterov Gradient Descent with Momentum.
-        ///         
-        float train_nesterov(uint16_t cycles);
+        void end_cycle();
+        ///
+        /// Zero out gradient of all blocks and run 'batch_size' forward
+        /// and backward passes. Gradient of trainable blocks is accumulated
+        /// over all passes, gradient of other blocks is reset before each 
+        /// of them.
+        ///
+        void accumulate_gradient();
         /// Initialize momentum map.
         void init_momentum();
         ///
+        /// Copy data of trainable blocks of reduced precision to master
+        /// weights, unless master weights exist and the data has not
+        /// changed since the solver last wrote it (e.g. by loading,
+        /// pruning or a broadcast of weights).
+        ///
+        void init_master();
+        ///
+        /// Weights updated by the solver, 'data' of blocks in single
+        /// precision and master weights of others.
+        ///
+        Eigen::Tensor<float,3> & weights(Block & b);
+        ///
+        /// Finish update of weights of a block, data of blocks of reduced
+        /// precision is rounded from master weights.
+        ///
+        void updated(Block & b);
+        /// Training as defined by the method "train" using Hogwild threads.
+        float train_hogwild(index_t cycles);
+        ///
+        /// Training cycles of a single Hogwild thread. Gradient of 
+        /// trainable blocks is shared by all threads, each of them 
+        /// accumulates its gradient there and, at the end of cycle, 
+        /// subtracts whatever is accumulated from weights and zeroes it.
+        /// Plain float reads and writes are used without any synchronization
+        /// on purpose: threads may see partially updated weights or 
+        /// occasionally lose a part of a concurrent gradient update. 
+        /// Stochastic gradient descent tolerates such noise and avoiding 
+        /// locks is the point of the method.
+        /// @param net network (or its copy) trained by the thread
+        /// @param output output blocks of 'net'
+        /// @param desired desired blocks for 'net'
+        /// @param step learning rate divided by batch size
+        /// @param cycles number of cycles performed by the thread
+        ///
+        void hogwild_cycles(Net & net,
+                            const std::vector<block_ptr> & output,
+                            const std::vector<block_ptr> & desired,
+                            float step, index_t cycles);
+        ///
+        /// Find blocks of the same name in copy of the network. Blocks
+        /// that are not part of the copy are used directly.
+        /// @param copy copy of the network
+        /// @param blocks blocks of the original network
+        /// @return corresponding blocks of the copy
+        ///
+        static std::vector<block_ptr> 
+        corresponding(Net & copy, const std::vector<block_ptr> & blocks);
+        /// Copy of the network trained by a single Hogwild thread.
+        struct Worker {
+            /// copy of the network sharing trainable blocks
+            std::unique_ptr<Replica> replica;
+            /// output blocks of the copy
+            std::vector<block_ptr> output;
+            /// desired blocks of the copy
+            std::vector<block_ptr> desired;
+        };
+        ///
+        /// Copies of the network trained by additional Hogwild threads. 
+        /// The original network is trained by the calling thread.
+        ///
+        std::vector<Worker> workers;
+        /// Exchange of gradient with other processes, if any.
+        std::unique_ptr<GradientExchange> exchange;
+        ///
         /// Network that is being 
         /// trained by the solver.
         ///
@@ -82,9 +203,11 @@ namespace nl {
         /// Learning rate is multiplied by this number after each cycle
         float decay_factor;
         /// How often is learning rate changed
-        uint16_t cycle_length;
+        index_t cycle_length;
         /// Number of gradient updates without learning rate change.
-        uint16_t steps_without_change;
+        index_t steps_without_change;
+        /// Number of samples used for a single weight update.
+        index_t batch_size = 1;
         ///
         /// How much of the previos momentum term is preserved to the next
         /// iteration.
@@ -97,6 +220,17 @@ namespace nl {
         /// a name of its corresponding block.
         /// 
         std::unordered_map<std::string, Eigen::Tensor<float,3>> momentum;        
+        ///
+        /// Single precision master weights of trainable blocks stored in
+        /// reduced precision, see Block::setPrecision(). Updates too small
+        /// for 16 bits accumulate here instead of being rounded away, data
+        /// of blocks is rounded from them after every update. Identified
+        /// by names of blocks, created by train() and kept between calls.
+        ///
+        std::unordered_map<std::string, Eigen::Tensor<float,3>> master;
+        /// Version of each block after its data was last rounded from
+        /// master weights, see Block::version.
+        std::unordered_map<std::string, std::uint64_t> master_version;
     };
 
 
@@ -3,16 +3,29 @@
 
 #include "neural.hpp"
 
+#include "test_autotuner.hpp"
 #include "test_block.hpp"
+#include "test_c_api.hpp"
+#include "test_codegen.hpp"
+#include "test_context.hpp"
 #include "test_conv.hpp"
 #include "test_dense.hpp"
+#include "test_engine.hpp"
+#include "test_fft.hpp"
 #include "test_graph.hpp"
+#include "test_half.hpp"
 #include "test_maxpool.hpp"
 #include "test_net.hpp"
+#include "test_parallel_solver.hpp"
+#include "test_profiler.hpp"
+#include "test_pruner.hpp"
+#include "test_quantizer.hpp"
 #include "test_neuron.hpp"
 #include "test_reader.hpp"
+#include "test_ring.hpp"
 #include "test_serialization.hpp"
 #include "test_softmax.hpp"
+#include "test_solver.hpp"
 #include "test_transfer_fn.hpp"
 
 int main(int argc, char **argv) {
@@ -0,0 +1,64 @@
+#ifndef NEURAL_LIB_AUTOTUNER_TEST_H
+#define NEURAL_LIB_AUTOTUNER_TEST_H
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "autotuner.hpp"
+#include "conv.hpp"
+
+TEST(AutotunerTest, Cache) {
+
+    std::string file = "test/autotuner_test.txt";
+    std::remove(file.c_str());
+    nl::Autotuner::reset();
+    nl::Autotuner::enable(file);
+
+    nl::block_ptr b = std::make_shared<nl::Block>("b", 2, 6, 6);
+    b->data.setRandom();
+    nl::Conv c("c", "tanh", b, 3, 3, 1, 1);
+    for (auto & block_pair : c.inputs()) {
+        block_pair.second->grad.setZero();
+    }
+    c.forward();
+    Eigen::Tensor<float, 3> tuned = c.outputs()["c_out"]->data;
+
+    // measurement is not visible in results
+    for (auto & block_pair : c.inputs()) {
+        Eigen::Tensor<float, 0> sum = block_pair.second->grad.abs().sum();
+        EXPECT_EQ(sum(), 0);
+    }
+    c.setAlgorithm("direct");
+    c.forward();
+    Eigen::Tensor<float, 0> diff = 
+        (tuned - c.outputs()["c_out"]->data).abs().maximum();
+    EXPECT_LT(diff(), 1e-5);
+
+    // winner is stored and read back after restart
+    std::string key = "Conv 2x6x6 depth 3 window 3 padding 1 stride 1 groups 1";
+    std::string winner = nl::Autotuner::lookup(key);
+    EXPECT_NE(winner, "");
+    nl::Autotuner::disable();
+    nl::Autotuner::reset();
+    EXPECT_EQ(nl::Autotuner::lookup(key), "");
+    nl::Autotuner::enable(file);
+    EXPECT_EQ(nl::Autotuner::lookup(key), winner);
+
+    // kernel is picked from the cache without measuring
+    nl::Autotuner::record(key, "direct");
+    nl::Conv c2("c2", "tanh", b, 3, 3, 1, 1);
+    c2.forward();
+    EXPECT_EQ(nl::Autotuner::lookup(key), "direct");
+
+    std::ifstream in(file);
+    std::string line;
+    std::getline(in, line);
+    EXPECT_EQ(line, nl::Autotuner::cpu() + "\t" + key + "\tdirect");
+
+    nl::Autotuner::disable();
+    nl::Autotuner::reset();
+    std::remove(file.c_str());
+}
+
+#endif // NEURAL_LIB_AUTOTUNER_TEST_H
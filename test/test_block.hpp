@@ -2,6 +2,10 @@
 #ifndef NEURAL_LIB_BLOCK_TEST_H
 #define NEURAL_LIB_BLOCK_TEST_H
 
+#include <cmath>
+#include <memory>
+#include <vector>
+
 #include "block.hpp"
 
 TEST(BlockTest, Name) {
@@ -14,7 +18,7 @@ TEST(BlockTest, Name) {
 TEST(BlockTest, Dimensions) {
 
     nl::Block b("block", 1, 2, 3);
-    std::vector<uint16_t> dim = b.dimensions();
+    std::vector<nl::index_t> dim = b.dimensions();
 
     EXPECT_EQ(dim[0], 1);
     EXPECT_EQ(dim[1], 2);
@@ -32,4 +36,67 @@ TEST(BlockTest, DataRW) {
     EXPECT_FLOAT_EQ(b.grad(0,0,0), -1.7);
 }
 
+TEST(BlockTest, SizeOverflow) {
+
+    // size does not fit into index type
+    nl::index_t huge = (nl::index_t) 1 << 32;
+    EXPECT_THROW(nl::Block("block", huge, huge, 2), nl::DimensionException);
+    EXPECT_THROW(nl::Block("block", 1, -1, 1), nl::DimensionException);
+
+    // dimensions above 16 bits are fine
+    nl::Block b("block", 1, 1, 70000);
+    EXPECT_EQ(b.dimensions()[2], 70000);
+}
+
+TEST(BlockTest, Precision) {
+
+    nl::Block b("block", 1, 1, 3);
+    b.data(0,0,0) = 1;
+    b.data(0,0,1) = 1.0f / 3;
+    b.data(0,0,2) = 70000;
+    EXPECT_EQ(b.precision(), nl::FP32);
+    EXPECT_TRUE(b.packed.empty());
+
+    // data keeps the rounded values
+    b.setPrecision(nl::FP16);
+    EXPECT_EQ(b.packed.size(), 3u);
+    EXPECT_EQ(b.packed[0], 0x3c00);
+    EXPECT_FLOAT_EQ(b.data(0,0,0), 1);
+    EXPECT_NE(b.data(0,0,1), 1.0f / 3);
+    EXPECT_NEAR(b.data(0,0,1), 1.0f / 3, 1e-3);
+    EXPECT_TRUE(std::isinf(b.data(0,0,2)));
+
+    b.data(0,0,2) = 2;
+    b.store();
+    EXPECT_EQ(b.packed[2], 0x4000);
+
+    b.setPrecision(nl::FP32);
+    EXPECT_TRUE(b.packed.empty());
+    EXPECT_FLOAT_EQ(b.data(0,0,2), 2);
+}
+
+// alias reads and writes the same data, gradient is its own
+TEST(BlockTest, Alias) {
+
+    nl::Block b("block", 1, 2, 1);
+    b.trainable = true;
+    b.data(0,0,0) = 1.5;
+    std::shared_ptr<nl::Block> a = nl::Block::alias(b);
+
+    EXPECT_EQ(a->name, "block");
+    EXPECT_TRUE(a->trainable);
+    EXPECT_EQ(a->dimensions(), b.dimensions());
+    EXPECT_FLOAT_EQ(a->data(0,0,0), 1.5);
+    a->data(0,1,0) = 2;
+    EXPECT_FLOAT_EQ(b.data(0,1,0), 2);
+
+    b.grad(0,0,0) = 3;
+    EXPECT_FLOAT_EQ(a->grad(0,0,0), 0);
+
+    b.setPrecision(nl::FP16);
+    EXPECT_EQ(a->precision(), nl::FP16);
+    EXPECT_EQ(a->packed.size(), 2u);
+    EXPECT_EQ(a->version, b.version);
+}
+
 #endif // NEURAL_LIB_BLOCK_TEST_H
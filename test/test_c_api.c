@@ -0,0 +1,54 @@
+/*
+C client of the C interface. It is compiled by a C compiler, so the
+header is checked to be valid C, and called by CApiTest.C.
+*/
+
+#include <stddef.h>
+#include <string.h>
+
+#include "neural_c.h"
+
+/*
+Load a model, run it once on an input and copy values of an output block.
+The status of the first call that fails is returned.
+*/
+nl_status c_api_run(const char* path, const char* input_name,
+                    const float* input, int64_t input_size,
+                    const char* output_name, float* output,
+                    int64_t output_size) {
+
+    nl_model* model = NULL;
+    nl_context* context = NULL;
+    const float* values = NULL;
+    int64_t size = 0;
+    int64_t dims[3];
+    nl_status status;
+
+    status = nl_model_load(path, &model);
+    if (status != NL_OK)
+        return status;
+    status = nl_context_create(model, &context);
+    if (status != NL_OK) {
+        nl_model_free(model);
+        return status;
+    }
+
+    status = nl_context_dims(context, input_name, dims);
+    if (status == NL_OK && dims[0] * dims[1] * dims[2] != input_size)
+        status = NL_ERROR_DIMENSION;
+    if (status == NL_OK)
+        status = nl_context_bind_input(context, input_name, input,
+                                       input_size);
+    if (status == NL_OK)
+        status = nl_context_run(context);
+    if (status == NL_OK)
+        status = nl_context_output(context, output_name, &values, &size);
+    if (status == NL_OK && size != output_size)
+        status = NL_ERROR_DIMENSION;
+    if (status == NL_OK)
+        memcpy(output, values, (size_t) size * sizeof(float));
+
+    nl_context_free(context);
+    nl_model_free(model);
+    return status;
+}
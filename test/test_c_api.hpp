@@ -0,0 +1,121 @@
+#ifndef NEURAL_LIB_C_API_TEST_H
+#define NEURAL_LIB_C_API_TEST_H
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include <boost/archive/text_oarchive.hpp>
+
+#include "conv.hpp"
+#include "dense.hpp"
+#include "net.hpp"
+#include "neural_c.h"
+
+// defined by test_c_api.c, which is compiled as C
+extern "C" nl_status c_api_run(const char* path, const char* input_name,
+                               const float* input, int64_t input_size,
+                               const char* output_name, float* output,
+                               int64_t output_size);
+
+TEST(CApiTest, Run) {
+
+    nl::block_ptr in = std::make_shared<nl::Block>("in", 2, 5, 5);
+    nl::Conv c("c", "relu", in, 3, 3, 1);
+    nl::Dense d("d", "tanh", c, 4, 1, 1);
+    nl::Net net("net");
+    net.add(&c);
+    net.add(&d);
+
+    std::string filename = "test/c_api_test.txt";
+    {
+        std::ofstream ofs(filename);
+        boost::archive::text_oarchive oa(ofs);
+        oa << net;
+    }
+
+    nl_model* model = nullptr;
+    EXPECT_EQ(nl_model_load("test/missing.txt", &model), NL_ERROR_FILE);
+    EXPECT_EQ(nl_model_load("test/test.cpp", &model), NL_ERROR_FORMAT);
+    ASSERT_EQ(nl_model_load(filename.c_str(), &model), NL_OK);
+
+    nl_context* context = nullptr;
+    ASSERT_EQ(nl_context_create(model, &context), NL_OK);
+
+    int64_t dims[3];
+    ASSERT_EQ(nl_context_dims(context, "in", dims), NL_OK);
+    EXPECT_EQ(dims[0], 2);
+    EXPECT_EQ(dims[1], 5);
+    EXPECT_EQ(dims[2], 5);
+    EXPECT_EQ(nl_context_dims(context, "missing", dims), NL_ERROR_NAME);
+
+    float input[50];
+    EXPECT_EQ(nl_context_bind_input(context, "in", input, 49),
+              NL_ERROR_DIMENSION);
+    EXPECT_EQ(nl_context_bind_input(context, "missing", input, 50),
+              NL_ERROR_NAME);
+    ASSERT_EQ(nl_context_bind_input(context, "in", input, 50), NL_OK);
+
+    const float* output = nullptr;
+    int64_t size = 0;
+    ASSERT_EQ(nl_context_output(context, "d_out", &output, &size), NL_OK);
+    EXPECT_EQ(size, 4);
+
+    // bound buffer is read by every run, output pointer stays the same
+    for (int run = 0; run < 3; ++run) {
+        in->data.setRandom();
+        std::copy(in->data.data(), in->data.data() + 50, input);
+        net.forward();
+
+        ASSERT_EQ(nl_context_run(context), NL_OK);
+        const float* current = nullptr;
+        ASSERT_EQ(nl_context_output(context, "d_out", &current, nullptr),
+                  NL_OK);
+        EXPECT_EQ(current, output);
+        for (int i = 0; i < 4; ++i) {
+            EXPECT_FLOAT_EQ(output[i], d.outputs()["d_out"]->data(i,0,0));
+        }
+    }
+
+    EXPECT_EQ(nl_context_run(nullptr), NL_ERROR_ARGUMENT);
+    EXPECT_STREQ(nl_status_string(NL_ERROR_NAME), "No block of given name.");
+
+    nl_context_free(context);
+    nl_model_free(model);
+    std::remove(filename.c_str());
+}
+
+// the same calls made from C
+TEST(CApiTest, C) {
+
+    nl::block_ptr in = std::make_shared<nl::Block>("in", 2, 5, 5);
+    in->data.setRandom();
+    nl::Conv c("c", "relu", in, 3, 3, 1);
+    nl::Dense d("d", "tanh", c, 4, 1, 1);
+    nl::Net net("net");
+    net.add(&c);
+    net.add(&d);
+    net.forward();
+
+    std::string filename = "test/c_api_c_test.txt";
+    {
+        std::ofstream ofs(filename);
+        boost::archive::text_oarchive oa(ofs);
+        oa << net;
+    }
+
+    float output[4];
+    EXPECT_EQ(c_api_run(filename.c_str(), "in", in->data.data(), 49,
+                        "d_out", output, 4), NL_ERROR_DIMENSION);
+    EXPECT_EQ(c_api_run(filename.c_str(), "in", in->data.data(), 50,
+                        "missing", output, 4), NL_ERROR_NAME);
+    ASSERT_EQ(c_api_run(filename.c_str(), "in", in->data.data(), 50,
+                        "d_out", output, 4), NL_OK);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_FLOAT_EQ(output[i], d.outputs()["d_out"]->data(i,0,0));
+    }
+    std::remove(filename.c_str());
+}
+
+#endif // NEURAL_LIB_C_API_TEST_H
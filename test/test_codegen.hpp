@@ -0,0 +1,94 @@
+#ifndef NEURAL_LIB_CODEGEN_TEST_H
+#define NEURAL_LIB_CODEGEN_TEST_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "codegen.hpp"
+#include "conv.hpp"
+#include "dense.hpp"
+#include "maxpool.hpp"
+#include "net.hpp"
+#include "neuron.hpp"
+#include "softmax.hpp"
+
+TEST(CodegenTest, Compile) {
+
+    nl::block_ptr in = std::make_shared<nl::Block>("in", 4, 13, 13);
+    nl::Conv c1("c1", "relu", in, 6, 3, 1, 2, 2);
+    nl::Conv c2("c2", "tanh", c1, 4, 3, 1);
+    nl::MaxPool p("p", c2, 3, 0, 2);
+    nl::Dense d1("d1", "sigmoid", p, 12, 1, 1);
+    nl::Dense d2("d2", "linear", d1, 5, 1, 1);
+    nl::Softmax s("s", d2);
+    nl::Net net("net");
+    for (nl::Op* op : std::vector<nl::Op*>{&c1, &c2, &p, &d1, &d2, &s}) {
+        net.add(op);
+    }
+    // the second convolution is computed together with pooling
+    ASSERT_EQ(net.fuse(), 1u);
+
+    nl::Codegen codegen(net);
+    ASSERT_EQ(codegen.inputs().size(), 1u);
+    EXPECT_EQ(codegen.inputs()[0], in);
+    ASSERT_EQ(codegen.outputs().size(), 1u);
+    EXPECT_EQ(codegen.outputs()[0]->name, "s_out");
+    codegen.write("test/codegen_test_model.cpp", "model");
+
+    // program printing output of the generated function for an input
+    in->data.setRandom();
+    net.forward();
+    {
+        std::ofstream ofs("test/codegen_test_main.cpp");
+        // nine significant digits restore every float exactly
+        ofs.precision(9);
+        ofs << "#include <cstdio>\n#include \"codegen_test_model.cpp\"\n"
+            << "const float input[] = {";
+        for (nl::index_t i = 0; i < in->data.size(); ++i) {
+            ofs << in->data.data()[i] << "f, ";
+        }
+        ofs << "};\nint main() {\n    float output[5];\n"
+            << "    model(input, output);\n"
+            << "    for (float v : output) std::printf(\"%.9g\\n\", v);\n}\n";
+    }
+    const char* compiler = std::getenv("CXX");
+    std::string command = std::string(compiler ? compiler : "c++") +
+        " -std=c++11 -O2 -Wall -Werror test/codegen_test_main.cpp"
+        " -o test/codegen_test_bin && test/codegen_test_bin"
+        " > test/codegen_test_output.txt";
+    ASSERT_EQ(std::system(command.c_str()), 0);
+
+    // sums are added in another order
+    nl::block_ptr out = s.outputs()["s_out"];
+    std::vector<float> values;
+    {
+        std::ifstream ifs("test/codegen_test_output.txt");
+        float value;
+        while (ifs >> value) {
+            values.push_back(value);
+        }
+    }
+    for (const char* file : {"test/codegen_test_model.cpp",
+                             "test/codegen_test_main.cpp",
+                             "test/codegen_test_bin",
+                             "test/codegen_test_output.txt"}) {
+        std::remove(file);
+    }
+    ASSERT_EQ(values.size(), 5u);
+    for (nl::index_t i = 0; i < 5; ++i) {
+        EXPECT_NEAR(values[i], out->data(i,0,0), 1e-5);
+    }
+
+    // ops without a generator are refused
+    nl::block_ptr cell = std::make_shared<nl::Block>("cell", 1, 1, 1);
+    nl::Neuron n("n", "linear", cell);
+    nl::Net other("other");
+    other.add(&n);
+    EXPECT_THROW(nl::Codegen{other}, nl::UnsupportedException);
+}
+
+#endif // NEURAL_LIB_CODEGEN_TEST_H
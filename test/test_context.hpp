@@ -0,0 +1,68 @@
+#ifndef NEURAL_LIB_CONTEXT_TEST_H
+#define NEURAL_LIB_CONTEXT_TEST_H
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "context.hpp"
+#include "conv.hpp"
+#include "dense.hpp"
+#include "net.hpp"
+
+TEST(ContextTest, Concurrent) {
+
+    nl::block_ptr in = std::make_shared<nl::Block>("in", 2, 6, 6);
+    nl::Conv c("c", "relu", in, 4, 3, 1);
+    nl::Dense d("d", "tanh", c, 1, 1, 3);
+    nl::Net net("net");
+    net.add(&c);
+    net.add(&d);
+
+    // expected output for every context
+    const int count = 4;
+    std::vector<Eigen::Tensor<float, 3>> inputs, expected;
+    for (int i = 0; i < count; ++i) {
+        in->data.setRandom();
+        net.forward();
+        inputs.push_back(in->data);
+        expected.push_back(d.outputs()["d_out"]->data);
+    }
+
+    std::vector<std::unique_ptr<nl::Context>> contexts;
+    for (int i = 0; i < count; ++i) {
+        contexts.emplace_back(new nl::Context(net));
+    }
+
+    // weights are shared, activations are not
+    nl::Context & first = *contexts[0];
+    EXPECT_EQ(first.block("d_w"), d.inputs()["d_w"]);
+    EXPECT_NE(first.block("in"), in);
+    EXPECT_NE(first.block("d_out"), contexts[1]->block("d_out"));
+    EXPECT_THROW(first.block("missing"), nl::InputException);
+    std::size_t activations = (2 * 36 + 4 * 36 + 3) * 2 * sizeof(float);
+    EXPECT_EQ(first.bytes(), activations);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < count; ++i) {
+        threads.emplace_back([&, i] {
+            nl::Context & ctx = *contexts[i];
+            ctx.block("in")->data = inputs[i];
+            for (int pass = 0; pass < 50; ++pass) {
+                ctx.forward();
+            }
+        });
+    }
+    for (auto & t : threads) {
+        t.join();
+    }
+
+    for (int i = 0; i < count; ++i) {
+        nl::block_ptr out = contexts[i]->block("d_out");
+        for (nl::index_t j = 0; j < 3; ++j) {
+            EXPECT_FLOAT_EQ(out->data(0,0,j), expected[i](0,0,j));
+        }
+    }
+}
+
+#endif // NEURAL_LIB_CONTEXT_TEST_H
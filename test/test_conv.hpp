@@ -170,6 +170,27 @@ TEST(ConvTest, Forward3) {
     
 }
 
+TEST(ConvTest, ForwardPaddingNonSquare) {
+
+    // window may reach below the input only through padding
+    nl::block_ptr b = std::make_shared<nl::Block>("b", 1, 2, 3);
+    nl::Conv c("c", "linear", b, 1, 3, 1);
+
+    nl::block_ptr out = c.outputs()["c_out"];
+    b->data.setConstant(1);
+    c.inputs()["c_w0"]->data.setConstant(1);
+    c.inputs()["c_thr0"]->data.setZero();
+
+    c.forward();
+
+    // number of input cells covered by each window
+    EXPECT_FLOAT_EQ(out->data(0,0,0), 4);
+    EXPECT_FLOAT_EQ(out->data(0,1,1), 6);
+    EXPECT_FLOAT_EQ(out->data(0,0,2), 4);
+    EXPECT_FLOAT_EQ(out->data(0,1,2), 4);
+
+}
+
 TEST(ConvTest, Backward1) {
 
     nl::block_ptr b1 = std::make_shared<nl::Block>("b1", 1, 2, 2);
@@ -323,4 +344,228 @@ TEST(ConvTest, Backward3) {
     
 }
 
+TEST(ConvTest, Cost) {
+
+    // 3x3 window with padding 1 on 3x3 input, cells of padding
+    // are not multiplied
+    nl::block_ptr b = std::make_shared<nl::Block>("b", 2, 3, 3);
+    nl::Conv c("c", "relu", b, 4, 3, 1);
+
+    // 7 valid window positions along each dimension
+    double taps = 4 * 2 * 7 * 7;
+    double out = 4 * 3 * 3;
+    EXPECT_DOUBLE_EQ(c.forward_cost().flops, 2 * taps + 2 * out);
+    EXPECT_DOUBLE_EQ(c.backward_cost().flops, 4 * taps + 3 * out);
+
+    // input, kernels and thresholds are read, output written
+    EXPECT_DOUBLE_EQ(c.forward_cost().bytes_read,
+                     (18 + 4 * 18 + 4) * sizeof(float));
+    EXPECT_DOUBLE_EQ(c.forward_cost().bytes_written, out * sizeof(float));
+}
+
+TEST(ConvTest, Groups) {
+
+    nl::block_ptr b = std::make_shared<nl::Block>("b", 4, 3, 3);
+    b->data.setRandom();
+
+    // groups have to divide input and output depth
+    EXPECT_THROW(nl::Conv("c", "linear", b, 4, 3, 1, 1, 3), nl::InputException);
+    EXPECT_THROW(nl::Conv("c", "linear", b, 3, 3, 1, 1, 2), nl::InputException);
+
+    nl::Conv c("c", "linear", b, 6, 3, 1, 1, 2);
+    EXPECT_EQ(c.inputs()["c_w0"]->dimensions()[0], 2);
+    EXPECT_EQ(c.inputs().size(), 1 + 6 * 2);
+
+    // second group of output slices does not see first group of input
+    nl::block_ptr out = c.outputs()["c_out"];
+    c.forward();
+    Eigen::Tensor<float, 3> before = out->data;
+    b->data.chip(0, 0).setConstant(100);
+    b->data.chip(1, 0).setConstant(-100);
+    c.forward();
+    for (nl::index_t d = 0; d < 6; ++d) {
+        for (nl::index_t y = 0; y < 3; ++y) {
+            for (nl::index_t z = 0; z < 3; ++z) {
+                if (d < 3)
+                    EXPECT_NE(out->data(d,y,z), before(d,y,z));
+                else
+                    EXPECT_FLOAT_EQ(out->data(d,y,z), before(d,y,z));
+            }
+        }
+    }
+
+}
+
+// compare forward and backward pass of given kernel with direct computation
+void expect_same_as_direct(nl::Conv & c, const std::string & algorithm) {
+
+    nl::block_ptr out = c.outputs().begin()->second;
+
+    auto pass = [&](const std::string & name) {
+        c.setAlgorithm(name);
+        for (auto & block_pair : c.inputs()) {
+            block_pair.second->grad.setZero();
+        }
+        c.forward();
+        out->grad = out->data * out->data.constant(0.5f) + out->data.constant(0.1f);
+        c.backward();
+
+        std::vector<Eigen::Tensor<float, 3>> result = {out->data};
+        for (auto & block_pair : c.inputs()) {
+            result.push_back(block_pair.second->grad);
+        }
+        return result;
+    };
+
+    auto direct = pass("direct");
+    auto fast = pass(algorithm);
+    ASSERT_EQ(direct.size(), fast.size());
+    for (std::size_t i = 0; i < direct.size(); ++i) {
+        for (Eigen::Index j = 0; j < direct[i].size(); ++j) {
+            EXPECT_NEAR(direct[i].data()[j], fast[i].data()[j], 1e-4);
+        }
+    }
+    c.setAlgorithm("auto");
+}
+
+TEST(ConvTest, Depthwise) {
+
+    nl::block_ptr b = std::make_shared<nl::Block>("b", 5, 5, 7);
+    b->data.setRandom();
+
+    nl::Conv c1("c1", "tanh", b, 5, 3, 1, 1, 5);
+    expect_same_as_direct(c1, "depthwise");
+
+    nl::Conv c2("c2", "relu", b, 5, 3, 1, 2, 5);
+    expect_same_as_direct(c2, "depthwise");
+
+    // not every group has a single output slice
+    nl::Conv c3("c3", "relu", b, 10, 3, 1, 1, 5);
+    EXPECT_THROW(c3.setAlgorithm("depthwise"), nl::InputException);
+
+}
+
+TEST(ConvTest, Pointwise) {
+
+    nl::block_ptr b = std::make_shared<nl::Block>("b", 6, 4, 3);
+    b->data.setRandom();
+
+    nl::Conv c1("c1", "tanh", b, 8, 1);
+    expect_same_as_direct(c1, "gemm");
+
+    nl::Conv c2("c2", "linear", b, 4, 1, 0, 1, 2);
+    expect_same_as_direct(c2, "gemm");
+
+    nl::Conv c3("c3", "linear", b, 4, 3, 1);
+    EXPECT_THROW(c3.setAlgorithm("gemm"), nl::InputException);
+    EXPECT_THROW(c3.setAlgorithm("fast"), nl::UnknownOptionException);
+
+}
+
+TEST(ConvTest, Winograd) {
+
+    nl::block_ptr b = std::make_shared<nl::Block>("b", 3, 7, 6);
+    b->data.setRandom();
+
+    // odd and even output sizes, every padding
+    for (nl::index_t padding : {0, 1, 2}) {
+        nl::Conv c("c", "tanh", b, 4, 3, padding);
+        expect_same_as_direct(c, "winograd");
+
+        // transformed filters follow a change of weights
+        c.inputs()["c_w2"]->data(1,2,0) += 0.5f;
+        expect_same_as_direct(c, "winograd");
+    }
+
+    nl::block_ptr b2 = std::make_shared<nl::Block>("b2", 3, 5, 5);
+    nl::Conv c1("c1", "relu", b2, 4, 3, 0, 2);
+    EXPECT_THROW(c1.setAlgorithm("winograd"), nl::InputException);
+    nl::Conv c2("c2", "relu", b, 3, 3, 1, 1, 3);
+    EXPECT_THROW(c2.setAlgorithm("winograd"), nl::InputException);
+
+}
+
+TEST(ConvTest, FFT) {
+
+    nl::block_ptr b = std::make_shared<nl::Block>("b", 2, 9, 6);
+    b->data.setRandom();
+
+    for (nl::index_t window : {2, 5}) {
+        nl::Conv c("c", "tanh", b, 3, window, window / 2);
+        expect_same_as_direct(c, "fft");
+
+        // transformed filters follow a change of weights
+        c.inputs()["c_w1"]->data(0,1,1) -= 0.5f;
+        expect_same_as_direct(c, "fft");
+    }
+
+    nl::block_ptr b2 = std::make_shared<nl::Block>("b2", 2, 5, 5);
+    nl::Conv c1("c1", "relu", b2, 2, 3, 0, 2);
+    EXPECT_THROW(c1.setAlgorithm("fft"), nl::InputException);
+    nl::Conv c2("c2", "relu", b2, 2, 3, 1, 1, 2);
+    EXPECT_THROW(c2.setAlgorithm("fft"), nl::InputException);
+
+}
+
+TEST(ConvTest, Im2col) {
+
+    nl::block_ptr b = std::make_shared<nl::Block>("b", 4, 7, 5);
+    b->data.setRandom();
+
+    nl::Conv c1("c1", "tanh", b, 3, 3, 1, 2);
+    expect_same_as_direct(c1, "im2col");
+
+    nl::Conv c2("c2", "relu", b, 6, 2, 1, 1, 2);
+    expect_same_as_direct(c2, "im2col");
+
+    nl::Conv c3("c3", "linear", b, 2, 1);
+    expect_same_as_direct(c3, "im2col");
+
+}
+
+TEST(ConvTest, Specialized) {
+
+    nl::block_ptr b = std::make_shared<nl::Block>("b", 4, 9, 7);
+    b->data.setRandom();
+
+    // window, padding and stride of specialized kernels
+    struct Shape { nl::index_t window, padding, stride; };
+    for (Shape s : std::vector<Shape>{{1, 0, 1}, {3, 0, 1}, {3, 1, 1},
+                                      {3, 1, 2}, {5, 2, 1}, {7, 3, 2}}) {
+        for (nl::index_t groups : {1, 2}) {
+            nl::Conv c("c", "tanh", b, 6, s.window, s.padding, s.stride,
+                       groups);
+            c.setAlgorithm("direct");
+            nl::block_ptr out = c.outputs()["c_out"];
+            nl::block_ptr kernel = c.inputs()["c_w5"];
+            out->grad.setRandom();
+
+            // both passes, gradients are accumulated from zero
+            auto pass = [&](bool specialized) {
+                nl::Conv::setSpecialized(specialized);
+                b->grad.setZero();
+                kernel->grad.setZero();
+                c.forward();
+                c.backward();
+            };
+
+            pass(false);
+            Eigen::Tensor<float, 3> generic = out->data;
+            Eigen::Tensor<float, 3> input_grad = b->grad;
+            Eigen::Tensor<float, 3> kernel_grad = kernel->grad;
+            pass(true);
+            for (Eigen::Index i = 0; i < generic.size(); ++i) {
+                EXPECT_NEAR(out->data.data()[i], generic.data()[i], 1e-5);
+            }
+            for (Eigen::Index i = 0; i < input_grad.size(); ++i) {
+                EXPECT_NEAR(b->grad.data()[i], input_grad.data()[i], 1e-4);
+            }
+            for (Eigen::Index i = 0; i < kernel_grad.size(); ++i) {
+                EXPECT_NEAR(kernel->grad.data()[i], kernel_grad.data()[i], 1e-4);
+            }
+        }
+    }
+
+}
+
 #endif // NEURAL_LIB_CONV_TEST_H
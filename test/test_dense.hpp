@@ -22,6 +22,29 @@ TEST(TestDense, Constructors) {
 
 }
 
+// more than 65535 weights
+TEST(TestDense, LargeLayer) {
+
+    nl::block_ptr in = std::make_shared<nl::Block>("in", 1, 1, 512);
+    nl::Dense d("d", "linear", in, 1, 1, 512);
+    nl::block_ptr weight = d.inputs()["d_w"];
+    nl::block_ptr thr = d.inputs()["d_thr"];
+
+    EXPECT_EQ(weight->data.size(), 512 * 512);
+
+    // each output sums all inputs
+    weight->data.setConstant(1);
+    thr->data.setZero();
+    in->data.setConstant(0.5);
+    d.forward();
+    EXPECT_FLOAT_EQ(d.outputs()["d_out"]->data(0,0,511), 256);
+
+    // number of weights does not fit into index type
+    nl::index_t huge = (nl::index_t) 1 << 32;
+    EXPECT_THROW(nl::Dense("d", "linear", in, huge, huge, 1),
+                 nl::DimensionException);
+}
+
 // forward 
 TEST(TestDense, Forward) {
 
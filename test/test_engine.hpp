@@ -0,0 +1,91 @@
+#ifndef NEURAL_LIB_ENGINE_TEST_H
+#define NEURAL_LIB_ENGINE_TEST_H
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "dense.hpp"
+#include "engine.hpp"
+#include "net.hpp"
+
+TEST(EngineTest, Batches) {
+
+    nl::block_ptr in = std::make_shared<nl::Block>("in", 8, 1, 1);
+    nl::Dense d1("d1", "tanh", in, 1, 1, 6);
+    nl::Dense d2("d2", "linear", d1, 1, 1, 3);
+    nl::Net net("net");
+    net.add(&d1);
+    net.add(&d2);
+
+    const int count = 8;
+    std::vector<Eigen::Tensor<float, 3>> inputs, expected;
+    for (int i = 0; i < count; ++i) {
+        in->data.setRandom();
+        net.forward();
+        inputs.push_back(in->data);
+        expected.push_back(d2.outputs()["d2_out"]->data);
+    }
+
+    EXPECT_THROW(nl::Engine(net, "missing", "d2_out"), nl::InputException);
+    EXPECT_THROW(nl::Engine(net, "in", "d2_out", 0), nl::InputException);
+
+    // a long deadline, batches are closed only when full
+    nl::Engine engine(net, "in", "d2_out");
+    engine.setBatchSize(4);
+    engine.setDeadline(std::chrono::seconds(60));
+    EXPECT_THROW(engine.setBatchSize(0), nl::InputException);
+    EXPECT_THROW(engine.submit(Eigen::Tensor<float, 3>(3, 1, 1)),
+                 nl::DimensionException);
+
+    std::vector<std::future<Eigen::Tensor<float, 3>>> results(count);
+    std::thread other([&] {
+        for (int i = 0; i < count; i += 2) {
+            results[i] = engine.submit(inputs[i]);
+        }
+    });
+    for (int i = 1; i < count; i += 2) {
+        results[i] = engine.submit(inputs[i]);
+    }
+    other.join();
+
+    for (int i = 0; i < count; ++i) {
+        Eigen::Tensor<float, 3> out = results[i].get();
+        for (nl::index_t j = 0; j < 3; ++j) {
+            EXPECT_FLOAT_EQ(out(j,0,0), expected[i](j,0,0));
+        }
+    }
+    EXPECT_EQ(engine.batches(), 2u);
+}
+
+TEST(EngineTest, Deadline) {
+
+    nl::block_ptr in = std::make_shared<nl::Block>("in", 4, 1, 1);
+    nl::Dense d("d", "linear", in, 1, 1, 2);
+    nl::Net net("net");
+    net.add(&d);
+
+    std::future<Eigen::Tensor<float, 3>> result;
+    {
+        nl::Engine engine(net, "in", "d_out", 2);
+        engine.setBatchSize(16);
+        engine.setDeadline(std::chrono::milliseconds(1));
+
+        // a lone request is run once it is due
+        in->data.setRandom();
+        ASSERT_EQ(engine.submit(in->data).wait_for(std::chrono::seconds(10)),
+                  std::future_status::ready);
+
+        // a pending request is run when the engine is destroyed
+        engine.setDeadline(std::chrono::seconds(60));
+        result = engine.submit(in->data);
+    }
+    net.forward();
+    Eigen::Tensor<float, 3> out = result.get();
+    EXPECT_FLOAT_EQ(out(0,0,0), d.outputs()["d_out"]->data(0,0,0));
+    EXPECT_FLOAT_EQ(out(1,0,0), d.outputs()["d_out"]->data(1,0,0));
+}
+
+#endif // NEURAL_LIB_ENGINE_TEST_H
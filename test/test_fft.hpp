@@ -0,0 +1,70 @@
+#ifndef NEURAL_LIB_FFT_TEST_H
+#define NEURAL_LIB_FFT_TEST_H
+
+#include <cmath>
+#include <vector>
+
+#include "fft.hpp"
+
+TEST(FFTTest, Size) {
+    EXPECT_EQ(nl::FFT::size(1), 1);
+    EXPECT_EQ(nl::FFT::size(5), 8);
+    EXPECT_EQ(nl::FFT::size(64), 64);
+}
+
+TEST(FFTTest, Transform) {
+
+    // compare with discrete Fourier transform by definition
+    const double pi = std::acos(-1.0);
+    nl::index_t n = 16;
+    std::vector<nl::FFT::complex> data(n);
+    for (nl::index_t i = 0; i < n; ++i) {
+        data[i] = nl::FFT::complex(std::sin(i * 0.7f), std::cos(i * 1.3f));
+    }
+
+    std::vector<nl::FFT::complex> result = data;
+    nl::FFT::transform(result.data(), n, false);
+    for (nl::index_t k = 0; k < n; ++k) {
+        std::complex<double> expected = 0;
+        for (nl::index_t i = 0; i < n; ++i) {
+            expected += std::complex<double>(data[i]) * 
+                std::polar(1.0, -2 * pi * i * k / n);
+        }
+        EXPECT_NEAR(result[k].real(), expected.real(), 1e-4);
+        EXPECT_NEAR(result[k].imag(), expected.imag(), 1e-4);
+    }
+
+    // inverse transform restores data
+    nl::FFT::transform(result.data(), n, true);
+    for (nl::index_t i = 0; i < n; ++i) {
+        EXPECT_NEAR(result[i].real(), data[i].real(), 1e-5);
+        EXPECT_NEAR(result[i].imag(), data[i].imag(), 1e-5);
+    }
+}
+
+TEST(FFTTest, Transform2D) {
+
+    // transform of a shifted impulse is a plane wave
+    nl::index_t width = 8, height = 4;
+    std::vector<nl::FFT::complex> data(width * height, 0);
+    data[3 + width * 1] = 1;
+    nl::FFT::transform(data.data(), width, height, false);
+
+    const double pi = std::acos(-1.0);
+    for (nl::index_t z = 0; z < height; ++z) {
+        for (nl::index_t y = 0; y < width; ++y) {
+            std::complex<double> expected = 
+                std::polar(1.0, -2 * pi * (3.0 * y / width + 1.0 * z / height));
+            EXPECT_NEAR(data[y + width * z].real(), expected.real(), 1e-5);
+            EXPECT_NEAR(data[y + width * z].imag(), expected.imag(), 1e-5);
+        }
+    }
+
+    nl::FFT::transform(data.data(), width, height, true);
+    for (nl::index_t i = 0; i < width * height; ++i) {
+        EXPECT_NEAR(data[i].real(), i == 3 + width ? 1 : 0, 1e-6);
+        EXPECT_NEAR(data[i].imag(), 0, 1e-6);
+    }
+}
+
+#endif // NEURAL_LIB_FFT_TEST_H
@@ -2,8 +2,13 @@
 #define NEURAL_LIB_GRAPH_TEST_H
 
 #include <iostream>
+#include <sstream>
+#include <string>
 #include <vector>
 
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/archive/text_oarchive.hpp>
+
 #include "gtest/gtest.h"
 
 #include "graph.hpp"
@@ -79,4 +84,99 @@ TEST(GraphTest, Ordering4) {
     EXPECT_THROW(g.get_ordering(), nl::TopologicalException);
 }
 
+// position of every name in the ordering, checked to respect all edges
+std::unordered_map<std::string, std::size_t> expect_ordered(
+    nl::Graph & g,
+    const std::vector<std::pair<std::string, std::string>> & edges) {
+
+    std::vector<std::string> vect = g.get_ordering();
+    std::unordered_map<std::string, std::size_t> position;
+    for (std::size_t i = 0; i < vect.size(); ++i) {
+        position[vect[i]] = i;
+    }
+    EXPECT_EQ(position.size(), vect.size());
+    for (auto & e : edges) {
+        EXPECT_LT(position[e.first], position[e.second]);
+    }
+    return position;
+}
+
+TEST(GraphTest, Incremental) {
+
+    nl::Graph g;
+    std::vector<std::pair<std::string, std::string>> edges;
+
+    // edges against the order of insertion move vertices between them
+    for (auto e : std::vector<std::pair<std::string, std::string>>{
+            {"d", "e"}, {"c", "d"}, {"e", "f"}, {"a", "b"}, {"b", "c"},
+            {"f", "g"}, {"a", "g"}, {"x", "a"}}) {
+        EXPECT_TRUE(g.add_edge(e.first, e.second));
+        edges.push_back(e);
+        expect_ordered(g, edges);
+    }
+    EXPECT_EQ(g.size(), 8u);
+
+    // cycle through the reordered vertices
+    g.add_edge("g", "c");
+    EXPECT_THROW(g.get_ordering(), nl::TopologicalException);
+}
+
+TEST(GraphTest, Large) {
+
+    // long chains added from either end, a recursive search would
+    // overflow the stack
+    const int n = 200000;
+    nl::Graph forward, backward;
+    for (int i = 1; i < n; ++i) {
+        forward.add_edge(std::to_string(i - 1), std::to_string(i));
+        backward.add_edge(std::to_string(n - i - 1), std::to_string(n - i));
+    }
+    for (nl::Graph* g : {&forward, &backward}) {
+        std::vector<std::string> vect = g->get_ordering();
+        ASSERT_EQ(vect.size(), (std::size_t) n);
+        for (int i = 0; i < n; ++i) {
+            EXPECT_EQ(vect[i], std::to_string(i));
+        }
+    }
+}
+
+TEST(GraphTest, Serialization) {
+
+    std::vector<std::pair<std::string, std::string>> edges = {
+        {"a", "b"}, {"a", "c"}, {"b", "c"}
+    };
+    nl::Graph g;
+    for (auto & e : edges) {
+        g.add_edge(e.first, e.second);
+    }
+    g.add_vertex("d");
+
+    std::stringstream ss;
+    {
+        boost::archive::text_oarchive oa(ss);
+        oa << g;
+    }
+    nl::Graph loaded;
+    {
+        boost::archive::text_iarchive ia(ss);
+        ia >> loaded;
+    }
+    EXPECT_EQ(loaded.size(), 4u);
+    expect_ordered(loaded, edges);
+
+    // the same graph saved by version 0, vertices with pointers to
+    // their neighbours
+    std::stringstream legacy(
+        "22 serialization::archive 18 0 0 0 0 4 13 0 0 0 1 c 1 0\n"
+        "0 1 c 0 1 b\n1 1 b 0 1 d\n2 1 d 0 1 a\n"
+        "3 1 a 0 0 0 0 0 2 0 3 1 3 0 1 0 3 3 1 0 3 0 2 0 3 3 3 1 0 0 0 0 0 0\n");
+    nl::Graph old;
+    {
+        boost::archive::text_iarchive ia(legacy);
+        ia >> old;
+    }
+    EXPECT_EQ(old.size(), 4u);
+    expect_ordered(old, edges);
+}
+
 #endif // NEURAL_LIB_GRAPH_TEST_H
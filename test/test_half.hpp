@@ -0,0 +1,150 @@
+#ifndef NEURAL_LIB_HALF_TEST_H
+#define NEURAL_LIB_HALF_TEST_H
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "dense.hpp"
+#include "half.hpp"
+#include "net.hpp"
+#include "solver.hpp"
+
+TEST(HalfTest, Pack) {
+
+    // exact values, ties rounded to even, overflow, subnormals and NaN;
+    // lengths above 8 run through vector kernels too
+    std::vector<float> values = {
+        1, -2, 0.5f, 65504, 65520, 1e6f, std::ldexp(1.0f, -24),
+        std::ldexp(3.0f, -26), 1 + std::ldexp(1.0f, -11),
+        1 + std::ldexp(3.0f, -11), std::numeric_limits<float>::infinity(),
+        std::numeric_limits<float>::quiet_NaN()};
+    std::vector<std::uint16_t> fp16 = {
+        0x3c00, 0xc000, 0x3800, 0x7bff, 0x7c00, 0x7c00, 0x0001,
+        0x0001, 0x3c00, 0x3c02, 0x7c00};
+    std::vector<std::uint16_t> bf16 = {
+        0x3f80, 0xc000, 0x3f00, 0x4780, 0x4780, 0x4974, 0x3380,
+        0x3340, 0x3f80, 0x3f80, 0x7f80};
+
+    std::vector<std::uint16_t> out(values.size());
+    nl::Half::pack(values.data(), values.size(), nl::FP16, out.data());
+    for (std::size_t i = 0; i < fp16.size(); ++i) {
+        EXPECT_EQ(out[i], fp16[i]) << i;
+    }
+    EXPECT_EQ(out.back() & 0x7e00, 0x7e00);
+
+    nl::Half::pack(values.data(), values.size(), nl::BF16, out.data());
+    for (std::size_t i = 0; i < bf16.size(); ++i) {
+        EXPECT_EQ(out[i], bf16[i]) << i;
+    }
+    EXPECT_EQ(out.back() & 0x7fc0, 0x7fc0);
+
+    // every finite half survives the round trip
+    for (nl::Precision p : {nl::FP16, nl::BF16}) {
+        std::vector<std::uint16_t> all;
+        for (std::uint32_t h = 0; h < 0x10000; ++h) {
+            std::uint32_t exponent = p == nl::FP16 ? h & 0x7c00 : h & 0x7f80;
+            if (exponent != (p == nl::FP16 ? 0x7c00u : 0x7f80u))
+                all.push_back(h);
+        }
+        std::vector<float> widened(all.size());
+        std::vector<std::uint16_t> again(all.size());
+        nl::Half::unpack(all.data(), all.size(), p, widened.data());
+        nl::Half::pack(widened.data(), widened.size(), p, again.data());
+        EXPECT_EQ(all, again);
+    }
+}
+
+TEST(HalfTest, Dot) {
+
+    // lengths with and without remainder after vector loop
+    for (nl::index_t n : {5, 64, 77}) {
+        std::vector<float> a(n), w(n);
+        for (nl::index_t i = 0; i < n; ++i) {
+            a[i] = (i % 7) * 0.25f - 0.5f;
+            w[i] = (i % 5) * 0.5f - 1;
+        }
+        for (nl::Precision p : {nl::FP16, nl::BF16}) {
+            std::vector<std::uint16_t> a16(n), w16(n);
+            nl::Half::pack(w.data(), n, p, w16.data());
+            nl::Half::pack(a.data(), n, p, a16.data());
+            float expected = 0;
+            for (nl::index_t i = 0; i < n; ++i) {
+                expected += a[i] * w[i];
+            }
+            // all values are exact in both formats
+            EXPECT_FLOAT_EQ(nl::Half::dot(a.data(), w16.data(), n, p), expected);
+            if (p == nl::BF16) {
+                EXPECT_FLOAT_EQ(nl::Half::dot(a16.data(), w16.data(), n), expected);
+            }
+        }
+    }
+}
+
+TEST(HalfTest, Dense) {
+
+    nl::block_ptr b = std::make_shared<nl::Block>("b", 2, 3, 7);
+    b->data.setRandom();
+    nl::Dense l("l", "tanh", b, 1, 1, 5);
+    nl::block_ptr w = l.inputs()["l_w"];
+    nl::block_ptr out = l.outputs()["l_out"];
+
+    l.forward();
+    Eigen::Tensor<float, 3> expected = out->data;
+    double bytes = l.forward_cost().bytes_read;
+
+    for (nl::Precision p : {nl::FP16, nl::BF16}) {
+        l.setPrecision(p, p);
+        EXPECT_LT(l.forward_cost().bytes_read, bytes);
+        b->setPrecision(p);
+        l.forward();
+        // output is stored in the same precision
+        EXPECT_EQ(out->packed.size(), 5u);
+        for (nl::index_t i = 0; i < 5; ++i) {
+            EXPECT_NEAR(out->data(0,0,i), expected(0,0,i),
+                        p == nl::FP16 ? 0.01 : 0.1);
+        }
+        l.setPrecision(nl::FP32);
+        b->setPrecision(nl::FP32);
+    }
+}
+
+TEST(HalfTest, MasterWeights) {
+
+    nl::block_ptr b = std::make_shared<nl::Block>("b", 1, 1, 1);
+    nl::block_ptr d = std::make_shared<nl::Block>("d", 1, 1, 1);
+    b->data(0,0,0) = 1;
+    d->data(0,0,0) = 1 - std::ldexp(1.0f, -12);
+    nl::Dense l("l", "linear", b, 1, 1, 1);
+    nl::block_ptr w = l.inputs()["l_w"];
+    nl::block_ptr thr = l.inputs()["l_thr"];
+    w->data(0,0,0) = 1;
+    thr->data(0,0,0) = 0;
+    thr->trainable = false;
+    l.setPrecision(nl::BF16);
+    nl::Net net("net");
+    net.add(&l);
+
+    // every step moves the weight by 0.1 * 2^-12, less than half of the
+    // spacing of BF16 below 1, it would be rounded away if the weight
+    // itself was updated
+    nl::Solver solver(net, l.outputs()["l_out"], d);
+    bool moved = false;
+    for (int i = 0; i < 100; ++i) {
+        solver.train();
+        float value;
+        nl::Half::unpack(w->packed.data(), 1, nl::BF16, &value);
+        EXPECT_EQ(w->data(0,0,0), value);
+        moved |= value != 1;
+    }
+    EXPECT_TRUE(moved);
+
+    // weights changed outside the solver replace master weights
+    w->data(0,0,0) = 0.5;
+    w->store();
+    solver.train();
+    EXPECT_LT(w->data(0,0,0), 0.75);
+}
+
+#endif // NEURAL_LIB_HALF_TEST_H
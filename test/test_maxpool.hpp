@@ -97,4 +97,165 @@ TEST(MaxPoolTest, Backward) {
 
 }
 
+TEST(MaxPoolTest, ForwardPadding) {
+
+    // windows at the right and bottom border reach into padding
+    nl::block_ptr b = std::make_shared<nl::Block>("b", 1, 2, 2);
+    b->data(0,0,0) = -1;
+    b->data(0,0,1) = -2;
+    b->data(0,1,0) = -3;
+    b->data(0,1,1) = -4;
+
+    nl::MaxPool p("p", b, 2, 1);
+    nl::block_ptr p_out = p.outputs()["p_out"];
+    p.forward();
+
+    EXPECT_FLOAT_EQ(p_out->data(0,0,0), -1);
+    EXPECT_FLOAT_EQ(p_out->data(0,2,0), -3);
+    EXPECT_FLOAT_EQ(p_out->data(0,0,2), -2);
+    EXPECT_FLOAT_EQ(p_out->data(0,2,2), -4);
+    EXPECT_FLOAT_EQ(p_out->data(0,1,1), -1);
+
+}
+
+TEST(MaxPoolTest, BackwardUsesForwardMaxima) {
+
+    nl::block_ptr b = std::make_shared<nl::Block>("b", 2, 2, 2);
+    b->data.setZero();
+    b->data(0,1,0) = 5;
+    b->data(1,0,1) = 5;
+
+    nl::MaxPool p("p", b, 2);
+    nl::block_ptr p_out = p.outputs()["p_out"];
+    p.forward();
+
+    // gradient goes to maxima found by forward pass even if input
+    // has changed since then
+    b->data.setZero();
+    b->zero_grad();
+    p_out->grad(0,0,0) = 1;
+    p_out->grad(1,0,0) = 2;
+    p.backward();
+
+    EXPECT_FLOAT_EQ(b->grad(0,1,0), 1);
+    EXPECT_FLOAT_EQ(b->grad(1,0,1), 2);
+    EXPECT_FLOAT_EQ(b->grad(0,0,0), 0);
+    EXPECT_FLOAT_EQ(b->grad(1,0,0), 0);
+
+}
+
+TEST(MaxPoolTest, Stride) {
+
+    nl::block_ptr b = std::make_shared<nl::Block>("b", 1, 4, 4);
+    for (nl::index_t y = 0; y < 4; ++y) {
+        for (nl::index_t z = 0; z < 4; ++z) {
+            b->data(0,y,z) = 4 * y + z;
+        }
+    }
+
+    // windows do not cover input symmetrically
+    EXPECT_THROW(nl::MaxPool("p", b, 3, 0, 2), nl::InputException);
+
+    nl::MaxPool p("p", b, 2, 0, 2);
+    nl::block_ptr p_out = p.outputs()["p_out"];
+    EXPECT_EQ(p_out->dimensions()[1], 2);
+    EXPECT_EQ(p_out->dimensions()[2], 2);
+
+    p.forward();
+    EXPECT_FLOAT_EQ(p_out->data(0,0,0), 5);
+    EXPECT_FLOAT_EQ(p_out->data(0,1,0), 13);
+    EXPECT_FLOAT_EQ(p_out->data(0,0,1), 7);
+    EXPECT_FLOAT_EQ(p_out->data(0,1,1), 15);
+
+    b->zero_grad();
+    p_out->grad.setConstant(1);
+    p.backward();
+    EXPECT_FLOAT_EQ(b->grad(0,1,1), 1);
+    EXPECT_FLOAT_EQ(b->grad(0,3,3), 1);
+    EXPECT_FLOAT_EQ(b->grad(0,0,0), 0);
+
+}
+
+TEST(MaxPoolTest, Separable) {
+
+    // few distinct values so that windows contain ties
+    nl::block_ptr b = std::make_shared<nl::Block>("b", 2, 9, 7);
+    for (Eigen::Index i = 0; i < b->data.size(); ++i) {
+        b->data.data()[i] = (i * 7) % 5;
+    }
+
+    nl::index_t window = nl::MaxPool::separable_window + 1;
+    nl::index_t padding = 2;
+    nl::MaxPool p("p", b, window, padding);
+    nl::block_ptr p_out = p.outputs()["p_out"];
+    p.forward();
+    b->zero_grad();
+    p_out->grad.setConstant(1);
+    p.backward();
+
+    // first maximum of each window scanned in order of width and height
+    Eigen::Tensor<float, 3> grad(2, 9, 7);
+    grad.setZero();
+    for (nl::index_t d = 0; d < 2; ++d) {
+        for (nl::index_t w = 0; w < p_out->dimensions()[1]; ++w) {
+            for (nl::index_t h = 0; h < p_out->dimensions()[2]; ++h) {
+                float best = -1;
+                nl::index_t best_y = 0, best_z = 0;
+                for (nl::index_t y = w - padding; y < w - padding + window; ++y) {
+                    for (nl::index_t z = h - padding; z < h - padding + window; ++z) {
+                        if (y < 0 || z < 0 || y >= 9 || z >= 7)
+                            continue;
+                        if (b->data(d,y,z) > best) {
+                            best = b->data(d,y,z);
+                            best_y = y;
+                            best_z = z;
+                        }
+                    }
+                }
+                EXPECT_FLOAT_EQ(p_out->data(d,w,h), best);
+                grad(d,best_y,best_z) += 1;
+            }
+        }
+    }
+    for (Eigen::Index i = 0; i < grad.size(); ++i) {
+        EXPECT_FLOAT_EQ(b->grad.data()[i], grad.data()[i]);
+    }
+
+}
+
+TEST(MaxPoolTest, Specialized) {
+
+    // window and stride of specialized kernels
+    struct Shape { nl::index_t window, stride; };
+    for (Shape s : std::vector<Shape>{{2, 1}, {2, 2}, {3, 1}, {3, 2}, {4, 4}}) {
+        // few distinct values so that windows contain ties
+        nl::block_ptr b = std::make_shared<nl::Block>(
+            "b", 3, s.window + 4 * s.stride, s.window + 3 * s.stride);
+        for (Eigen::Index i = 0; i < b->data.size(); ++i) {
+            b->data.data()[i] = (i * 7) % 5;
+        }
+        nl::MaxPool p("p", b, s.window, 0, s.stride);
+        nl::block_ptr p_out = p.outputs()["p_out"];
+
+        auto pass = [&](bool specialized) {
+            nl::MaxPool::setSpecialized(specialized);
+            p.forward();
+            b->zero_grad();
+            p_out->grad.setConstant(1);
+            p.backward();
+            return std::make_pair(Eigen::Tensor<float, 3>(p_out->data),
+                                  Eigen::Tensor<float, 3>(b->grad));
+        };
+        auto generic = pass(false);
+        auto fixed = pass(true);
+        for (Eigen::Index i = 0; i < generic.first.size(); ++i) {
+            EXPECT_EQ(fixed.first.data()[i], generic.first.data()[i]);
+        }
+        for (Eigen::Index i = 0; i < generic.second.size(); ++i) {
+            EXPECT_EQ(fixed.second.data()[i], generic.second.data()[i]);
+        }
+    }
+
+}
+
 #endif // NEURAL_LIB_MAXPOOL_TEST_H
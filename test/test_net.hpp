@@ -1,9 +1,17 @@
 
+#include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "conv.hpp"
+#include "conv_pool.hpp"
+#include "dense.hpp"
+#include "maxpool.hpp"
 #include "op.hpp"
 #include "neuron.hpp"
 #include "net.hpp"
+#include "replica.hpp"
 
 // add_op exception
 TEST(NetTest, AddOp) {
@@ -82,3 +90,223 @@ TEST(NetTest, Ordering) {
                 ord[1]->name == "n3");
 
 }
+
+// ops wired through blocks they share, whatever the order of adding
+TEST(NetTest, Wiring) {
+
+    const int n = 2000;
+    nl::block_ptr b = std::make_shared<nl::Block>("b", 1, 1, 1);
+    std::vector<std::unique_ptr<nl::Neuron>> chain;
+    chain.emplace_back(new nl::Neuron("n0", "relu", b));
+    for (int i = 1; i < n; ++i) {
+        chain.emplace_back(new nl::Neuron("n" + std::to_string(i), "relu",
+                                          *chain.back()));
+    }
+    // two readers of the first output
+    nl::Neuron side("side", "relu", *chain[0]);
+
+    nl::Net net("net");
+    for (int i = n - 1; i >= 0; --i) {
+        net.add(chain[i].get());
+    }
+    net.add(&side);
+    // adding the same op again changes nothing
+    net.add(chain[0].get());
+
+    std::vector<nl::Op*> ord = net.get_ordering();
+    ASSERT_EQ(ord.size(), (std::size_t) n + 1);
+    std::unordered_map<nl::Op*, std::size_t> position;
+    for (std::size_t i = 0; i < ord.size(); ++i) {
+        position[ord[i]] = i;
+    }
+    for (int i = 1; i < n; ++i) {
+        EXPECT_LT(position[chain[i - 1].get()], position[chain[i].get()]);
+    }
+    EXPECT_LT(position[chain[0].get()], position[&side]);
+
+    // b and weight and threshold of every neuron
+    EXPECT_EQ(net.inputs().size(), 2 * (std::size_t) n + 3);
+    EXPECT_EQ(net.outputs().size(), 2u);
+    EXPECT_NE(net.outputs()["side_out"], nullptr);
+    EXPECT_NE(net.outputs()["n" + std::to_string(n - 1) + "_out"], nullptr);
+}
+
+// op defined outside the library that implements only the passes
+class Scale : public nl::Op {
+public:
+    Scale(std::string name, nl::block_ptr in):
+        nl::Op(name), in(in),
+        out(std::make_shared<nl::Block>(name + "_out", 1, 1, 1)) {}
+    void forward() { out->data = 2 * in->data; }
+    void backward() { in->grad += 2 * out->grad; }
+    nl::block_map inputs() { return {{in->name, in}}; }
+    nl::block_map outputs() { return {{out->name, out}}; }
+private:
+    nl::block_ptr in, out;
+};
+
+// ops without their own share() accept blocks they do not use
+TEST(NetTest, ShareDefault) {
+
+    nl::block_ptr in = std::make_shared<nl::Block>("in", 1, 1, 1);
+    Scale scale("scale", in);
+    nl::Neuron n("n", "linear", scale.outputs()["scale_out"]);
+    nl::Net net("net");
+    net.add(&scale);
+    net.add(&n);
+
+    nl::block_ptr w = std::make_shared<nl::Block>("n_scale_out_w", 1, 1, 1);
+    net.share({{"n_scale_out_w", w}});
+    EXPECT_EQ(n.inputs()["n_scale_out_w"], w);
+
+    nl::block_ptr other = std::make_shared<nl::Block>("in", 1, 1, 1);
+    EXPECT_THROW(scale.share({{"in", other}}), nl::UnsupportedException);
+}
+
+TEST(NetTest, Cost) {
+
+    nl::block_ptr in = std::make_shared<nl::Block>("in", 1, 1, 3);
+    nl::Dense d1("d1", "relu", in, 1, 1, 2);
+    nl::Dense d2("d2", "linear", d1, 1, 1, 1);
+    nl::Net net("net");
+    net.add(&d1);
+    net.add(&d2);
+
+    // weighted sums with thresholds and transfer functions
+    EXPECT_DOUBLE_EQ(d1.forward_cost().flops, 2 * 6 + 2 * 2);
+    EXPECT_DOUBLE_EQ(d1.backward_cost().flops, 4 * 6 + 3 * 2);
+
+    // net sums cost of its ops
+    nl::Cost f = net.forward_cost();
+    nl::Cost b = net.backward_cost();
+    EXPECT_DOUBLE_EQ(f.flops, 16 + 2 * 2 + 2);
+    EXPECT_DOUBLE_EQ(b.flops, 30 + 4 * 2 + 3);
+    EXPECT_DOUBLE_EQ(f.bytes_read, 
+                     d1.forward_cost().bytes_read + d2.forward_cost().bytes_read);
+    EXPECT_DOUBLE_EQ(f.intensity(), f.flops / f.bytes());
+}
+
+TEST(NetTest, FuseConvMaxPool) {
+
+    nl::block_ptr in = std::make_shared<nl::Block>("in", 2, 6, 5);
+    in->data.setRandom();
+    nl::Conv c("c", "tanh", in, 3, 3, 1);
+    nl::MaxPool p("p", c, 2);
+    nl::Dense d("d", "linear", p, 1, 1, 2);
+    nl::block_ptr out = d.outputs()["d_out"];
+
+    auto pass = [&](nl::Net & net) {
+        for (auto & block_pair : net.blocks) {
+            block_pair.second->grad.setZero();
+        }
+        net.forward();
+        out->grad.setConstant(1);
+        net.backward();
+    };
+    auto expect_near = [](const Eigen::Tensor<float, 3> & a,
+                          const Eigen::Tensor<float, 3> & b) {
+        ASSERT_EQ(a.size(), b.size());
+        for (Eigen::Index i = 0; i < a.size(); ++i) {
+            EXPECT_NEAR(a.data()[i], b.data()[i], 1e-5);
+        }
+    };
+
+    nl::Net net("net");
+    net.add(&c);
+    net.add(&p);
+    net.add(&d);
+    pass(net);
+    Eigen::Tensor<float, 3> output = out->data;
+    Eigen::Tensor<float, 3> input_grad = in->grad;
+    Eigen::Tensor<float, 3> kernel_grad = c.inputs()["c_w1"]->grad;
+    Eigen::Tensor<float, 3> threshold_grad = c.inputs()["c_thr2"]->grad;
+
+    nl::Net fused("fused");
+    fused.add(&c);
+    fused.add(&p);
+    fused.add(&d);
+    EXPECT_EQ(fused.fuse(), 1);
+    EXPECT_EQ(fused.fuse(), 0);
+    EXPECT_EQ(fused.ops.size(), 2);
+    EXPECT_EQ(fused.blocks.count("c_out"), 0);
+    EXPECT_NE(fused.ops["c+p"], nullptr);
+
+    // same result and gradient without the intermediate block
+    pass(fused);
+    expect_near(out->data, output);
+    expect_near(in->grad, input_grad);
+    expect_near(c.inputs()["c_w1"]->grad, kernel_grad);
+    expect_near(c.inputs()["c_thr2"]->grad, threshold_grad);
+
+    // fused net can be copied
+    nl::Replica replica(fused);
+    replica.net().forward();
+    expect_near(replica.net().blocks["d_out"]->data, output);
+
+    // intermediate block is not counted
+    EXPECT_LT(fused.forward_cost().bytes(), net.forward_cost().bytes());
+    EXPECT_DOUBLE_EQ(fused.forward_cost().flops, net.forward_cost().flops);
+}
+
+// fused convolution computed by lowered windows in several tiles per
+// group, and window by window with and without code for the shape
+TEST(NetTest, FuseConvMaxPoolKernels) {
+
+    std::vector<std::pair<std::string, bool>> kernels = {
+        {"auto", true}, {"direct", true}, {"direct", false}
+    };
+    for (auto & kernel : kernels) {
+        std::string algorithm = kernel.first;
+        nl::Conv::setSpecialized(kernel.second);
+        nl::block_ptr in = std::make_shared<nl::Block>("in", 4, 34, 34);
+        in->data.setRandom();
+        nl::Conv c("c", "relu", in, 32, 3, 1, 1, 2);
+        c.setAlgorithm(algorithm);
+        nl::MaxPool p("p", c, 2, 0, 2);
+        nl::block_ptr out = p.outputs()["p_out"];
+        out->grad.setRandom();
+        Eigen::Tensor<float, 3> out_grad = out->grad;
+
+        nl::Net net("net");
+        net.add(&c);
+        net.add(&p);
+        net.forward();
+        net.backward();
+        Eigen::Tensor<float, 3> output = out->data;
+        Eigen::Tensor<float, 3> input_grad = in->grad;
+        std::vector<Eigen::Tensor<float, 3>> kernel_grads;
+        for (int d : {0, 13, 31}) {
+            kernel_grads.push_back(c.inputs()["c_w" + std::to_string(d)]->grad);
+        }
+        float threshold_grad = c.inputs()["c_thr17"]->grad(0,0,0);
+
+        for (auto & block_pair : net.blocks) {
+            block_pair.second->grad.setZero();
+        }
+        out->grad = out_grad;
+        nl::Net fused("fused");
+        fused.add(&c);
+        fused.add(&p);
+        EXPECT_EQ(fused.fuse(), 1);
+        fused.forward();
+        fused.backward();
+
+        for (Eigen::Index i = 0; i < output.size(); ++i) {
+            EXPECT_NEAR(out->data.data()[i], output.data()[i], 1e-5);
+        }
+        for (Eigen::Index i = 0; i < input_grad.size(); ++i) {
+            EXPECT_NEAR(in->grad.data()[i], input_grad.data()[i], 1e-4);
+        }
+        std::size_t k = 0;
+        for (int d : {0, 13, 31}) {
+            const Eigen::Tensor<float, 3> & grad =
+                c.inputs()["c_w" + std::to_string(d)]->grad;
+            for (Eigen::Index i = 0; i < grad.size(); ++i) {
+                EXPECT_NEAR(grad.data()[i], kernel_grads[k].data()[i], 1e-3);
+            }
+            ++k;
+        }
+        EXPECT_NEAR(c.inputs()["c_thr17"]->grad(0,0,0), threshold_grad, 1e-3);
+    }
+    nl::Conv::setSpecialized(true);
+}
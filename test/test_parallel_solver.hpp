@@ -0,0 +1,148 @@
+#ifndef NEURAL_LIB_PARALLEL_SOLVER_TEST_H
+#define NEURAL_LIB_PARALLEL_SOLVER_TEST_H
+
+#include "dense.hpp"
+#include "net.hpp"
+#include "neuron.hpp"
+#include "parallel_solver.hpp"
+#include "reader.hpp"
+#include "replica.hpp"
+#include "solver.hpp"
+
+TEST(ReplicaTest, Copy) {
+
+    nl::block_ptr b = std::make_shared<nl::Block>("b", 1, 1, 1);
+    nl::Neuron n1("n1", "linear", b);
+    nl::Neuron n2("n2", "relu", n1);
+    n1.inputs()["n1_thr"]->data(0,0,0) = 1;
+    n1.inputs()["n1_b_w"]->data(0,0,0) = 3;
+    n2.inputs()["n2_thr"]->data(0,0,0) = 0;
+    n2.inputs()["n2_n1_out_w"]->data(0,0,0) = 1;
+
+    nl::Net net("net");
+    net.add(&n1);
+    net.add(&n2);
+
+    nl::Replica r(net);
+    nl::Net & copy = r.net();
+
+    // same structure, different blocks
+    EXPECT_EQ(copy.name, "net");
+    EXPECT_EQ(copy.ops.size(), 2);
+    EXPECT_EQ(copy.blocks.size(), net.blocks.size());
+    EXPECT_NE(copy.blocks["n1_b_w"], net.blocks["n1_b_w"]);
+    EXPECT_FLOAT_EQ(copy.blocks["n1_b_w"]->data(0,0,0), 3);
+
+    // copies compute independently
+    copy.blocks["b"]->data(0,0,0) = 2;
+    b->data(0,0,0) = -100;
+    copy.forward();
+    net.forward();
+    EXPECT_FLOAT_EQ(copy.blocks["n2_out"]->data(0,0,0), 7);
+    EXPECT_FLOAT_EQ(net.blocks["n2_out"]->data(0,0,0), 0);
+}
+
+TEST(ReplicaTest, SharedTrainable) {
+
+    nl::block_ptr b = std::make_shared<nl::Block>("b", 1, 1, 2);
+    nl::Dense d("d", "linear", b, 1, 1, 1);
+    nl::Net net("net");
+    net.add(&d);
+
+    nl::Replica r(net, true);
+    nl::Net & copy = r.net();
+
+    // weights are shared, blocks passed through net are not
+    EXPECT_EQ(copy.blocks["d_w"], net.blocks["d_w"]);
+    EXPECT_EQ(copy.blocks["d_thr"], net.blocks["d_thr"]);
+    EXPECT_NE(copy.blocks["b"], net.blocks["b"]);
+    EXPECT_NE(copy.blocks["d_out"], net.blocks["d_out"]);
+
+    // copy uses weights of original network
+    net.blocks["d_w"]->data(0,0,0) = 2;
+    net.blocks["d_w"]->data(0,0,1) = 3;
+    net.blocks["d_thr"]->data(0,0,0) = 1;
+    copy.blocks["b"]->data(0,0,0) = 1;
+    copy.blocks["b"]->data(0,0,1) = -1;
+    copy.forward();
+    EXPECT_FLOAT_EQ(copy.blocks["d_out"]->data(0,0,0), 0);
+
+    // shared block must have the same dimensions
+    nl::block_map wrong = {{"d_w", std::make_shared<nl::Block>("d_w", 1, 1, 1)}};
+    EXPECT_THROW(copy.share(wrong), nl::DimensionException);
+}
+
+TEST(ReaderTest, Shard) {
+
+    nl::CsvReader r("reader", "test/csv/valid.csv");
+    nl::block_ptr out = r.outputs()["reader_out"];
+
+    // index must lie in [0, count), count must be positive
+    EXPECT_THROW(r.shard(2, 2), nl::InputException);
+    EXPECT_THROW(r.shard(-1, 2), nl::InputException);
+    EXPECT_THROW(r.shard(-1, 0), nl::InputException);
+    EXPECT_THROW(r.shard(0, 0), nl::InputException);
+
+    // every other line starting with the second one
+    r.shard(1, 2);
+    r.forward();
+    EXPECT_FLOAT_EQ(out->data(0,0,1), -6);
+    r.forward();
+    EXPECT_FLOAT_EQ(out->data(0,0,1), -6);
+
+    // every other line starting with the first one
+    r.shard(0, 2);
+    r.forward();
+    EXPECT_FLOAT_EQ(out->data(0,0,1), 2.3);
+    r.forward();
+    EXPECT_FLOAT_EQ(out->data(0,0,1), -1.23e-1);
+    r.forward();
+    EXPECT_FLOAT_EQ(out->data(0,0,1), 2.3);
+
+    // shard with no line in file
+    r.shard(4, 5);
+    EXPECT_THROW(r.forward(), nl::InputException);
+}
+
+TEST(ParallelSolverTest, MatchesSerialTraining) {
+
+    // desired output is always zero
+    nl::block_ptr d = std::make_shared<nl::Block>("d", 1, 1, 1);
+    d->data(0,0,0) = 0;
+
+    // serially trained network
+    nl::CsvReader r1("reader", "xor_values.csv");
+    nl::Dense l1("l", "tanh", r1, 1, 1, 1);
+    nl::Net net1("net");
+    net1.add(&r1);
+    net1.add(&l1);
+
+    // network trained on two threads, with the same initial weights
+    nl::CsvReader r2("reader", "xor_values.csv");
+    nl::Dense l2("l", "tanh", r2, 1, 1, 1);
+    l2.inputs()["l_w"]->data = l1.inputs()["l_w"]->data;
+    l2.inputs()["l_thr"]->data = l1.inputs()["l_thr"]->data;
+    nl::Net net2("net");
+    net2.add(&r2);
+    net2.add(&l2);
+
+    // each update uses all four lines of the file
+    nl::Solver s1(net1, l1.outputs()["l_out"], d);
+    s1.setBatchSize(4);
+    nl::ParallelSolver s2(net2, l2.outputs()["l_out"], d, 2);
+    s2.setBatchSize(2);
+
+    s1.train(5);
+    s2.train(5);
+
+    for (int i = 0; i < 3; ++i)
+        EXPECT_NEAR(l1.inputs()["l_w"]->data(0,0,i),
+                    l2.inputs()["l_w"]->data(0,0,i), 1e-5);
+    EXPECT_NEAR(l1.inputs()["l_thr"]->data(0,0,0),
+                l2.inputs()["l_thr"]->data(0,0,0), 1e-5);
+
+    EXPECT_THROW(nl::ParallelSolver(net2, l2.outputs()["l_out"], d, 0),
+                 nl::InputException);
+}
+
+#endif // NEURAL_LIB_PARALLEL_SOLVER_TEST_H
@@ -0,0 +1,81 @@
+#ifndef NEURAL_LIB_PROFILER_TEST_H
+#define NEURAL_LIB_PROFILER_TEST_H
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "dense.hpp"
+#include "net.hpp"
+#include "profiler.hpp"
+#include "solver.hpp"
+
+TEST(ProfilerTest, Disabled) {
+
+    nl::Profiler::reset();
+
+    nl::block_ptr b = std::make_shared<nl::Block>("b", 1, 1, 2);
+    nl::Dense l("l", "linear", b, 1, 1, 1);
+    nl::Net net("net");
+    net.add(&l);
+    net.forward();
+
+    EXPECT_TRUE(nl::Profiler::stats().empty());
+}
+
+TEST(ProfilerTest, OpsAndSolverPhases) {
+
+    nl::block_ptr b = std::make_shared<nl::Block>("b", 1, 1, 2);
+    nl::block_ptr d = std::make_shared<nl::Block>("d", 1, 1, 1);
+    nl::Dense l1("l1", "tanh", b, 1, 1, 3);
+    nl::Dense l2("l2", "linear", l1, 1, 1, 1);
+    nl::Net net("net");
+    net.add(&l1);
+    net.add(&l2);
+    nl::Solver solver(net, l2.outputs()["l2_out"], d);
+
+    nl::Profiler::reset();
+    nl::Profiler::enable();
+    solver.train(4);
+    nl::Profiler::disable();
+
+    typedef std::pair<std::string, std::string> key;
+    auto stats = nl::Profiler::stats();
+    EXPECT_EQ(stats[key("l1", "forward")].calls, 4);
+    EXPECT_EQ(stats[key("l2", "backward")].calls, 4);
+    EXPECT_EQ(stats[key("net", "zero_grad")].calls, 4);
+    EXPECT_EQ(stats[key("net", "loss")].calls, 4);
+    EXPECT_EQ(stats[key("net", "update")].calls, 4);
+
+    // l1 reads input (2), weights (6) and thresholds (3), writes output (3)
+    EXPECT_EQ(stats[key("l1", "forward")].cost.bytes(), 4 * 14 * sizeof(float));
+    EXPECT_EQ(stats[key("l1", "forward")].cost.flops, 4 * 18);
+
+    // nothing is recorded while disabled
+    solver.train();
+    EXPECT_EQ(nl::Profiler::stats()[key("l1", "forward")].calls, 4);
+
+    std::stringstream summary;
+    nl::Profiler::summary(summary);
+    EXPECT_NE(summary.str().find("l1"), std::string::npos);
+    EXPECT_NE(summary.str().find("zero_grad"), std::string::npos);
+
+    // one complete event for each measurement
+    std::string file = "test/profiler_trace_test.json";
+    nl::Profiler::write_trace(file);
+    std::ifstream f(file);
+    std::string trace((std::istreambuf_iterator<char>(f)),
+                      std::istreambuf_iterator<char>());
+    std::remove(file.c_str());
+
+    EXPECT_EQ(trace.find("{\"traceEvents\":["), 0);
+    std::size_t events = 0;
+    for (std::size_t pos = trace.find("\"ph\":\"X\""); pos != std::string::npos;
+         pos = trace.find("\"ph\":\"X\"", pos + 1))
+        events++;
+    EXPECT_EQ(events, 4 * 7);
+
+    nl::Profiler::reset();
+}
+
+#endif // NEURAL_LIB_PROFILER_TEST_H
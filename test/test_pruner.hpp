@@ -0,0 +1,128 @@
+#ifndef NEURAL_LIB_PRUNER_TEST_H
+#define NEURAL_LIB_PRUNER_TEST_H
+
+#include <cmath>
+#include <vector>
+
+#include "csr.hpp"
+#include "dense.hpp"
+#include "net.hpp"
+#include "pruner.hpp"
+#include "solver.hpp"
+
+TEST(CsrTest, Products) {
+
+    // 3x4 matrix with an empty row
+    std::vector<float> m = {0, 2, 0, -1,
+                            0, 0, 0, 0,
+                            3, 0, 0.5f, 0};
+    nl::Csr csr(m.data(), 3, 4);
+    EXPECT_EQ(csr.rows(), 3);
+    EXPECT_EQ(csr.columns(), 4);
+    EXPECT_EQ(csr.nonzeros(), 4);
+
+    std::vector<float> x = {1, 2, 3, 4};
+    std::vector<float> y(3, 7);
+    csr.multiply(x.data(), y.data());
+    EXPECT_FLOAT_EQ(y[0], 0);
+    EXPECT_FLOAT_EQ(y[1], 0);
+    EXPECT_FLOAT_EQ(y[2], 4.5);
+
+    std::vector<float> g = {1, 5, -2};
+    std::vector<float> t(4, 1);
+    csr.multiply_transposed_add(g.data(), t.data());
+    EXPECT_FLOAT_EQ(t[0], -5);
+    EXPECT_FLOAT_EQ(t[1], 3);
+    EXPECT_FLOAT_EQ(t[2], 0);
+    EXPECT_FLOAT_EQ(t[3], 0);
+
+    // only stored positions change
+    std::vector<float> grad(12, 0);
+    csr.outer_add(g.data(), x.data(), grad.data());
+    EXPECT_FLOAT_EQ(grad[1], 2);
+    EXPECT_FLOAT_EQ(grad[3], 4);
+    EXPECT_FLOAT_EQ(grad[8], -2);
+    EXPECT_FLOAT_EQ(grad[10], -6);
+    EXPECT_FLOAT_EQ(grad[0], 0);
+    EXPECT_FLOAT_EQ(grad[5], 0);
+}
+
+TEST(PrunerTest, SparseDense) {
+
+    nl::block_ptr b = std::make_shared<nl::Block>("b", 2, 3, 4);
+    b->data.setRandom();
+    nl::Dense l("l", "tanh", b, 1, 2, 5);
+    nl::block_ptr w = l.inputs()["l_w"];
+    nl::block_ptr out = l.outputs()["l_out"];
+    out->grad.setRandom();
+
+    nl::Net net("net");
+    net.add(&l);
+    nl::Pruner pruner(net);
+    EXPECT_EQ(pruner.keep(24), 216u);
+    EXPECT_EQ(pruner.prune(0), 0u);
+
+    // dense kernels compute the same as sparse ones
+    Eigen::Tensor<float, 3> result[2][3];
+    for (float crossover : {0.0f, 1.0f}) {
+        l.setCrossover(crossover);
+        w->grad.setZero();
+        b->grad.setZero();
+        l.forward();
+        l.backward();
+        result[crossover > 0][0] = out->data;
+        result[crossover > 0][1] = b->grad;
+        result[crossover > 0][2] = w->grad;
+    }
+    EXPECT_LT(l.forward_cost().bytes_read, 240 * sizeof(float));
+    for (int i = 0; i < 3; ++i) {
+        for (nl::index_t j = 0; j < result[0][i].size(); ++j) {
+            EXPECT_NEAR(result[0][i].data()[j], result[1][i].data()[j], 1e-5);
+        }
+    }
+
+    // pruned weights have no gradient
+    for (nl::index_t i = 0; i < w->data.size(); ++i) {
+        if (w->data.data()[i] == 0) {
+            EXPECT_EQ(w->grad.data()[i], 0);
+        }
+    }
+}
+
+TEST(PrunerTest, Training) {
+
+    nl::block_ptr b = std::make_shared<nl::Block>("b", 1, 1, 8);
+    nl::block_ptr d = std::make_shared<nl::Block>("d", 1, 1, 4);
+    b->data.setRandom();
+    d->data.setRandom();
+    nl::Dense l("l", "linear", b, 1, 1, 4);
+    nl::block_ptr w = l.inputs()["l_w"];
+    nl::Net net("net");
+    net.add(&l);
+
+    // magnitudes 1..32, ties at the boundary
+    for (nl::index_t i = 0; i < 32; ++i) {
+        w->data.data()[i] = (i % 2 ? 1 : -1) * (i / 2 + 1) * 0.01f;
+    }
+    w->store();
+    nl::Pruner pruner(net);
+    EXPECT_EQ(pruner.keep(5), 27u);
+    std::vector<bool> zero(32);
+    int kept = 0;
+    for (nl::index_t i = 0; i < 32; ++i) {
+        zero[i] = w->data.data()[i] == 0;
+        kept += !zero[i];
+        if (!zero[i]) {
+            EXPECT_GE(std::abs(w->data.data()[i]), 0.14f);
+        }
+    }
+    EXPECT_EQ(kept, 5);
+
+    nl::Solver solver(net, l.outputs()["l_out"], d);
+    solver.train(20);
+    for (nl::index_t i = 0; i < 32; ++i) {
+        EXPECT_EQ(w->data.data()[i] == 0, zero[i]);
+    }
+}
+
+#endif // NEURAL_LIB_PRUNER_TEST_H
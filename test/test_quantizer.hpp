@@ -0,0 +1,95 @@
+#ifndef NEURAL_LIB_QUANTIZER_TEST_H
+#define NEURAL_LIB_QUANTIZER_TEST_H
+
+#include <cstdint>
+#include <vector>
+
+#include "conv.hpp"
+#include "dense.hpp"
+#include "int8.hpp"
+#include "net.hpp"
+#include "quantized_conv.hpp"
+#include "quantized_dense.hpp"
+#include "quantizer.hpp"
+
+TEST(Int8Test, Dot) {
+
+    // lengths with and without remainder after vector loop
+    for (nl::index_t n : {5, 64, 77}) {
+        std::vector<std::uint8_t> a(n);
+        std::vector<std::int8_t> w(n);
+        std::int32_t expected = 0;
+        for (nl::index_t i = 0; i < n; ++i) {
+            a[i] = (i * 37) % 256;
+            w[i] = (i * 11) % (2 * nl::Int8::weight_max + 1) - nl::Int8::weight_max;
+            expected += a[i] * w[i];
+        }
+        EXPECT_EQ(nl::Int8::dot(a.data(), w.data(), n), expected);
+    }
+}
+
+TEST(Int8Test, Quantize) {
+
+    std::vector<float> values = {0, 0.5f, -1, 2, -3};
+    std::vector<std::uint8_t> q(values.size());
+    nl::Int8::quantize(values.data(), values.size(), 0.5f, q.data());
+    EXPECT_EQ(q[0], 128);
+    EXPECT_EQ(q[1], 129);
+    EXPECT_EQ(q[2], 126);
+    EXPECT_EQ(q[3], 132);
+    EXPECT_EQ(q[4], 122);
+
+    // out of range values are clamped
+    nl::Int8::quantize(values.data(), values.size(), 0.01f, q.data());
+    EXPECT_EQ(q[3], 255);
+    EXPECT_EQ(q[4], 1);
+
+    std::vector<std::int8_t> w(values.size());
+    float scale = nl::Int8::quantize_weights(values.data(), values.size(), w.data());
+    EXPECT_FLOAT_EQ(scale, 3.0f / nl::Int8::weight_max);
+    EXPECT_EQ(w[4], -nl::Int8::weight_max);
+    EXPECT_EQ(w[3], 42);
+}
+
+TEST(QuantizerTest, Net) {
+
+    nl::block_ptr b = std::make_shared<nl::Block>("b", 3, 6, 5);
+    b->data.setRandom();
+    nl::Conv c("c", "relu", b, 4, 3, 1, 1);
+    nl::Dense d("d", "tanh", c, 1, 1, 7);
+    nl::Net net("net");
+    net.add(&c);
+    net.add(&d);
+
+    net.forward();
+    nl::block_ptr out = d.outputs()["d_out"];
+    Eigen::Tensor<float, 3> expected = out->data;
+    Eigen::Tensor<float, 0> input_max = b->data.abs().maximum();
+    Eigen::Tensor<float, 0> conv_max = c.outputs()["c_out"]->data.maximum();
+
+    nl::Quantizer q(net);
+    q.calibrate();
+    EXPECT_FLOAT_EQ(q.range("c"), input_max());
+    EXPECT_FLOAT_EQ(q.range("d"), conv_max());
+    EXPECT_EQ(q.quantize(), 2u);
+
+    // same blocks, computed by quantized ops
+    EXPECT_EQ(net.ops.size(), 2u);
+    EXPECT_NE(dynamic_cast<nl::QuantizedConv*>(net.ops["c"]), nullptr);
+    EXPECT_NE(dynamic_cast<nl::QuantizedDense*>(net.ops["d"]), nullptr);
+    EXPECT_EQ(net.outputs().begin()->second, out);
+
+    // weights are random, errors of 120 rounded products seldom add up
+    // to more than a few percent of the range
+    out->data.setZero();
+    net.forward();
+    Eigen::Tensor<float, 0> error = (out->data - expected).abs().mean();
+    EXPECT_LT(error(), 0.1);
+    for (nl::index_t i = 0; i < out->data.size(); ++i) {
+        EXPECT_NEAR(out->data.data()[i], expected.data()[i], 0.5);
+    }
+
+    EXPECT_THROW(net.backward(), nl::UnsupportedException);
+}
+
+#endif // NEURAL_LIB_QUANTIZER_TEST_H
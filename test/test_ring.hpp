@@ -0,0 +1,223 @@
+#ifndef NEURAL_LIB_RING_TEST_H
+#define NEURAL_LIB_RING_TEST_H
+
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "dense.hpp"
+#include "net.hpp"
+#include "reader.hpp"
+#include "ring.hpp"
+#include "solver.hpp"
+
+// Run function in 'count' - 1 child processes with ranks 1, 2, ...
+// and in the calling process with rank 0. Children report success
+// through their exit code.
+bool run_ranks(uint16_t count, std::function<bool(uint16_t)> f) {
+
+    std::vector<pid_t> children;
+    for (uint16_t rank = 1; rank < count; ++rank) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            bool ok = false;
+            try {
+                ok = f(rank);
+            } catch (...) {}
+            _exit(ok ? 0 : 1);
+        }
+        children.push_back(pid);
+    }
+
+    bool ok = f(0);
+    for (pid_t pid : children) {
+        int status;
+        waitpid(pid, &status, 0);
+        ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+    return ok;
+}
+
+std::string ring_path() {
+    return "/tmp/nl_ring_test_" + std::to_string(getpid());
+}
+
+// Bind a socket to 'port' of the loopback interface, port zero picks
+// a free ephemeral one. Return the socket or -1.
+int bind_loopback(uint16_t & port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    socklen_t length = sizeof(addr);
+    if (fd >= 0 &&
+        (bind(fd, (sockaddr*) &addr, sizeof(addr)) < 0 ||
+         getsockname(fd, (sockaddr*) &addr, &length) < 0)) {
+        close(fd);
+        fd = -1;
+    }
+    port = ntohs(addr.sin_port);
+    return fd;
+}
+
+// First of 'count' consecutive free ports, ranks of a TCP ring listen
+// on them.
+uint16_t ring_port(uint16_t count) {
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        uint16_t first = 0;
+        std::vector<int> fds = {bind_loopback(first)};
+        for (uint16_t i = 1; i < count && fds.back() >= 0; ++i) {
+            uint16_t port = first + i;
+            fds.push_back(port > first ? bind_loopback(port) : -1);
+        }
+        bool free = fds.back() >= 0;
+        for (int fd : fds) {
+            if (fd >= 0)
+                close(fd);
+        }
+        if (free)
+            return first;
+    }
+    throw std::runtime_error("no free ports");
+}
+
+typedef std::function<std::unique_ptr<nl::Ring>(uint16_t, uint16_t)> RingFactory;
+
+// rings of processes on this machine connected by Unix sockets
+RingFactory unix_rings() {
+    std::string path = ring_path();
+    return [path](uint16_t rank, uint16_t size) {
+        return std::unique_ptr<nl::Ring>(new nl::Ring(rank, size, path));
+    };
+}
+
+// rings connected by TCP over the loopback interface
+RingFactory tcp_rings(uint16_t size) {
+    uint16_t port = ring_port(size);
+    return [port](uint16_t rank, uint16_t size) {
+        std::vector<std::string> hosts(size, "127.0.0.1");
+        return std::unique_ptr<nl::Ring>(new nl::Ring(rank, hosts, port));
+    };
+}
+
+void expect_all_reduce(RingFactory rings) {
+
+    // rank r contributes r + i to i-th value, buffer size
+    // is not divisible by the number of ranks
+    EXPECT_TRUE(run_ranks(3, [&](uint16_t rank) {
+        std::unique_ptr<nl::Ring> ring = rings(rank, 3);
+        std::vector<float> data(1000);
+        for (std::size_t i = 0; i < data.size(); ++i) {
+            data[i] = rank + i;
+        }
+        ring->all_reduce(data.data(), data.size());
+
+        bool ok = true;
+        for (std::size_t i = 0; i < data.size(); ++i) {
+            ok = ok && data[i] == 3 + 3 * i;
+        }
+        return ok;
+    }));
+}
+
+TEST(RingTest, AllReduce) {
+    expect_all_reduce(unix_rings());
+}
+
+TEST(RingTest, AllReduceTcp) {
+    expect_all_reduce(tcp_rings(3));
+}
+
+TEST(RingTest, Broadcast) {
+
+    std::string path = ring_path();
+
+    EXPECT_TRUE(run_ranks(3, [&](uint16_t rank) {
+        nl::Ring ring(rank, 3, path);
+        std::vector<float> data(10, rank);
+        ring.broadcast(data.data(), data.size());
+
+        bool ok = true;
+        for (float x : data) {
+            ok = ok && x == 0;
+        }
+        return ok;
+    }));
+
+    // single process does not communicate at all
+    nl::Ring single(0, 1, path);
+    float x = 1;
+    single.all_reduce(&x, 1);
+    EXPECT_FLOAT_EQ(x, 1);
+
+    EXPECT_THROW(nl::Ring(1, 1, path), nl::InputException);
+}
+
+void expect_distributed_matches_serial(RingFactory rings) {
+
+    // desired output is always zero
+    nl::block_ptr d = std::make_shared<nl::Block>("d", 1, 1, 1);
+    d->data(0,0,0) = 0;
+
+    // serially trained network, each update uses all four lines of file
+    nl::CsvReader r1("reader", "xor_values.csv");
+    nl::Dense l1("l", "tanh", r1, 1, 1, 1);
+    nl::Net net1("net");
+    net1.add(&r1);
+    net1.add(&l1);
+    nl::Solver s1(net1, l1.outputs()["l_out"], d);
+    s1.setBatchSize(4);
+
+    // network trained by two processes, each with two lines per update,
+    // starts from weights of rank 0
+    nl::CsvReader r2("reader", "xor_values.csv");
+    nl::Dense l2("l", "tanh", r2, 1, 1, 1);
+    l2.inputs()["l_w"]->data = l1.inputs()["l_w"]->data;
+    l2.inputs()["l_thr"]->data = l1.inputs()["l_thr"]->data;
+    nl::Net net2("net");
+    net2.add(&r2);
+    net2.add(&l2);
+
+    s1.train(5);
+
+    EXPECT_TRUE(run_ranks(2, [&](uint16_t rank) {
+        if (rank != 0) {
+            l2.inputs()["l_w"]->data.setRandom();
+            l2.inputs()["l_thr"]->data.setRandom();
+        }
+
+        std::unique_ptr<nl::Ring> ring = rings(rank, 2);
+        nl::Solver s2(net2, l2.outputs()["l_out"], d);
+        s2.setDistributed(*ring);
+        s2.setBatchSize(2);
+        s2.train(5);
+
+        bool ok = true;
+        for (int i = 0; i < 3; ++i)
+            ok = ok && std::abs(l1.inputs()["l_w"]->data(0,0,i) -
+                                l2.inputs()["l_w"]->data(0,0,i)) < 1e-5;
+        ok = ok && std::abs(l1.inputs()["l_thr"]->data(0,0,0) -
+                            l2.inputs()["l_thr"]->data(0,0,0)) < 1e-5;
+        return ok;
+    }));
+}
+
+TEST(RingTest, DistributedMatchesSerial) {
+    expect_distributed_matches_serial(unix_rings());
+}
+
+TEST(RingTest, DistributedMatchesSerialTcp) {
+    expect_distributed_matches_serial(tcp_rings(2));
+}
+
+#endif // NEURAL_LIB_RING_TEST_H
@@ -1,2 +1,171 @@
+#ifndef NEURAL_LIB_SOLVER_TEST_H
+#define NEURAL_LIB_SOLVER_TEST_H
 
+#include "dense.hpp"
+#include "net.hpp"
+#include "reader.hpp"
 #include "solver.hpp"
+
+TEST(SolverTest, BatchSize) {
+
+    nl::block_ptr b = std::make_shared<nl::Block>("b", 1, 1, 1);
+    nl::block_ptr d = std::make_shared<nl::Block>("d", 1, 1, 1);
+    nl::Dense l("l", "linear", b, 1, 1, 1);
+    nl::Net net("net");
+    net.add(&l);
+
+    nl::Solver solver(net, l.outputs()["l_out"], d);
+
+    // empty batch is not allowed
+    EXPECT_THROW(solver.setBatchSize(0), nl::InputException);
+    EXPECT_NO_THROW(solver.setBatchSize(4));
+}
+
+TEST(SolverTest, GradientAccumulation) {
+
+    // every line of the file is a single sample (x, y, z)
+    nl::CsvReader r("reader", "xor_values.csv");
+    nl::Dense l("l", "linear", r, 1, 1, 1);
+    nl::block_ptr w = l.inputs()["l_w"];
+    nl::block_ptr thr = l.inputs()["l_thr"];
+    nl::block_ptr out = l.outputs()["l_out"];
+
+    // desired output is always zero
+    nl::block_ptr d = std::make_shared<nl::Block>("d", 1, 1, 1);
+    d->data(0,0,0) = 0;
+
+    w->data(0,0,0) = 0.5;
+    w->data(0,0,1) = -0.25;
+    w->data(0,0,2) = 1;
+    thr->data(0,0,0) = 0.1;
+
+    nl::Net net("net");
+    net.add(&r);
+    net.add(&l);
+
+    // expected mean gradient over all four lines
+    float samples[4][3] = {{0,0,0}, {0,1,1}, {1,0,0}, {1,1,1}};
+    float grad_w[3] = {0,0,0};
+    float grad_thr = 0;
+    for (auto & s : samples) {
+        float o = thr->data(0,0,0);
+        for (int i = 0; i < 3; ++i)
+            o += w->data(0,0,i) * s[i];
+        for (int i = 0; i < 3; ++i)
+            grad_w[i] += o * s[i];
+        grad_thr += o;
+    }
+    float expected_w[3];
+    for (int i = 0; i < 3; ++i)
+        expected_w[i] = w->data(0,0,i) - 0.1 * grad_w[i] / 4;
+    float expected_thr = thr->data(0,0,0) - 0.1 * grad_thr / 4;
+
+    // single update from four samples, default learning rate is 0.1
+    nl::Solver solver(net, out, d);
+    solver.setBatchSize(4);
+    solver.train();
+
+    for (int i = 0; i < 3; ++i)
+        EXPECT_FLOAT_EQ(w->data(0,0,i), expected_w[i]);
+    EXPECT_FLOAT_EQ(thr->data(0,0,0), expected_thr);
+}
+
+TEST(SolverTest, BatchOfIdenticalSamples) {
+
+    // two identical networks
+    nl::block_ptr b1 = std::make_shared<nl::Block>("b1", 1, 1, 2);
+    nl::block_ptr b2 = std::make_shared<nl::Block>("b2", 1, 1, 2);
+    nl::Dense l1("l1", "tanh", b1, 1, 1, 2);
+    nl::Dense l2("l2", "tanh", b2, 1, 1, 2);
+    l2.inputs()["l2_w"]->data = l1.inputs()["l1_w"]->data;
+    l2.inputs()["l2_thr"]->data = l1.inputs()["l1_thr"]->data;
+
+    nl::block_ptr d = std::make_shared<nl::Block>("d", 1, 1, 2);
+    d->data(0,0,0) = 0.3;
+    d->data(0,0,1) = -0.7;
+    b1->data(0,0,0) = b2->data(0,0,0) = 0.5;
+    b1->data(0,0,1) = b2->data(0,0,1) = -2;
+
+    nl::Net net1("net1");
+    net1.add(&l1);
+    nl::Net net2("net2");
+    net2.add(&l2);
+
+    // mean gradient of identical samples equals gradient of one of them
+    nl::Solver s1(net1, l1.outputs()["l1_out"], d);
+    nl::Solver s2(net2, l2.outputs()["l2_out"], d);
+    s2.setBatchSize(5);
+    s1.train(3);
+    s2.train(3);
+
+    for (int i = 0; i < 4; ++i)
+        EXPECT_NEAR(l1.inputs()["l1_w"]->data(0,0,i),
+                    l2.inputs()["l2_w"]->data(0,0,i), 1e-6);
+    for (int i = 0; i < 2; ++i)
+        EXPECT_NEAR(l1.inputs()["l1_thr"]->data(0,0,i),
+                    l2.inputs()["l2_thr"]->data(0,0,i), 1e-6);
+}
+
+TEST(SolverTest, HogwildOptions) {
+
+    nl::block_ptr b = std::make_shared<nl::Block>("b", 1, 1, 1);
+    nl::block_ptr d = std::make_shared<nl::Block>("d", 1, 1, 1);
+    nl::Dense l("l", "linear", b, 1, 1, 1);
+    nl::Net net("net");
+    net.add(&l);
+
+    nl::Solver solver(net, l.outputs()["l_out"], d);
+
+    EXPECT_THROW(solver.setHogwild(0), nl::InputException);
+
+    // momentum is not supported
+    solver.setHogwild(2);
+    EXPECT_THROW(solver.setMethod("nesterov"), nl::InputException);
+    solver.setHogwild(1);
+    solver.setMethod("nesterov");
+    EXPECT_THROW(solver.setHogwild(2), nl::InputException);
+}
+
+TEST(SolverTest, HogwildConvergence) {
+
+    // lines contain (x, y, z) where z == y, lines read by each
+    // thread determine the solution on their own
+    nl::CsvReader r("reader", "test/csv/linear.csv");
+    nl::Dense sep_input("input", "linear", r, 1, 1, 2);
+    nl::Dense sep_corr("correct", "linear", r, 1, 1, 1);
+
+    // separators only copy values
+    nl::block_ptr w = sep_input.inputs()["input_w"];
+    nl::block_ptr thr = sep_input.inputs()["input_thr"];
+    w->data.setZero();
+    thr->data.setZero();
+    w->trainable = thr->trainable = false;
+    w->data(0,0,0) = 1;
+    w->data(0,0,4) = 1;
+    w = sep_corr.inputs()["correct_w"];
+    thr = sep_corr.inputs()["correct_thr"];
+    w->data.setZero();
+    thr->data.setZero();
+    w->trainable = thr->trainable = false;
+    w->data(0,0,2) = 1;
+
+    nl::Dense l("l", "linear", sep_input, 1, 1, 1);
+
+    nl::Net net("net");
+    net.add(&r);
+    net.add(&sep_input);
+    net.add(&sep_corr);
+    net.add(&l);
+
+    nl::Solver solver(net, l.outputs()["l_out"],
+                      sep_corr.outputs()["correct_out"]);
+    solver.setHogwild(2);
+    solver.train(2000);
+
+    // solution is z = 0 * x + 1 * y + 0
+    EXPECT_NEAR(l.inputs()["l_w"]->data(0,0,0), 0, 0.05);
+    EXPECT_NEAR(l.inputs()["l_w"]->data(0,0,1), 1, 0.05);
+    EXPECT_NEAR(l.inputs()["l_thr"]->data(0,0,0), 0, 0.05);
+}
+
+#endif // NEURAL_LIB_SOLVER_TEST_H